@@ -12,6 +12,7 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include "common/exception.h"
 #include "common/macros.h"
 
 namespace bustub {
@@ -43,6 +44,14 @@ BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
+  if (prefetch_thread_.joinable()) {
+    {
+      std::scoped_lock prefetch_lock(prefetch_latch_);
+      stop_prefetch_ = true;
+    }
+    prefetch_cv_.notify_one();
+    prefetch_thread_.join();
+  }
   // 仅需析构未含unused标记的指针类型成员
   delete[] pages_;
   delete replacer_;
@@ -163,6 +172,75 @@ Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) {
   return page;
 }
 
+void BufferPoolManagerInstance::PrefetchPgImp(page_id_t page_id) {
+  {
+    std::scoped_lock prefetch_lock(prefetch_latch_);
+    if (prefetch_queue_.size() >= MAX_PREFETCH_QUEUE) {
+      return;
+    }
+    prefetch_queue_.push_back(page_id);
+    if (!prefetch_thread_.joinable()) {
+      prefetch_thread_ = std::thread(&BufferPoolManagerInstance::PrefetchLoop, this);
+    }
+  }
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManagerInstance::PrefetchLoop() {
+  std::unique_lock prefetch_lock(prefetch_latch_);
+  while (true) {
+    prefetch_cv_.wait(prefetch_lock, [this] { return stop_prefetch_ || !prefetch_queue_.empty(); });
+    if (stop_prefetch_) {
+      return;
+    }
+    page_id_t page_id = prefetch_queue_.front();
+    prefetch_queue_.pop_front();
+    prefetch_lock.unlock();
+    LoadPage(page_id);
+    prefetch_lock.lock();
+  }
+}
+
+void BufferPoolManagerInstance::LoadPage(page_id_t page_id) {
+  std::lock_guard<std::mutex> lock_guard(latch_);
+  if (page_table_.find(page_id) != page_table_.end()) {
+    return;
+  }
+
+  // a prefetch never waits for a frame, without a free or evictable one the hint is dropped
+  frame_id_t frame_id = -1;
+  Page *page = nullptr;
+  if (!free_list_.empty()) {
+    frame_id = free_list_.front();
+    free_list_.pop_front();
+    page = &pages_[frame_id];
+  } else if (replacer_->Victim(&frame_id)) {
+    page = &pages_[frame_id];
+    if (page->IsDirty()) {
+      disk_manager_->WritePage(page->GetPageId(), page->GetData());
+    }
+    page_table_.erase(page->GetPageId());
+  } else {
+    return;
+  }
+
+  // the page stays unpinned, so the replacer may evict it again before it is fetched
+  page->page_id_ = page_id;
+  page->pin_count_ = 0;
+  page->is_dirty_ = false;
+  try {
+    disk_manager_->ReadPage(page_id, page->GetData());
+  } catch (const Exception &) {
+    // leave the error to the FetchPage that needs the page, the prefetch thread has no one to report it to
+    page->page_id_ = INVALID_PAGE_ID;
+    page->ResetMemory();
+    free_list_.push_back(frame_id);
+    return;
+  }
+  page_table_[page_id] = frame_id;
+  replacer_->Unpin(frame_id);
+}
+
 bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) {
   std::lock_guard<std::mutex> lock_guard(latch_);
   // 0.   Make sure you call DeallocatePage!
@@ -51,6 +51,11 @@ bool ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) {
   return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
 }
 
+void ParallelBufferPoolManager::PrefetchPgImp(page_id_t page_id) {
+  // Read ahead in the responsible BufferPoolManagerInstance
+  GetBufferPoolManager(page_id)->PrefetchPage(page_id);
+}
+
 bool ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) {
   // Flush page_id from responsible BufferPoolManagerInstance
   return GetBufferPoolManager(page_id)->FlushPage(page_id);
@@ -23,7 +23,9 @@ std::string Column::ToString() const {
   os << "Column[" << column_name_ << ", " << Type::TypeIdToString(column_type_) << ", "
      << "Offset:" << column_offset_ << ", ";
 
-  if (IsInlined()) {
+  if (IsDictionaryEncoded()) {
+    os << "Dictionary, FixedLength:" << fixed_length_;
+  } else if (IsInlined()) {
     os << "FixedLength:" << fixed_length_;
   } else {
     os << "VarLength:" << variable_length_;
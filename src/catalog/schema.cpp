@@ -33,6 +33,8 @@ Schema::Schema(const std::vector<Column> &columns) : tuple_is_inlined_(true) {
 
     // add column
     this->columns_.push_back(column);
+    column_offsets_.push_back(column.GetOffset());
+    column_types_.push_back(column.GetType());
   }
   // set tuple length
   length_ = curr_offset;
@@ -10,7 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
+#include <numeric>
 #include <string>
 #include <utility>
 #include <vector>
@@ -26,7 +28,10 @@ namespace bustub {
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                      const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {}
+    : buffer_pool_manager_(buffer_pool_manager),
+      directory_(buffer_pool_manager),
+      comparator_(comparator),
+      hash_fn_(std::move(hash_fn)) {}
 
 /*****************************************************************************
  * HELPERS
@@ -44,44 +49,32 @@ uint32_t HASH_TABLE_TYPE::Hash(KeyType key) {
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-inline uint32_t HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page) {
-  return Hash(key) & dir_page->GetGlobalDepthMask();  // least-significant bits
+inline uint32_t HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirectory *dir) {
+  return Hash(key) & dir->GetGlobalDepthMask();  // least-significant bits
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-inline uint32_t HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page) {
-  return dir_page->GetBucketPageId(KeyToDirectoryIndex(key, dir_page));
+inline uint32_t HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectory *dir) {
+  return dir->GetBucketPageId(KeyToDirectoryIndex(key, dir));
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-HashTableDirectoryPage *HASH_TABLE_TYPE::FetchDirectoryPage() {
-  HashTableDirectoryPage *res;
-  // avoid concurrency to create repeated directory page.
-  mu_.lock();
-  if (directory_page_id_ == INVALID_PAGE_ID) {
-    // renew
-    LOG_DEBUG("create new directory, before %d", directory_page_id_);
-    page_id_t tmp_page_id;
-    res =
-        reinterpret_cast<HashTableDirectoryPage *>(AssertPage(buffer_pool_manager_->NewPage(&tmp_page_id))->GetData());
-    directory_page_id_ = tmp_page_id;
-    res->SetPageId(directory_page_id_);
-    assert(directory_page_id_ != INVALID_PAGE_ID);
-    LOG_DEBUG("create new directory %d", directory_page_id_);
-    // renew an initial bucket 0
-    page_id_t bucket_page_id = INVALID_PAGE_ID;
-    AssertPage(buffer_pool_manager_->NewPage(&bucket_page_id));
-    res->SetBucketPageId(0, bucket_page_id);
-    assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true));
-    assert(buffer_pool_manager_->UnpinPage(directory_page_id_, true));
+HashTableDirectory *HASH_TABLE_TYPE::FetchDirectory() {
+  if (!directory_created_.load(std::memory_order_acquire)) {
+    // avoid concurrency to create repeated directory page.
+    std::scoped_lock create(mu_);
+    if (!directory_created_.load(std::memory_order_relaxed)) {
+      // renew an initial bucket 0
+      page_id_t bucket_page_id = INVALID_PAGE_ID;
+      AssertPage(buffer_pool_manager_->NewPage(&bucket_page_id));
+      [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+      assert(unpinned);
+      directory_.Create(bucket_page_id);
+      directory_created_.store(true, std::memory_order_release);
+      LOG_DEBUG("create new directory %d", directory_.GetRoot()->GetPageId());
+    }
   }
-  mu_.unlock();
-
-  // re-fetch from buffer
-  assert(directory_page_id_ != INVALID_PAGE_ID);
-  res = reinterpret_cast<HashTableDirectoryPage *>(
-      AssertPage(buffer_pool_manager_->FetchPage(directory_page_id_))->GetData());
-  return res;
+  return &directory_;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -94,28 +87,133 @@ HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::RetrieveBucketPage(Page *page) {
   return reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+Page *HASH_TABLE_TYPE::FetchLatchedBucketPage(HashTableDirectory *dir, uint32_t hash, bool exclusive,
+                                              uint32_t *bucket_index) {
+  while (true) {
+    page_id_t bucket_page_id = dir->GetBucketPageIdOfHash(hash, bucket_index);
+    Page *page = FetchBucketPage(bucket_page_id);
+    if (exclusive) {
+      page->WLatch();
+    } else {
+      page->RLatch();
+    }
+    //! 分裂会在释放桶的写锁之前重新绑定directory, 因此拿到桶锁后若directory仍指向该桶, 则桶中的数据就是完整的
+    if (dir->GetBucketPageIdOfHash(hash, bucket_index) == bucket_page_id) {
+      return page;
+    }
+    if (exclusive) {
+      page->WUnlatch();
+    } else {
+      page->RUnlatch();
+    }
+    [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    assert(unpinned);
+  }
+}
+
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
-  Page *bucket_page = FetchBucketPage(bucket_page_id);
+  HashTableDirectory *dir = FetchDirectory();
+  uint32_t bucket_index;
+  Page *bucket_page = FetchLatchedBucketPage(dir, Hash(key), false, &bucket_index);
 
-  bucket_page->RLatch();
   HASH_TABLE_BUCKET_TYPE *bucket = RetrieveBucketPage(bucket_page);
   bool res = bucket->GetValue(key, comparator_, result);
   bucket_page->RUnlatch();
 
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, false));
-  assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false));
+  [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(bucket_page->GetPageId(), false);
+  assert(unpinned);
 
   table_latch_.RUnlock();
   return res;
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::GetValues(Transaction *transaction, const std::vector<KeyType> &keys,
+                                std::vector<std::vector<ValueType>> *results) {
+  results->clear();
+  results->resize(keys.size());
+  if (keys.empty()) {
+    return false;
+  }
+  std::vector<uint32_t> hashes(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    hashes[i] = Hash(keys[i]);
+  }
+
+  table_latch_.RLock();
+  HashTableDirectory *dir = FetchDirectory();
+
+  //! 按directory下标排序, 使同一个directory page上的slot连续读取
+  uint32_t mask = dir->GetGlobalDepthMask();
+  std::vector<uint32_t> order(keys.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&](uint32_t a, uint32_t b) { return (hashes[a] & mask) < (hashes[b] & mask); });
+  std::vector<uint32_t> sorted_hashes(keys.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    sorted_hashes[i] = hashes[order[i]];
+  }
+  std::vector<page_id_t> page_ids;
+  dir->GetBucketPageIds(sorted_hashes, &page_ids);
+
+  //! 再按bucket page分组, 每个桶只fetch和加锁一次, 探测当前桶时提前fetch下一个桶
+  std::vector<uint32_t> probes(keys.size());
+  std::iota(probes.begin(), probes.end(), 0);
+  std::stable_sort(probes.begin(), probes.end(), [&](uint32_t a, uint32_t b) { return page_ids[a] < page_ids[b]; });
+  Page *next_page = FetchBucketPage(page_ids[probes[0]]);
+  for (size_t begin = 0, end = 0; begin < probes.size(); begin = end) {
+    Page *page = next_page;
+    while (end < probes.size() && page_ids[probes[end]] == page->GetPageId()) {
+      end++;
+    }
+    next_page = nullptr;
+    if (end < probes.size()) {
+      next_page = FetchBucketPage(page_ids[probes[end]]);
+      // the probe reads the occupied/readable bits and the fingerprints first, pull them into the cache
+      const size_t probe_bytes = 2 * ((BUCKET_ARRAY_SIZE - 1) / 8 + 1) + BUCKET_ARRAY_SIZE;
+      for (size_t offset = 0; offset < probe_bytes; offset += 64) {
+        __builtin_prefetch(next_page->GetData() + offset);
+      }
+    }
+    page->RLatch();
+    HASH_TABLE_BUCKET_TYPE *bucket = RetrieveBucketPage(page);
+    for (size_t i = begin; i < end; i++) {
+      uint32_t k = order[probes[i]];
+      bucket->GetValue(keys[k], comparator_, &(*results)[k]);
+    }
+    page->RUnlatch();
+    [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    assert(unpinned);
+  }
+
+  //! 一个slot一旦被分裂重新绑定到别的桶, 在持有table_latch_读锁期间就不会再绑定回来
+  //! 因此最后仍指向原桶的key, 在探测时也指向原桶, 结果是完整的; 其余的key单独重新查找
+  std::vector<page_id_t> current_page_ids;
+  dir->GetBucketPageIds(sorted_hashes, &current_page_ids);
+  for (size_t i = 0; i < order.size(); i++) {
+    if (current_page_ids[i] == page_ids[i]) {
+      continue;
+    }
+    uint32_t k = order[i];
+    uint32_t bucket_index;
+    Page *page = FetchLatchedBucketPage(dir, hashes[k], false, &bucket_index);
+    (*results)[k].clear();
+    RetrieveBucketPage(page)->GetValue(keys[k], comparator_, &(*results)[k]);
+    page->RUnlatch();
+    [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    assert(unpinned);
+  }
+  table_latch_.RUnlock();
+
+  return std::any_of(results->begin(), results->end(), [](const auto &result) { return !result.empty(); });
+}
+
 /*****************************************************************************
  * INSERTION
  * 当写入时仅需为dictionary加入读锁，为插入的目标bucket加入写锁
@@ -123,26 +221,25 @@ bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
-  Page *page = FetchBucketPage(bucket_page_id);
-  page->WLatch();
+  HashTableDirectory *dir = FetchDirectory();
+  uint32_t bucket_index;
+  Page *page = FetchLatchedBucketPage(dir, Hash(key), true, &bucket_index);
 
   HASH_TABLE_BUCKET_TYPE *bucket = RetrieveBucketPage(page);
   if (!bucket->IsFull()) {
     // not full, insert it directly.
     bool res = bucket->Insert(key, value, comparator_);
     page->WUnlatch();
-    assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true));
-    assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false));
+    [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+    assert(unpinned);
     table_latch_.RUnlock();
     return res;
   }
 
   // do SplitInsert
   page->WUnlatch();
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, false));
-  assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false));
+  [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  assert(unpinned);
   table_latch_.RUnlock();
   return SplitInsert(transaction, key, value);
 }
@@ -155,6 +252,7 @@ bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const
  *          对于所有桶，基于本桶当前的前缀xxx，生成一个1xxx前缀，将这个1xxx在directory中链接到本桶
  *          在扩容时其实并非所有桶都是需要增加depth的，真正需要增加depth的只有本轮需要分裂的那个桶
  *          但新增的绑定1xxx的编号并不会影响对这个无需扩容的桶的索引，无论是hash(key)值低位为1xxx还是0xxx的，都会索引到这个还无需扩容的桶上
+ *        扩容只写入directory新的一半并在最后才发布新的global depth, 因此不阻塞读者
  *    找到需要扩容的bucket page(称为桶A)，进行扩容操作:
  *        - 假设桶A前缀为xxx, 新建一个前缀为1xxx的bucket page(称为桶B)
  *        - 将桶A的local depth++，相当于此时桶A的前缀变为了0xxx
@@ -165,101 +263,186 @@ bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const
  *
  *        - 基于上面的情况，我们需要额外增加一个操作，就是在A[00] B[10]桶创建完成后，额外的将所有dir_page中的以
  *        00和10为前缀的编号分别链接到A B桶上
+ *
+ * 整个分裂只持有table_latch_读锁: 桶A的写锁保护A的数据和local depth, directory_latch_串行化所有directory的修改,
+ * 桶B在绑定到directory之前对其他线程不可见. 加锁顺序为 桶A -> directory_latch_, directory的读者不加锁, 靠版本号重试.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  table_latch_.WLock();
+  uint32_t hash = Hash(key);
+  table_latch_.RLock();
+  HashTableDirectory *dir = FetchDirectory();
+  while (true) {
+    uint32_t split_bucket_index;
+    Page *split_page = FetchLatchedBucketPage(dir, hash, true, &split_bucket_index);
+    page_id_t split_bucket_page_id = split_page->GetPageId();
+    HASH_TABLE_BUCKET_TYPE *split_bucket = RetrieveBucketPage(split_page);
+    if (!split_bucket->IsFull()) {
+      // another split made room in between
+      bool res = split_bucket->Insert(key, value, comparator_);
+      split_page->WUnlatch();
+      [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(split_bucket_page_id, true);
+      assert(unpinned);
+      table_latch_.RUnlock();
+      return res;
+    }
 
-  // 找到需要扩容的bucket page
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  int64_t split_bucket_index = KeyToDirectoryIndex(key, dir_page);
-  uint32_t split_bucket_depth = dir_page->GetLocalDepth(split_bucket_index);
+    //! 第一步: 如有必要先扩容directory, 期间读者不受影响
+    // The local depth of A only changes under A's write latch, which we hold.
+    uint32_t split_bucket_depth = dir->GetLocalDepth(split_bucket_index);
+    std::unique_lock directory_guard(directory_latch_);
+    if (split_bucket_depth == dir->GetGlobalDepth() && !dir->IncrGlobalDepth()) {
+      // can't split
+      directory_guard.unlock();
+      split_page->WUnlatch();
+      [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(split_bucket_page_id, false);
+      assert(unpinned);
+      table_latch_.RUnlock();
+      return false;
+    }
+    directory_guard.unlock();
+
+    //! 第二步: 分裂桶A, 桶B绑定之前其他线程看不到它
+    page_id_t image_bucket_page;
+    HASH_TABLE_BUCKET_TYPE *image_bucket =
+        RetrieveBucketPage(AssertPage(buffer_pool_manager_->NewPage(&image_bucket_page)));
+
+    //! 一趟遍历将前缀为1xxx的kv对移动到B桶: 每个key只hash一次, 不分配内存, 也不重新查重
+    //! A桶留下的空洞由之后的插入复用, B桶是新页, 从0开始紧凑地写入
+    uint32_t image_size = 0;
+    for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
+      if (split_bucket->IsReadable(i) && (Hash(split_bucket->KeyAt(i)) & (1U << split_bucket_depth)) != 0) {
+        split_bucket->MoveAt(i, image_bucket, image_size++);
+      }
+    }
 
-  if (split_bucket_depth >= 9) {
-    // can't split
-    assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false));
-    table_latch_.WUnlock();
-    return false;
+    //! 绑定所有以0xxx为前缀的编号到0xxx桶-[A桶], 所有以1xxx为前缀的编号到1xxx桶-[B桶]
+    //! 必须在释放A的写锁之前完成, 等待A的读者拿到锁后会发现directory已经改变并重试
+    uint32_t new_depth = split_bucket_depth + 1;
+    uint32_t split_first = hash & ((1U << split_bucket_depth) - 1);
+    uint32_t image_first = split_first | (1U << split_bucket_depth);
+    directory_guard.lock();
+    dir->Bind(split_first, 1U << new_depth, split_bucket_page_id, new_depth);
+    dir->Bind(image_first, 1U << new_depth, image_bucket_page, new_depth);
+    directory_guard.unlock();
+
+    // release and re-insert original k-v
+    split_page->WUnlatch();
+    [[maybe_unused]] bool split_unpinned = buffer_pool_manager_->UnpinPage(split_bucket_page_id, true);
+    assert(split_unpinned);
+    [[maybe_unused]] bool image_unpinned = buffer_pool_manager_->UnpinPage(image_bucket_page, true);
+    assert(image_unpinned);
   }
+}
 
-  //! 如果插入的页的local_depth已经等于global_depth ==> growth
-  if (split_bucket_depth == dir_page->GetGlobalDepth()) {
-    dir_page->IncrGlobalDepth();
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+namespace {
+// Radix sort digit width, two passes cover DIRECTORY_MAX_DEPTH bits
+constexpr uint32_t BULK_LOAD_RADIX_BITS = 10;
+
+// @return the low DIRECTORY_MAX_DEPTH bits of hash in reverse order. Ordering by it puts the hashes that agree on
+// their low d bits next to each other, for every d at once.
+inline uint32_t ReverseLowBits(uint32_t hash) {
+  uint32_t reversed = 0;
+  for (uint32_t i = 0; i < DIRECTORY_MAX_DEPTH; i++) {
+    reversed = (reversed << 1) | ((hash >> i) & 1);
   }
+  return reversed;
+}
 
-  page_id_t split_bucket_page_id = KeyToPageId(key, dir_page);
-  Page *split_page = FetchBucketPage(split_bucket_page_id);
-  split_page->WLatch();
-  HASH_TABLE_BUCKET_TYPE *split_bucket = RetrieveBucketPage(split_page);
-  MappingType *origin_array = split_bucket->GetArrayCopy();
-  uint32_t origin_array_size = split_bucket->NumReadable();
-  split_bucket->Clear();  // 将分裂前的桶清空
-
-  page_id_t image_bucket_page;
-  HASH_TABLE_BUCKET_TYPE *image_bucket =
-      RetrieveBucketPage(AssertPage(buffer_pool_manager_->NewPage(&image_bucket_page)));
-
-  // inr local depth before get split image
-  dir_page->IncrLocalDepth(split_bucket_index);
-  uint32_t split_image_bucket_index = dir_page->GetSplitImageIndex(split_bucket_index);  // 1xxx
-  dir_page->SetLocalDepth(split_image_bucket_index, dir_page->GetLocalDepth(split_bucket_index));
-
-  // 绑定注册新的B桶
-  dir_page->SetBucketPageId(split_image_bucket_index, image_bucket_page);
-
-  //! 绑定所有以0xxx为前缀的编号到0xxx桶-[A桶]
-  uint32_t diff = 1 << dir_page->GetLocalDepth(split_bucket_index);
-  for (uint32_t i = split_bucket_index; i >= 0; i -= diff) {
-    dir_page->SetBucketPageId(i, split_bucket_page_id);
-    dir_page->SetLocalDepth(i, dir_page->GetLocalDepth(split_bucket_index));
-    if (i < diff) {
-      // avoid negative
-      break;
-    }
+// A run of sorted pairs that shares the low depth bits of the hash, prefix.
+struct BulkLoadRun {
+  size_t begin_;
+  size_t end_;
+  uint32_t prefix_;
+  uint32_t depth_;
+};
+}  // namespace
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::BulkLoad(Transaction *transaction, const std::vector<KeyType> &keys,
+                               const std::vector<ValueType> &values) {
+  assert(keys.size() == values.size());
+  if (keys.empty()) {
+    return true;
   }
-  for (uint32_t i = split_bucket_index; i < dir_page->Size(); i += diff) {
-    dir_page->SetBucketPageId(i, split_bucket_page_id);
-    dir_page->SetLocalDepth(i, dir_page->GetLocalDepth(split_bucket_index));
+
+  //! 每个key只hash一次, 按反转后的低位做基数排序: entries的高32位是排序键, 低32位是key的下标
+  std::vector<uint64_t> entries(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    entries[i] = (static_cast<uint64_t>(ReverseLowBits(Hash(keys[i]))) << 32) | i;
   }
-  //! 绑定所有以1xxx为前缀的编号到1xxx桶-[B桶]
-  for (uint32_t i = split_image_bucket_index; i >= 0; i -= diff) {
-    dir_page->SetBucketPageId(i, image_bucket_page);
-    dir_page->SetLocalDepth(i, dir_page->GetLocalDepth(split_bucket_index));
-    if (i < diff) {
-      // avoid negative
-      break;
+  std::vector<uint64_t> scratch(entries.size());
+  for (uint32_t shift = 0; shift < DIRECTORY_MAX_DEPTH; shift += BULK_LOAD_RADIX_BITS) {
+    std::vector<size_t> offsets((1U << BULK_LOAD_RADIX_BITS) + 1, 0);
+    for (uint64_t entry : entries) {
+      offsets[((entry >> (32 + shift)) & ((1U << BULK_LOAD_RADIX_BITS) - 1)) + 1]++;
     }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    for (uint64_t entry : entries) {
+      scratch[offsets[(entry >> (32 + shift)) & ((1U << BULK_LOAD_RADIX_BITS) - 1)]++] = entry;
+    }
+    entries.swap(scratch);
   }
-  for (uint32_t i = split_image_bucket_index; i < dir_page->Size(); i += diff) {
-    dir_page->SetBucketPageId(i, image_bucket_page);
-    dir_page->SetLocalDepth(i, dir_page->GetLocalDepth(split_bucket_index));
+  scratch = std::vector<uint64_t>();
+
+  //! 从深度0开始, 一段放不进一个桶就按下一位拆成两段, 直到每段都放得下, 最深的一段决定global depth
+  //! 段内下一位为0的排在前面, 因此拆分点可以二分查找
+  std::vector<BulkLoadRun> runs;
+  std::vector<BulkLoadRun> pending{{0, entries.size(), 0, 0}};
+  uint32_t global_depth = 0;
+  bool fits = true;
+  while (!pending.empty() && fits) {
+    BulkLoadRun run = pending.back();
+    pending.pop_back();
+    if (run.end_ - run.begin_ <= BUCKET_ARRAY_SIZE) {
+      global_depth = std::max(global_depth, run.depth_);
+      runs.push_back(run);
+      continue;
+    }
+    if (run.depth_ == DIRECTORY_MAX_DEPTH) {
+      // too many equal hashes, Insert fails on them as well
+      fits = false;
+      continue;
+    }
+    uint32_t bit = DIRECTORY_MAX_DEPTH - 1 - run.depth_;
+    auto mid = std::partition_point(entries.begin() + run.begin_, entries.begin() + run.end_,
+                                    [bit](uint64_t entry) { return ((entry >> (32 + bit)) & 1) == 0; });
+    size_t mid_index = mid - entries.begin();
+    pending.push_back({run.begin_, mid_index, run.prefix_, run.depth_ + 1});
+    pending.push_back({mid_index, run.end_, run.prefix_ | (1U << run.depth_), run.depth_ + 1});
   }
 
-  //! 将原先的数据分发到A B桶中
-  uint32_t mask = dir_page->GetLocalDepthMask(split_bucket_index);
-  for (uint32_t i = 0; i < origin_array_size; i++) {
-    MappingType tmp = origin_array[i];
-    uint32_t target_bucket_index = Hash(tmp.first) & mask;
-    page_id_t target_bucket_index_page = dir_page->GetBucketPageId(target_bucket_index);
-    assert(target_bucket_index_page == split_bucket_page_id || target_bucket_index_page == image_bucket_page);
-    if (target_bucket_index_page == split_bucket_page_id) {
-      assert(split_bucket->Insert(tmp.first, tmp.second, comparator_));
-    } else {
-      assert(image_bucket->Insert(tmp.first, tmp.second, comparator_));
+  table_latch_.WLock();
+  if (!fits || directory_created_.load(std::memory_order_relaxed)) {
+    table_latch_.WUnlock();
+    bool res = true;
+    for (size_t i = 0; i < keys.size(); i++) {
+      res = Insert(transaction, keys[i], values[i]) && res;
+    }
+    return res;
+  }
+
+  //! 每个桶页只写一次, directory一开始就是最终的global depth, 不会发生分裂和扩容
+  std::vector<page_id_t> bucket_page_ids(runs.size());
+  for (size_t r = 0; r < runs.size(); r++) {
+    HASH_TABLE_BUCKET_TYPE *bucket = RetrieveBucketPage(AssertPage(buffer_pool_manager_->NewPage(&bucket_page_ids[r])));
+    for (size_t i = runs[r].begin_; i < runs[r].end_; i++) {
+      uint32_t k = static_cast<uint32_t>(entries[i]);
+      bucket->InsertAt(i - runs[r].begin_, keys[k], values[k]);
     }
+    [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(bucket_page_ids[r], true);
+    assert(unpinned);
+  }
+  directory_.Create(bucket_page_ids[0], global_depth);
+  for (size_t r = 0; r < runs.size(); r++) {
+    directory_.Bind(runs[r].prefix_, 1U << runs[r].depth_, bucket_page_ids[r], runs[r].depth_);
   }
-  // release
-  delete[] origin_array;
-  split_page->WUnlatch();
-  assert(buffer_pool_manager_->UnpinPage(split_bucket_page_id, true));
-  assert(buffer_pool_manager_->UnpinPage(image_bucket_page, true));
-
-  //  dir_page->PrintDirectory();
-  assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), true));
-  table_latch_.WUnlock();  // 需要先释放写锁再Insert以免出现死锁
-
-  // re-insert original k-v
-  return Insert(transaction, key, value);
+  directory_created_.store(true, std::memory_order_release);
+  table_latch_.WUnlock();
+  return true;
 }
 
 /*****************************************************************************
@@ -269,26 +452,26 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
   table_latch_.RLock();
 
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
-  uint32_t bucket_index = KeyToDirectoryIndex(key, dir_page);
-  Page *page = FetchBucketPage(bucket_page_id);
-  page->WLatch();
+  HashTableDirectory *dir = FetchDirectory();
+  uint32_t bucket_index;
+  Page *page = FetchLatchedBucketPage(dir, Hash(key), true, &bucket_index);
+  page_id_t bucket_page_id = page->GetPageId();
   HASH_TABLE_BUCKET_TYPE *bucket = RetrieveBucketPage(page);
   bool res = bucket->Remove(key, value, comparator_);
-  //! 当一个bucket为空时才进行合并
-  if (bucket->IsEmpty()) {
+  //! 当bucket被删空, 或者刚好被删到1/4满时尝试合并, 只在越过阈值的那一次触发, 以免每次删除都去抢table_latch_写锁
+  uint32_t num_readable = bucket->NumReadable();
+  if (num_readable == 0 || (res && num_readable == BUCKET_ARRAY_SIZE / 4)) {
     // go merge
     page->WUnlatch();
-    assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true));
-    assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false));
+    [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+    assert(unpinned);
     table_latch_.RUnlock();
     Merge(transaction, bucket_index);
     return res;
   }
   page->WUnlatch();
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true));
-  assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false));
+  [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(bucket_page_id, res);
+  assert(unpinned);
   table_latch_.RUnlock();
   return res;
 }
@@ -297,77 +480,137 @@ bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const
  * MERGE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Merge(Transaction *transaction, uint32_t target_bucket_index) {
-  table_latch_.WLock();
-
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  if (target_bucket_index >= dir_page->Size()) {
-    // used to check to auto merge
-    table_latch_.WUnlock();
-    return;
+bool HASH_TABLE_TYPE::MergeBucket(HashTableDirectory *dir, uint32_t *bucket_index) {
+  uint32_t target_bucket_index = *bucket_index;
+  if (target_bucket_index >= dir->Size()) {
+    // the directory shrank since the index was taken
+    return false;
   }
 
-  page_id_t target_bucket_page_id = dir_page->GetBucketPageId(target_bucket_index);
-  //! 对于0xxx, 返回1xxx, 对于1xxx, 返回0xxx, 即和本page合并的对象
-  uint32_t image_bucket_index = dir_page->GetSplitImageIndex(target_bucket_index);
-
   //! review something to find whether can execute merge
-  uint32_t local_depth = dir_page->GetLocalDepth(target_bucket_index);
+  uint32_t local_depth = dir->GetLocalDepth(target_bucket_index);
   if (local_depth == 0) {
     // can't merge because of depth is 0
-    assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false));
-    table_latch_.WUnlock();
-    return;
+    return false;
   }
 
+  //! 对于0xxx, 返回1xxx, 对于1xxx, 返回0xxx, 即和本page合并的对象
+  uint32_t image_bucket_index = dir->GetSplitImageIndex(target_bucket_index);
   // check the same local depth with split image
-  if (local_depth != dir_page->GetLocalDepth(image_bucket_index)) {
-    assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false));
-    table_latch_.WUnlock();
-    return;
+  if (local_depth != dir->GetLocalDepth(image_bucket_index)) {
+    return false;
   }
 
-  // check empty target bucket index
-  Page *target_page = FetchBucketPage(target_bucket_page_id);
-  target_page->RLatch();
-  HASH_TABLE_BUCKET_TYPE *target_bucket = RetrieveBucketPage(target_page);
-  if (!target_bucket->IsEmpty()) {
-    // bucket is not empty
-    target_page->RUnlatch();
-    assert(buffer_pool_manager_->UnpinPage(target_bucket_page_id, false));
-    assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), false));
-    table_latch_.WUnlock();
-    return;
+  page_id_t target_bucket_page_id = dir->GetBucketPageId(target_bucket_index);
+  page_id_t image_bucket_page_id = dir->GetBucketPageId(image_bucket_index);
+  HASH_TABLE_BUCKET_TYPE *target_bucket = RetrieveBucketPage(FetchBucketPage(target_bucket_page_id));
+  HASH_TABLE_BUCKET_TYPE *image_bucket = RetrieveBucketPage(FetchBucketPage(image_bucket_page_id));
+  uint32_t target_size = target_bucket->NumReadable();
+  uint32_t image_size = image_bucket->NumReadable();
+  if (target_size != 0 && image_size != 0 && target_size + image_size > BUCKET_ARRAY_SIZE / 2) {
+    // merged bucket would be too full, an empty bucket is always folded into its image
+    [[maybe_unused]] bool target_unpinned = buffer_pool_manager_->UnpinPage(target_bucket_page_id, false);
+    assert(target_unpinned);
+    [[maybe_unused]] bool image_unpinned = buffer_pool_manager_->UnpinPage(image_bucket_page_id, false);
+    assert(image_unpinned);
+    return false;
   }
   //! review something end
 
-  // 删除目标
-  target_page->RUnlatch();
-  assert(buffer_pool_manager_->UnpinPage(target_bucket_page_id, false));
-  assert(buffer_pool_manager_->DeletePage(target_bucket_page_id));
-
-  page_id_t image_bucket_page_id = dir_page->GetBucketPageId(image_bucket_index);
-  //! 将被删除的bucket index和合并目标桶绑定
-  dir_page->SetBucketPageId(target_bucket_index, image_bucket_page_id);
-  dir_page->DecrLocalDepth(target_bucket_index);
-  dir_page->DecrLocalDepth(image_bucket_index);
-  assert(dir_page->GetLocalDepth(target_bucket_index) == dir_page->GetLocalDepth(image_bucket_index));
-
-  //! 如果被删除的桶和合并的目标桶还有其他额外链接index，将它们链接到合并后的目标桶，并更新它们的index
-  for (uint32_t i = 0; i < dir_page->Size(); i++) {
-    if (dir_page->GetBucketPageId(i) == target_bucket_page_id || dir_page->GetBucketPageId(i) == image_bucket_page_id) {
-      dir_page->SetBucketPageId(i, image_bucket_page_id);
-      dir_page->SetLocalDepth(i, dir_page->GetLocalDepth(target_bucket_index));
-    }
+  //! 保留较满的桶, 把另一个桶的kv对搬过去后删除它
+  if (target_size > image_size) {
+    std::swap(target_bucket, image_bucket);
+    std::swap(target_bucket_page_id, image_bucket_page_id);
+  }
+  image_bucket->MergeFrom(target_bucket);
+  [[maybe_unused]] bool target_unpinned = buffer_pool_manager_->UnpinPage(target_bucket_page_id, false);
+  assert(target_unpinned);
+  [[maybe_unused]] bool image_unpinned = buffer_pool_manager_->UnpinPage(image_bucket_page_id, true);
+  assert(image_unpinned);
+  [[maybe_unused]] bool deleted = buffer_pool_manager_->DeletePage(target_bucket_page_id);
+  assert(deleted);
+
+  //! 将被删除的bucket和合并目标桶的所有index链接到合并后的目标桶，并更新它们的local depth
+  uint32_t new_depth = local_depth - 1;
+  *bucket_index = target_bucket_index & ((1U << new_depth) - 1);
+  dir->Bind(*bucket_index, 1U << new_depth, image_bucket_page_id, new_depth);
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::Merge(Transaction *transaction, uint32_t target_bucket_index) {
+  table_latch_.WLock();
+  HashTableDirectory *dir = FetchDirectory();
+  //! 合并后的桶可能还能和它的split image继续合并
+  bool merged = false;
+  while (MergeBucket(dir, &target_bucket_index)) {
+    merged = true;
   }
 
   // 如果所有的local_depth都小于global即可收缩全局深度
-  while (dir_page->CanShrink()) {
-    dir_page->DecrGlobalDepth();
+  while (merged && dir->CanShrink()) {
+    dir->DecrGlobalDepth();
+  }
+  table_latch_.WUnlock();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t HASH_TABLE_TYPE::Compact(Transaction *transaction) {
+  table_latch_.WLock();
+  HashTableDirectory *dir = FetchDirectory();
+  uint32_t num_freed = 0;
+  for (uint32_t bucket_index = 0; bucket_index < dir->Size(); bucket_index++) {
+    uint32_t merged_index = bucket_index;
+    while (MergeBucket(dir, &merged_index)) {
+      num_freed++;
+    }
+  }
+  while (dir->CanShrink()) {
+    dir->DecrGlobalDepth();
   }
-  // unpin
-  assert(buffer_pool_manager_->UnpinPage(dir_page->GetPageId(), true));
   table_latch_.WUnlock();
+  return num_freed;
+}
+
+/*****************************************************************************
+ * STATISTICS
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+ExtendibleHashTableStats HASH_TABLE_TYPE::GetStats(Transaction *transaction) {
+  table_latch_.RLock();
+  HashTableDirectory *dir = FetchDirectory();
+  ExtendibleHashTableStats stats;
+  stats.bucket_capacity_ = BUCKET_ARRAY_SIZE;
+  stats.global_depth_ = dir->GetGlobalDepth();
+  stats.fill_histogram_.resize(ExtendibleHashTableStats::NUM_FILL_BINS);
+  stats.local_depth_histogram_.resize(stats.global_depth_ + 1);
+  for (uint32_t bucket_index = 0; bucket_index < dir->Size(); bucket_index++) {
+    if (!dir->IsFirstIndexOfBucket(bucket_index)) {
+      continue;
+    }
+    uint32_t local_depth = dir->GetLocalDepth(bucket_index);
+    Page *page = FetchBucketPage(dir->GetBucketPageId(bucket_index));
+    page->RLatch();
+    uint32_t size = RetrieveBucketPage(page)->NumReadable();
+    page->RUnlatch();
+    [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    assert(unpinned);
+
+    stats.num_entries_ += size;
+    stats.num_buckets_++;
+    uint32_t bin = size * ExtendibleHashTableStats::NUM_FILL_BINS / BUCKET_ARRAY_SIZE;
+    stats.fill_histogram_[std::min(bin, ExtendibleHashTableStats::NUM_FILL_BINS - 1)]++;
+    // a concurrent split may have deepened the bucket after the global depth was read
+    stats.local_depth_histogram_[std::min(local_depth, stats.global_depth_)]++;
+    if (size == BUCKET_ARRAY_SIZE) {
+      stats.num_full_buckets_++;
+      if (local_depth == DIRECTORY_MAX_DEPTH) {
+        stats.num_overflowing_buckets_++;
+      }
+    }
+  }
+  table_latch_.RUnlock();
+  return stats;
 }
 
 /*****************************************************************************
@@ -376,9 +619,7 @@ void HASH_TABLE_TYPE::Merge(Transaction *transaction, uint32_t target_bucket_ind
 template <typename KeyType, typename ValueType, typename KeyComparator>
 uint32_t HASH_TABLE_TYPE::GetGlobalDepth() {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  uint32_t global_depth = dir_page->GetGlobalDepth();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  uint32_t global_depth = FetchDirectory()->GetGlobalDepth();
   table_latch_.RUnlock();
   return global_depth;
 }
@@ -389,9 +630,7 @@ uint32_t HASH_TABLE_TYPE::GetGlobalDepth() {
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::VerifyIntegrity() {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  dir_page->VerifyIntegrity();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  FetchDirectory()->VerifyIntegrity();
   table_latch_.RUnlock();
 }
 
@@ -0,0 +1,76 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table_iterator.cpp
+//
+// Identification: src/container/hash/extendible_hash_table_iterator.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "container/hash/extendible_hash_table_iterator.h"
+
+#include <cassert>
+
+#include "common/rid.h"
+#include "container/hash/extendible_hash_table.h"
+
+namespace bustub {
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HASH_TABLE_ITERATOR_TYPE::ExtendibleHashTableIterator(ExtendibleHashTable<KeyType, ValueType, KeyComparator> *table)
+    : table_(table), dir_(table->FetchDirectory()) {
+  items_.reserve(BUCKET_ARRAY_SIZE);
+  SeekBucket(0);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HASH_TABLE_ITERATOR_TYPE::~ExtendibleHashTableIterator() = default;
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HASH_TABLE_ITERATOR_TYPE &HASH_TABLE_ITERATOR_TYPE::operator++() {
+  assert(!IsEnd());
+  if (++item_index_ == items_.size()) {
+    SeekBucket(bucket_index_ + 1);
+  }
+  return *this;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_ITERATOR_TYPE::SeekBucket(uint32_t bucket_idx) {
+  items_.clear();
+  item_index_ = 0;
+  //! 每一步都重新加table_latch_读锁并读directory, 两步之间桶可能已经分裂或合并, 所以只保证弱一致
+  table_->table_latch_.RLock();
+  for (; bucket_idx < dir_->Size() && items_.empty(); bucket_idx++) {
+    //! 一个local depth为d的桶被2^(GD-d)个slot指向, 只在其中最小的那个(下标小于2^d)上访问它
+    if (!dir_->IsFirstIndexOfBucket(bucket_idx)) {
+      continue;
+    }
+    Page *page = table_->FetchBucketPage(dir_->GetBucketPageId(bucket_idx));
+    page->RLatch();
+    HASH_TABLE_BUCKET_TYPE *bucket = table_->RetrieveBucketPage(page);
+    for (uint32_t slot = 0; slot < BUCKET_ARRAY_SIZE; slot++) {
+      if (bucket->IsReadable(slot)) {
+        items_.emplace_back(bucket->KeyAt(slot), bucket->ValueAt(slot));
+      }
+    }
+    page->RUnlatch();
+    [[maybe_unused]] bool unpinned = table_->buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    assert(unpinned);
+    bucket_index_ = bucket_idx;
+  }
+  table_->table_latch_.RUnlock();
+}
+
+template class ExtendibleHashTableIterator<int, int, IntComparator>;
+
+template class ExtendibleHashTableIterator<GenericKey<4>, RID, GenericComparator<4>>;
+template class ExtendibleHashTableIterator<GenericKey<8>, RID, GenericComparator<8>>;
+template class ExtendibleHashTableIterator<GenericKey<16>, RID, GenericComparator<16>>;
+template class ExtendibleHashTableIterator<GenericKey<32>, RID, GenericComparator<32>>;
+template class ExtendibleHashTableIterator<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
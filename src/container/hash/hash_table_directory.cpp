@@ -0,0 +1,341 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_directory.cpp
+//
+// Identification: src/container/hash/hash_table_directory.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "container/hash/hash_table_directory.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <thread>  // NOLINT
+#include <unordered_map>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+// The directory page and the index within it of a directory slot.
+inline uint32_t DirectoryPageIndex(uint32_t bucket_idx) { return bucket_idx >> DIRECTORY_PAGE_DEPTH; }
+inline uint32_t SlotIndex(uint32_t bucket_idx) { return bucket_idx & (DIRECTORY_ARRAY_SIZE - 1); }
+}  // namespace
+
+HashTableDirectory::~HashTableDirectory() {
+  if (root_ == nullptr) {
+    return;
+  }
+  // the root was marked dirty when it was written, give its frame back to the buffer pool
+  buffer_pool_manager_->UnpinPage(root_->GetPageId(), false);
+}
+
+void HashTableDirectory::Create(page_id_t bucket_page_id, uint32_t global_depth) {
+  assert(root_ == nullptr && global_depth <= DIRECTORY_MAX_DEPTH);
+  page_id_t root_page_id = INVALID_PAGE_ID;
+  Page *root_page = buffer_pool_manager_->NewPage(&root_page_id);
+  if (root_page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "out of memory");
+  }
+  root_ = reinterpret_cast<HashTableRootDirectoryPage *>(root_page->GetData());
+  root_->SetPageId(root_page_id);
+  root_->SetGlobalDepth(global_depth);
+
+  // one directory page at a time, a bulk built directory does not take a frame per page
+  for (uint32_t i = 0; i < root_->NumDirectoryPages(); i++) {
+    HashTableDirectoryPage *directory_page = NewDirectoryPage(i);
+    for (uint32_t slot = 0; slot < DIRECTORY_ARRAY_SIZE; slot++) {
+      directory_page->SetBucketPageId(slot, bucket_page_id);
+      directory_page->SetLocalDepth(slot, 0);
+    }
+    UnpinDirectoryPage(directory_page, true);
+  }
+  MarkRootDirty();
+}
+
+HashTableDirectoryPage *HashTableDirectory::FetchDirectoryPage(uint32_t directory_idx) const {
+  Page *page = buffer_pool_manager_->FetchPage(directory_page_ids_[directory_idx]);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "out of memory");
+  }
+  return reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
+}
+
+void HashTableDirectory::UnpinDirectoryPage(HashTableDirectoryPage *directory_page, bool is_dirty) const {
+  [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(directory_page->GetPageId(), is_dirty);
+  assert(unpinned);
+}
+
+HashTableDirectoryPage *HashTableDirectory::NewDirectoryPage(uint32_t directory_idx) {
+  page_id_t directory_page_id = INVALID_PAGE_ID;
+  Page *page = buffer_pool_manager_->NewPage(&directory_page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "out of memory");
+  }
+  auto *directory_page = reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
+  directory_page->SetPageId(directory_page_id);
+  try {
+    SetDirectoryPageId(directory_idx, directory_page_id);
+  } catch (const Exception &) {
+    UnpinDirectoryPage(directory_page, false);
+    throw;
+  }
+  return directory_page;
+}
+
+void HashTableDirectory::SetDirectoryPageId(uint32_t directory_idx, page_id_t directory_page_id) {
+  uint32_t index_idx = directory_idx / DIRECTORY_INDEX_ARRAY_SIZE;
+  page_id_t index_page_id = root_->GetIndexPageId(index_idx);
+  Page *page = directory_idx % DIRECTORY_INDEX_ARRAY_SIZE == 0 ? buffer_pool_manager_->NewPage(&index_page_id)
+                                                                : buffer_pool_manager_->FetchPage(index_page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "out of memory");
+  }
+  auto *index_page = reinterpret_cast<HashTableDirectoryIndexPage *>(page->GetData());
+  if (directory_idx % DIRECTORY_INDEX_ARRAY_SIZE == 0) {
+    index_page->SetPageId(index_page_id);
+    root_->SetIndexPageId(index_idx, index_page_id);
+  }
+  index_page->SetDirectoryPageId(directory_idx % DIRECTORY_INDEX_ARRAY_SIZE, directory_page_id);
+  directory_page_ids_[directory_idx] = directory_page_id;
+  [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(index_page_id, true);
+  assert(unpinned);
+}
+
+template <typename Reader>
+void HashTableDirectory::ReadDirectoryPage(uint32_t directory_idx, Reader read) const {
+  HashTableDirectoryPage *directory_page = FetchDirectoryPage(directory_idx);
+  uint64_t version;
+  do {
+    version = BeginRead();
+    read(directory_page);
+  } while (!ValidateRead(version));
+  UnpinDirectoryPage(directory_page, false);
+}
+
+void HashTableDirectory::MarkRootDirty() {
+  [[maybe_unused]] Page *page = buffer_pool_manager_->FetchPage(root_->GetPageId());
+  assert(page != nullptr);
+  [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(root_->GetPageId(), true);
+  assert(unpinned);
+}
+
+uint64_t HashTableDirectory::BeginRead() const {
+  uint64_t version = version_.load(std::memory_order_acquire);
+  while ((version & 1) != 0) {
+    std::this_thread::yield();
+    version = version_.load(std::memory_order_acquire);
+  }
+  return version;
+}
+
+bool HashTableDirectory::ValidateRead(uint64_t version) const {
+  // keep the slot reads from moving below the version check
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return version_.load(std::memory_order_relaxed) == version;
+}
+
+void HashTableDirectory::BeginWrite() {
+  version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  // keep the slot writes from moving above the odd version
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void HashTableDirectory::EndWrite() {
+  version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+page_id_t HashTableDirectory::GetBucketPageId(uint32_t bucket_idx) const {
+  page_id_t bucket_page_id;
+  ReadDirectoryPage(DirectoryPageIndex(bucket_idx), [&](HashTableDirectoryPage *directory_page) {
+    bucket_page_id = directory_page->GetBucketPageId(SlotIndex(bucket_idx));
+  });
+  return bucket_page_id;
+}
+
+page_id_t HashTableDirectory::GetBucketPageIdOfHash(uint32_t hash, uint32_t *bucket_idx) const {
+  page_id_t bucket_page_id;
+  uint64_t version;
+  do {
+    // the directory page to fetch depends on the global depth, so it is fetched again on every try
+    version = BeginRead();
+    *bucket_idx = hash & GetGlobalDepthMask();
+    HashTableDirectoryPage *directory_page = FetchDirectoryPage(DirectoryPageIndex(*bucket_idx));
+    bucket_page_id = directory_page->GetBucketPageId(SlotIndex(*bucket_idx));
+    UnpinDirectoryPage(directory_page, false);
+  } while (!ValidateRead(version));
+  return bucket_page_id;
+}
+
+void HashTableDirectory::GetBucketPageIds(const std::vector<uint32_t> &hashes,
+                                          std::vector<page_id_t> *page_ids) const {
+  page_ids->resize(hashes.size());
+  uint32_t mask = GetGlobalDepthMask();
+  // fetch each directory page once for a run of hashes that fall into it
+  for (size_t begin = 0; begin < hashes.size();) {
+    uint32_t directory_idx = DirectoryPageIndex(hashes[begin] & mask);
+    size_t end = begin + 1;
+    while (end < hashes.size() && DirectoryPageIndex(hashes[end] & mask) == directory_idx) {
+      end++;
+    }
+    ReadDirectoryPage(directory_idx, [&](HashTableDirectoryPage *directory_page) {
+      for (size_t i = begin; i < end; i++) {
+        (*page_ids)[i] = directory_page->GetBucketPageId(SlotIndex(hashes[i] & mask));
+      }
+    });
+    begin = end;
+  }
+}
+
+void HashTableDirectory::SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id) {
+  HashTableDirectoryPage *directory_page = FetchDirectoryPage(DirectoryPageIndex(bucket_idx));
+  BeginWrite();
+  directory_page->SetBucketPageId(SlotIndex(bucket_idx), bucket_page_id);
+  EndWrite();
+  UnpinDirectoryPage(directory_page, true);
+}
+
+uint32_t HashTableDirectory::GetLocalDepth(uint32_t bucket_idx) const {
+  uint32_t local_depth;
+  ReadDirectoryPage(DirectoryPageIndex(bucket_idx), [&](HashTableDirectoryPage *directory_page) {
+    local_depth = directory_page->GetLocalDepth(SlotIndex(bucket_idx));
+  });
+  return local_depth;
+}
+
+void HashTableDirectory::Bind(uint32_t first, uint32_t stride, page_id_t bucket_page_id, uint8_t local_depth) {
+  // the slots are spread over every directory page if the stride is smaller than a page, else one per page
+  uint32_t page_stride = std::max<uint32_t>(stride >> DIRECTORY_PAGE_DEPTH, 1);
+  for (uint32_t d = DirectoryPageIndex(first); d < root_->NumDirectoryPages(); d += page_stride) {
+    HashTableDirectoryPage *directory_page = FetchDirectoryPage(d);
+    // the first slot of the page that is congruent to first, the stride is a power of two
+    uint32_t page_begin = d << DIRECTORY_PAGE_DEPTH;
+    uint32_t page_end = std::min(Size(), page_begin + DIRECTORY_ARRAY_SIZE);
+    BeginWrite();
+    for (uint32_t i = page_begin + ((first - page_begin) & (stride - 1)); i < page_end; i += stride) {
+      directory_page->SetBucketPageId(SlotIndex(i), bucket_page_id);
+      directory_page->SetLocalDepth(SlotIndex(i), local_depth);
+    }
+    EndWrite();
+    UnpinDirectoryPage(directory_page, true);
+  }
+}
+
+bool HashTableDirectory::IncrGlobalDepth() {
+  uint32_t global_depth = GetGlobalDepth();
+  if (global_depth >= DIRECTORY_MAX_DEPTH) {
+    return false;
+  }
+
+  // The upper half is invisible until the new depth is published, so readers need not retry.
+  if (global_depth < DIRECTORY_PAGE_DEPTH) {
+    //! 将所有原先前缀xxx的加1版本(1xxx)索引到(0xxx), 新的一半仍在第一个directory page中
+    HashTableDirectoryPage *directory_page = FetchDirectoryPage(0);
+    uint32_t size = 1U << global_depth;
+    for (uint32_t origin = 0; origin < size; origin++) {
+      directory_page->SetBucketPageId(origin + size, directory_page->GetBucketPageId(origin));
+      directory_page->SetLocalDepth(origin + size, directory_page->GetLocalDepth(origin));
+    }
+    UnpinDirectoryPage(directory_page, true);
+  } else {
+    // Every directory page gets a copy that serves the upper half. The slots of the origin pages only change under
+    // the caller's serialization, so they can be copied as they are.
+    uint32_t num_pages = root_->NumDirectoryPages();
+    for (uint32_t origin = 0; origin < num_pages; origin++) {
+      HashTableDirectoryPage *origin_page = FetchDirectoryPage(origin);
+      HashTableDirectoryPage *copy_page;
+      try {
+        copy_page = NewDirectoryPage(origin + num_pages);
+      } catch (const Exception &) {
+        UnpinDirectoryPage(origin_page, false);
+        throw;
+      }
+      page_id_t copy_page_id = copy_page->GetPageId();
+      memcpy(reinterpret_cast<char *>(copy_page), reinterpret_cast<char *>(origin_page), PAGE_SIZE);
+      copy_page->SetPageId(copy_page_id);
+      UnpinDirectoryPage(origin_page, false);
+      UnpinDirectoryPage(copy_page, true);
+    }
+  }
+
+  // Publish the new depth only once the upper half is in place.
+  root_->SetGlobalDepth(global_depth + 1);
+  MarkRootDirty();
+  return true;
+}
+
+void HashTableDirectory::DecrGlobalDepth() {
+  uint32_t old_num_pages = root_->NumDirectoryPages();
+  uint32_t old_num_index_pages = root_->NumIndexPages();
+  root_->SetGlobalDepth(GetGlobalDepth() - 1);
+  uint32_t num_pages = root_->NumDirectoryPages();
+  for (uint32_t i = num_pages; i < old_num_pages; i++) {
+    [[maybe_unused]] bool deleted = buffer_pool_manager_->DeletePage(directory_page_ids_[i]);
+    assert(deleted);
+    directory_page_ids_[i] = INVALID_PAGE_ID;
+  }
+  // an index page that still lists directory pages keeps the entries past them, they are overwritten on the way up
+  for (uint32_t i = root_->NumIndexPages(); i < old_num_index_pages; i++) {
+    [[maybe_unused]] bool deleted = buffer_pool_manager_->DeletePage(root_->GetIndexPageId(i));
+    assert(deleted);
+    root_->SetIndexPageId(i, INVALID_PAGE_ID);
+  }
+  MarkRootDirty();
+}
+
+bool HashTableDirectory::CanShrink() const {
+  // 如果所有的local_depth都小于global即可收缩
+  uint32_t global_depth = GetGlobalDepth();
+  uint32_t slots_per_page = std::min<uint32_t>(Size(), DIRECTORY_ARRAY_SIZE);
+  bool can_shrink = true;
+  for (uint32_t d = 0; d < root_->NumDirectoryPages() && can_shrink; d++) {
+    ReadDirectoryPage(d, [&](HashTableDirectoryPage *directory_page) {
+      can_shrink = true;
+      for (uint32_t i = 0; i < slots_per_page && can_shrink; i++) {
+        can_shrink = directory_page->GetLocalDepth(i) < global_depth;
+      }
+    });
+  }
+  return can_shrink;
+}
+
+void HashTableDirectory::VerifyIntegrity() const {
+  //  build maps of {bucket_page_id : pointer_count} and {bucket_page_id : local_depth}
+  std::unordered_map<page_id_t, uint32_t> page_id_to_count;
+  std::unordered_map<page_id_t, uint32_t> page_id_to_ld;
+  uint32_t global_depth = GetGlobalDepth();
+
+  for (uint32_t curr_idx = 0; curr_idx < Size(); curr_idx++) {
+    page_id_t curr_page_id = GetBucketPageId(curr_idx);
+    uint32_t curr_ld = GetLocalDepth(curr_idx);
+    assert(curr_ld <= global_depth);
+
+    ++page_id_to_count[curr_page_id];
+
+    if (page_id_to_ld.count(curr_page_id) > 0 && curr_ld != page_id_to_ld[curr_page_id]) {
+      LOG_WARN("Verify Integrity: curr_local_depth: %u, old_local_depth %u, for page_id: %u", curr_ld,
+               page_id_to_ld[curr_page_id], curr_page_id);
+      assert(curr_ld == page_id_to_ld[curr_page_id]);
+    } else {
+      page_id_to_ld[curr_page_id] = curr_ld;
+    }
+  }
+
+  for (const auto &[curr_page_id, curr_count] : page_id_to_count) {
+    uint32_t required_count = 0x1 << (global_depth - page_id_to_ld[curr_page_id]);
+    if (curr_count != required_count) {
+      LOG_WARN("Verify Integrity: curr_count: %u, required_count %u, for page_id: %u", curr_count, required_count,
+               curr_page_id);
+      assert(curr_count == required_count);
+    }
+  }
+}
+
+}  // namespace bustub
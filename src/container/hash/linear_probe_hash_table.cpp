@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <utility>
@@ -26,43 +27,333 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                       const KeyComparator &comparator, size_t num_buckets,
                                       HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {}
+    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
+  auto state = std::make_shared<TableState>();
+  state->active_ =
+      std::make_shared<BlockSet>(buffer_pool_manager_, (num_buckets + BLOCK_ARRAY_SIZE - 1) / BLOCK_ARRAY_SIZE);
+  header_page_id_ = state->active_->header_page_id_;
+  std::atomic_store(&state_, state);
+}
+
+/*****************************************************************************
+ * BLOCK SET
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HASH_TABLE_TYPE::BlockSet::BlockSet(BufferPoolManager *buffer_pool_manager, size_t num_blocks)
+    : buffer_pool_manager_(buffer_pool_manager) {
+  num_blocks = std::clamp<size_t>(num_blocks, 1, HashTableHeaderPage::MAX_NUM_BLOCKS);
+  Page *page = buffer_pool_manager_->NewPage(&header_page_id_);
+  assert(page != nullptr);
+  auto *header_page = reinterpret_cast<HashTableHeaderPage *>(page->GetData());
+  header_page->SetPageId(header_page_id_);
+  for (size_t i = 0; i < num_blocks; i++) {
+    // new pages are zeroed, i.e. all slots are empty
+    page_id_t block_page_id;
+    [[maybe_unused]] Page *block_page = buffer_pool_manager_->NewPage(&block_page_id);
+    assert(block_page != nullptr);
+    [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(block_page_id, true);
+    assert(unpinned);
+    header_page->AddBlockPageId(block_page_id);
+    block_page_ids_.push_back(block_page_id);
+  }
+  size_ = num_blocks * BLOCK_ARRAY_SIZE;
+  header_page->SetSize(size_);
+  [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(header_page_id_, true);
+  assert(unpinned);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HASH_TABLE_TYPE::BlockSet::~BlockSet() {
+  if (!retired_) {
+    return;
+  }
+  // the last reader is gone, nothing can pin the pages any more
+  for (page_id_t block_page_id : block_page_ids_) {
+    [[maybe_unused]] bool deleted = buffer_pool_manager_->DeletePage(block_page_id);
+    assert(deleted);
+  }
+  [[maybe_unused]] bool deleted = buffer_pool_manager_->DeletePage(header_page_id_);
+  assert(deleted);
+}
+
+/*****************************************************************************
+ * PROBE
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename Visitor>
+size_t HASH_TABLE_TYPE::Probe(BlockSet *block_set, uint64_t hash, Visitor visit) {
+  size_t slot = hash % block_set->size_;
+  for (size_t probed = 0; probed < block_set->size_;) {
+    size_t block_index = slot / BLOCK_ARRAY_SIZE;
+    page_id_t block_page_id = block_set->block_page_ids_[block_index];
+    Page *page = buffer_pool_manager_->FetchPage(block_page_id);
+    assert(page != nullptr);
+    auto *block = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(page->GetData());
+    // walk the slots of this block, then continue with the next block
+    for (auto offset = static_cast<slot_offset_t>(slot % BLOCK_ARRAY_SIZE);
+         offset < BLOCK_ARRAY_SIZE && probed < block_set->size_; offset++, probed++) {
+      bool occupied = block->IsOccupied(offset);
+      if (!occupied || !visit(block, offset, block_index * BLOCK_ARRAY_SIZE + offset)) {
+        [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(block_page_id, false);
+        assert(unpinned);
+        return occupied ? block_set->size_ : block_index * BLOCK_ARRAY_SIZE + offset;
+      }
+    }
+    [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(block_page_id, false);
+    assert(unpinned);
+    slot = (block_index + 1) % block_set->block_page_ids_.size() * BLOCK_ARRAY_SIZE;
+  }
+  return block_set->size_;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+size_t HASH_TABLE_TYPE::FindPair(BlockSet *block_set, uint64_t hash, const KeyType &key, const ValueType &value,
+                                 size_t *free_slot) {
+  size_t pair_slot = block_set->size_;
+  size_t empty_slot = Probe(block_set, hash, [&](HASH_TABLE_BLOCK_TYPE *block, slot_offset_t offset, size_t slot) {
+    if (block->IsReadable(offset) && comparator_(key, block->KeyAt(offset)) == 0 && block->ValueAt(offset) == value) {
+      pair_slot = slot;
+    }
+    return pair_slot == block_set->size_;
+  });
+  if (free_slot != nullptr) {
+    *free_slot = empty_slot;
+  }
+  return pair_slot;
+}
 
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::GetValueFrom(BlockSet *block_set, uint64_t hash, const KeyType &key,
+                                   std::vector<ValueType> *result) {
+  size_t num_found = result->size();
+  Probe(block_set, hash, [&](HASH_TABLE_BLOCK_TYPE *block, slot_offset_t offset, size_t /*slot*/) {
+    if (block->IsReadable(offset) && comparator_(key, block->KeyAt(offset)) == 0) {
+      // a pair that is being moved by a resize can show up in both block sets
+      ValueType value = block->ValueAt(offset);
+      if (std::find(result->begin(), result->begin() + num_found, value) == result->begin() + num_found) {
+        result->push_back(value);
+      }
+    }
+    return true;
+  });
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
-  return false;
+  uint64_t hash = hash_fn_.GetHash(key);
+  size_t num_found = result->size();
+  while (true) {
+    std::shared_ptr<TableState> state = LoadState();
+    // a resize copies a pair to the new block set before it removes it from the old one, so probe the old one first
+    if (state->draining_ != nullptr) {
+      GetValueFrom(state->draining_.get(), hash, key, result);
+    }
+    GetValueFrom(state->active_.get(), hash, key, result);
+    // a resize that started meanwhile may have moved pairs out of the block set we took for the active one
+    if (LoadState() == state) {
+      return result->size() > num_found;
+    }
+    result->resize(num_found);
+  }
 }
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+typename HASH_TABLE_TYPE::InsertResult HASH_TABLE_TYPE::InsertInto(BlockSet *block_set, uint64_t hash,
+                                                                   const KeyType &key, const ValueType &value) {
+  while (true) {
+    size_t free_slot;
+    if (FindPair(block_set, hash, key, value, &free_slot) != block_set->size_) {
+      return InsertResult::DUPLICATE;
+    }
+    if (free_slot == block_set->size_) {
+      return InsertResult::FULL;
+    }
+
+    page_id_t block_page_id = block_set->block_page_ids_[free_slot / BLOCK_ARRAY_SIZE];
+    Page *page = buffer_pool_manager_->FetchPage(block_page_id);
+    assert(page != nullptr);
+    auto *block = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(page->GetData());
+    bool inserted = block->Insert(free_slot % BLOCK_ARRAY_SIZE, key, value);
+    [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(block_page_id, inserted);
+    assert(unpinned);
+    if (inserted) {
+      block_set->num_occupied_++;
+      block_set->num_readable_++;
+      return InsertResult::INSERTED;
+    }
+    // another key took the slot, probe on from there
+  }
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+  uint64_t hash = hash_fn_.GetHash(key);
+  while (true) {
+    table_latch_.RLock();
+    std::shared_ptr<TableState> state = LoadState();
+    if (state->draining_ != nullptr) {
+      // every insert pays for moving one block of a resize in progress
+      MoveBlock(state);
+    }
+
+    InsertResult result;
+    {
+      std::scoped_lock key_latch(KeyLatch(hash));
+      BlockSet *draining = state->draining_.get();
+      if (draining != nullptr && FindPair(draining, hash, key, value) != draining->size_) {
+        result = InsertResult::DUPLICATE;
+      } else {
+        result = InsertInto(state->active_.get(), hash, key, value);
+      }
+    }
+
+    BlockSet *active = state->active_.get();
+    bool grow = result == InsertResult::FULL || 4 * active->num_occupied_ >= 3 * active->size_;
+    size_t num_readable = active->num_readable_;
+    bool resizing = state->draining_ != nullptr;
+    table_latch_.RUnlock();
+
+    if (active->block_page_ids_.size() == HashTableHeaderPage::MAX_NUM_BLOCKS) {
+      if (result == InsertResult::FULL && !resizing && num_readable == active->size_) {
+        // the header page can not list any more blocks
+        return false;
+      }
+      // the rebuild is at the same size, only worth it if dropping the tombstones takes it back under the threshold
+      // or makes room for a pair that did not fit
+      grow = grow && (result == InsertResult::FULL || 4 * num_readable < 3 * active->size_);
+    }
+
+    if (grow && !resizing) {
+      // tombstones are not carried over, a table that is mostly tombstones is rebuilt at the same size
+      Resize(std::max(num_readable, active->size_ / 2));
+    } else if (result == InsertResult::FULL) {
+      // help the resize in progress to finish
+      table_latch_.RLock();
+      while (MoveBlock(LoadState())) {
+      }
+      table_latch_.RUnlock();
+    }
+    if (result != InsertResult::FULL) {
+      return result == InsertResult::INSERTED;
+    }
+  }
 }
 
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::RemoveFrom(BlockSet *block_set, uint64_t hash, const KeyType &key, const ValueType &value) {
+  size_t slot = FindPair(block_set, hash, key, value);
+  if (slot == block_set->size_) {
+    return false;
+  }
+
+  page_id_t block_page_id = block_set->block_page_ids_[slot / BLOCK_ARRAY_SIZE];
+  Page *page = buffer_pool_manager_->FetchPage(block_page_id);
+  assert(page != nullptr);
+  reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(page->GetData())->Remove(slot % BLOCK_ARRAY_SIZE);
+  [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(block_page_id, true);
+  assert(unpinned);
+  block_set->num_readable_--;
+  return true;
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+  uint64_t hash = hash_fn_.GetHash(key);
+  table_latch_.RLock();
+  std::shared_ptr<TableState> state = LoadState();
+  bool removed;
+  {
+    std::scoped_lock key_latch(KeyLatch(hash));
+    removed = (state->draining_ != nullptr && RemoveFrom(state->draining_.get(), hash, key, value)) ||
+              RemoveFrom(state->active_.get(), hash, key, value);
+  }
+  table_latch_.RUnlock();
+  return removed;
 }
 
 /*****************************************************************************
  * RESIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Resize(size_t initial_size) {}
+void HASH_TABLE_TYPE::Resize(size_t initial_size) {
+  size_t num_blocks = (2 * initial_size + BLOCK_ARRAY_SIZE - 1) / BLOCK_ARRAY_SIZE;
+  // allocate the pages before blocking the writers
+  auto block_set = std::make_shared<BlockSet>(buffer_pool_manager_, num_blocks);
+
+  table_latch_.WLock();
+  std::shared_ptr<TableState> state = LoadState();
+  if (state->draining_ != nullptr) {
+    // another resize is still in progress, give the pages back
+    table_latch_.WUnlock();
+    block_set->retired_ = true;
+    return;
+  }
+  auto new_state = std::make_shared<TableState>();
+  new_state->active_ = block_set;
+  new_state->draining_ = state->active_;
+  header_page_id_ = block_set->header_page_id_;
+  std::atomic_store(&state_, new_state);
+  table_latch_.WUnlock();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::MoveBlock(const std::shared_ptr<TableState> &state) {
+  BlockSet *draining = state->draining_.get();
+  if (draining == nullptr) {
+    return false;
+  }
+  size_t block_index = state->next_block_++;
+  if (block_index >= draining->block_page_ids_.size()) {
+    return false;
+  }
+
+  page_id_t block_page_id = draining->block_page_ids_[block_index];
+  Page *page = buffer_pool_manager_->FetchPage(block_page_id);
+  assert(page != nullptr);
+  auto *block = reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(page->GetData());
+  for (slot_offset_t offset = 0; offset < BLOCK_ARRAY_SIZE; offset++) {
+    if (!block->IsReadable(offset)) {
+      continue;
+    }
+    KeyType key = block->KeyAt(offset);
+    uint64_t hash = hash_fn_.GetHash(key);
+    std::scoped_lock key_latch(KeyLatch(hash));
+    // a remove may have come first
+    if (block->IsReadable(offset)) {
+      [[maybe_unused]] InsertResult result = InsertInto(state->active_.get(), hash, key, block->ValueAt(offset));
+      assert(result != InsertResult::FULL);
+      block->Remove(offset);
+      draining->num_readable_--;
+    }
+  }
+  [[maybe_unused]] bool unpinned = buffer_pool_manager_->UnpinPage(block_page_id, true);
+  assert(unpinned);
+
+  if (++state->num_moved_blocks_ == draining->block_page_ids_.size()) {
+    // every pair has been moved, drop the old block set once its last reader is done with it
+    draining->retired_ = true;
+    auto new_state = std::make_shared<TableState>();
+    new_state->active_ = state->active_;
+    std::atomic_store(&state_, new_state);
+  }
+  return true;
+}
 
 /*****************************************************************************
  * GETSIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 size_t HASH_TABLE_TYPE::GetSize() {
-  return 0;
+  return LoadState()->active_->size_;
 }
 
 template class LinearProbeHashTable<int, int, IntComparator>;
@@ -26,6 +26,10 @@ AggregationExecutor::AggregationExecutor(ExecutorContext *exec_ctx, const Aggreg
 
 void AggregationExecutor::Init() {
   child_->Init();
+  group_by_dictionaries_.clear();
+  for (const auto &expr : plan_->GetGroupBys()) {
+    group_by_dictionaries_.push_back(expr->GetResultDictionary(child_->GetOutputSchema()));
+  }
   Tuple tuple;
   RID rid;
   //! prepare aggregation hash table
@@ -42,6 +46,7 @@ bool AggregationExecutor::Next(Tuple *tuple, RID *rid) {
   auto aggr_key = aht_iterator_.Key();
   auto aggr_val = aht_iterator_.Val();
   ++aht_iterator_;
+  DecodeAggregateKey(&aggr_key);
   //! judge having predicate
   if (plan_->GetHaving() == nullptr ||
       plan_->GetHaving()->EvaluateAggregate(aggr_key.group_bys_, aggr_val.aggregates_).GetAs<bool>()) {
@@ -12,6 +12,9 @@
 
 #include "execution/executors/hash_join_executor.h"
 
+#include "storage/table/dictionary.h"
+#include "type/value_factory.h"
+
 namespace bustub {
 
 HashJoinExecutor::HashJoinExecutor(ExecutorContext *exec_ctx, const HashJoinPlanNode *plan,
@@ -26,6 +29,13 @@ void HashJoinExecutor::Init() {
   left_child_->Init();
   right_child_->Init();
 
+  //! 两侧join key共享同一个字典时直接用字典编码做hash和比较, 不需要解码字符串
+  const Dictionary *left_dictionary =
+      plan_->LeftJoinKeyExpression()->GetResultDictionary(left_child_->GetOutputSchema());
+  const Dictionary *right_dictionary =
+      plan_->RightJoinKeyExpression()->GetResultDictionary(right_child_->GetOutputSchema());
+  join_on_codes_ = left_dictionary != nullptr && left_dictionary == right_dictionary;
+
   Tuple outer_tuple;
   RID outer_rid;
   //! prepare for outer table hash
@@ -68,6 +78,15 @@ bool HashJoinExecutor::Next(Tuple *tuple, RID *rid) {
 
 MyHashKey HashJoinExecutor::GetMyJoinKey(const Tuple *tuple, bool isLeft) {
   MyHashKey res;
+  if (join_on_codes_) {
+    const AbstractExpression *key_expr = isLeft ? plan_->LeftJoinKeyExpression() : plan_->RightJoinKeyExpression();
+    const Schema *schema = isLeft ? left_child_->GetOutputSchema() : right_child_->GetOutputSchema();
+    uint32_t code = key_expr->EvaluateDictionaryCode(tuple, schema);
+    // NULL keys never match, keep them NULL instead of comparing the NULL code.
+    res.val_ = code == Dictionary::NULL_CODE ? ValueFactory::GetNullValueByType(TypeId::INTEGER)
+                                             : ValueFactory::GetIntegerValue(static_cast<int32_t>(code));
+    return res;
+  }
   if (isLeft) {
     res.val_ = plan_->LeftJoinKeyExpression()->Evaluate(tuple, left_child_->GetOutputSchema());
   } else {
@@ -11,12 +11,107 @@
 //===----------------------------------------------------------------------===//
 #include "execution/executors/index_scan_executor.h"
 
+#include <algorithm>
+
+#include "common/exception.h"
+#include "execution/expressions/column_value_expression.h"
+#include "type/value_factory.h"
+
 namespace bustub {
 IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+void IndexScanExecutor::Init() {
+  Catalog *catalog = exec_ctx_->GetCatalog();
+  index_info_ = catalog->GetIndex(plan_->GetIndexOid());
+  table_info_ = catalog->GetTable(index_info_->table_name_);
+  cursor_ = index_info_->index_->ScanRange(plan_->GetStartKey(), plan_->GetEndKey(), exec_ctx_->GetTransaction());
+  if (cursor_ == nullptr) {
+    throw Exception(ExceptionType::NOT_IMPLEMENTED, "index scan needs an ordered index");
+  }
+  InitCovering();
+  predicate_ = dynamic_cast<const ComparisonExpression *>(plan_->GetPredicate());
+  if (predicate_ != nullptr) {
+    predicate_binding_ = predicate_->BindDictionaries(plan_->OutputSchema());
+  }
+}
+
+void IndexScanExecutor::InitCovering() {
+  covering_ = false;
+  key_columns_.clear();
+  //! 键的schema是从表的schema按key_attrs复制出来的, 类型一致, 只需找到每个输出列对应的键列
+  const std::vector<uint32_t> &key_attrs = index_info_->index_->GetKeyAttrs();
+  for (const Column &column : plan_->OutputSchema()->GetColumns()) {
+    const auto *expr = dynamic_cast<const ColumnValueExpression *>(column.GetExpr());
+    if (expr == nullptr) {
+      return;
+    }
+    auto key_attr = std::find(key_attrs.begin(), key_attrs.end(), expr->GetColIdx());
+    if (key_attr == key_attrs.end()) {
+      return;
+    }
+    key_columns_.push_back(static_cast<uint32_t>(key_attr - key_attrs.begin()));
+  }
+  covering_ = true;
+}
+
+bool IndexScanExecutor::MatchesPredicate(const Tuple *tuple) const {
+  const AbstractExpression *predicate = plan_->GetPredicate();
+  if (predicate == nullptr) {
+    return true;
+  }
+  Value matches = predicate_ != nullptr ? predicate_->Evaluate(tuple, plan_->OutputSchema(), predicate_binding_)
+                                        : predicate->Evaluate(tuple, plan_->OutputSchema());
+  return matches.GetAs<bool>();
+}
 
-void IndexScanExecutor::Init() {}
+bool IndexScanExecutor::Next(Tuple *tuple, RID *rid) {
+  LockManager *lock_manager = GetExecutorContext()->GetLockManager();
+  Transaction *txn = GetExecutorContext()->GetTransaction();
+  const Schema *schema = &table_info_->schema_;
+  Tuple table_tuple;
+  while (covering_ ? cursor_->Next(rid, &key_values_) : cursor_->Next(rid)) {
+    if (txn->GetIsolationLevel() != IsolationLevel::READ_UNCOMMITTED && !txn->IsSharedLocked(*rid) &&
+        !txn->IsExclusiveLocked(*rid) && !lock_manager->LockShared(txn, *rid)) {
+      throw TransactionAbortException(txn->GetTransactionId(), AbortReason::DEADLOCK);
+    }
+    // The entry may belong to a tuple deleted since the index was read. A covered entry comes from its key, the table
+    // is only read to check for that once the tuple is locked, a dirty read does not check.
+    bool from_key = covering_ && !key_values_.empty();
+    bool found = (from_key && txn->GetIsolationLevel() == IsolationLevel::READ_UNCOMMITTED) ||
+                 table_info_->table_->GetTuple(*rid, &table_tuple, txn);
+    if (found && from_key) {
+      std::vector<Value> values;
+      values.reserve(key_columns_.size());
+      for (uint32_t key_idx : key_columns_) {
+        values.push_back(key_values_[key_idx]);
+      }
+      *tuple = Tuple(values, plan_->OutputSchema());
+    } else if (found) {
+      std::vector<Value> values;
+      for (size_t i = 0; i < plan_->OutputSchema()->GetColumnCount(); i++) {
+        const Column &column = plan_->OutputSchema()->GetColumn(i);
+        const AbstractExpression *expr = column.GetExpr();
+        if (column.IsDictionaryEncoded() && expr->GetResultDictionary(schema) == column.GetDictionary()) {
+          // Both sides share the dictionary, hand the code over without decoding the string.
+          auto code = static_cast<int32_t>(expr->EvaluateDictionaryCode(&table_tuple, schema));
+          values.emplace_back(ValueFactory::GetIntegerValue(code));
+        } else {
+          values.emplace_back(expr->Evaluate(&table_tuple, schema));
+        }
+      }
+      *tuple = Tuple(values, plan_->OutputSchema());
+    }
 
-bool IndexScanExecutor::Next(Tuple *tuple, RID *rid) { return false; }
+    if (txn->GetIsolationLevel() == IsolationLevel::READ_COMMITTED && txn->IsSharedLocked(*rid) &&
+        !lock_manager->Unlock(txn, *rid)) {
+      throw TransactionAbortException(txn->GetTransactionId(), AbortReason::DEADLOCK);
+    }
+    if (found && MatchesPredicate(tuple)) {
+      return true;
+    }
+  }
+  return false;
+}
 
 }  // namespace bustub
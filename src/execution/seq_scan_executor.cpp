@@ -12,6 +12,10 @@
 
 #include "execution/executors/seq_scan_executor.h"
 
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "type/value_factory.h"
+
 namespace bustub {
 
 SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan)
@@ -21,9 +25,91 @@ SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNod
       table_heap_(exec_ctx->GetCatalog()->GetTable(plan_->GetTableOid())->table_.get()),
       iter_(table_heap_->Begin(exec_ctx_->GetTransaction())) {}
 
-void SeqScanExecutor::Init() { iter_ = table_heap_->Begin(exec_ctx_->GetTransaction()); }
+void SeqScanExecutor::Init() {
+  iter_ = table_heap_->Begin(exec_ctx_->GetTransaction());
+  checked_page_id_ = INVALID_PAGE_ID;
+  InitPagePruning();
+  predicate_ = dynamic_cast<const ComparisonExpression *>(plan_->GetPredicate());
+  if (predicate_ != nullptr) {
+    predicate_binding_ = predicate_->BindDictionaries(plan_->OutputSchema());
+  }
+}
+
+void SeqScanExecutor::InitPagePruning() {
+  can_prune_ = false;
+  const auto *comparison = dynamic_cast<const ComparisonExpression *>(plan_->GetPredicate());
+  if (comparison == nullptr || table_heap_->GetZoneMap() == nullptr) {
+    return;
+  }
+  // Accept both (column op constant) and (constant op column), the latter with the comparison mirrored.
+  const auto *column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0));
+  const auto *constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1));
+  ComparisonType comp_type = comparison->GetComparisonType();
+  if (column == nullptr || constant == nullptr) {
+    column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1));
+    constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0));
+    if (column == nullptr || constant == nullptr) {
+      return;
+    }
+    switch (comp_type) {
+      case ComparisonType::LessThan:
+        comp_type = ComparisonType::GreaterThan;
+        break;
+      case ComparisonType::LessThanOrEqual:
+        comp_type = ComparisonType::GreaterThanOrEqual;
+        break;
+      case ComparisonType::GreaterThan:
+        comp_type = ComparisonType::LessThan;
+        break;
+      case ComparisonType::GreaterThanOrEqual:
+        comp_type = ComparisonType::LessThanOrEqual;
+        break;
+      default:
+        break;
+    }
+  }
+  //! predicate是在output schema上求值的，需要通过output column的表达式找到table中对应的列
+  const Schema *output_schema = plan_->OutputSchema();
+  if (column->GetColIdx() >= output_schema->GetColumnCount()) {
+    return;
+  }
+  const auto *table_column =
+      dynamic_cast<const ColumnValueExpression *>(output_schema->GetColumn(column->GetColIdx()).GetExpr());
+  if (table_column == nullptr || !table_heap_->GetZoneMap()->IsTracked(table_column->GetColIdx())) {
+    return;
+  }
+  can_prune_ = true;
+  prune_col_idx_ = table_column->GetColIdx();
+  prune_comp_type_ = comp_type;
+  prune_constant_ = constant->Evaluate(nullptr, nullptr);
+}
+
+bool SeqScanExecutor::MatchesPredicate(const Tuple *tuple) const {
+  const AbstractExpression *predicate = plan_->GetPredicate();
+  if (predicate == nullptr) {
+    return true;
+  }
+  Value matches = predicate_ != nullptr ? predicate_->Evaluate(tuple, plan_->OutputSchema(), predicate_binding_)
+                                        : predicate->Evaluate(tuple, plan_->OutputSchema());
+  return matches.GetAs<bool>();
+}
+
+void SeqScanExecutor::SkipPrunedPages() {
+  const ZoneMap *zone_map = table_heap_->GetZoneMap();
+  while (iter_ != table_heap_->End()) {
+    page_id_t page_id = iter_->GetRid().GetPageId();
+    if (page_id == checked_page_id_ || zone_map->MayMatch(page_id, prune_col_idx_, prune_comp_type_, prune_constant_)) {
+      checked_page_id_ = page_id;
+      return;
+    }
+    iter_ = table_heap_->SkipPage(page_id, exec_ctx_->GetTransaction());
+  }
+}
 
 bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) {
+  if (can_prune_) {
+    SkipPrunedPages();
+  }
   if (iter_ == table_heap_->End()) {
     return false;
   }
@@ -40,7 +126,15 @@ bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) {
 
   std::vector<Value> values;
   for (size_t i = 0; i < plan_->OutputSchema()->GetColumnCount(); i++) {
-    values.emplace_back(plan_->OutputSchema()->GetColumn(i).GetExpr()->Evaluate(tuple, schema_));
+    const Column &column = plan_->OutputSchema()->GetColumn(i);
+    const AbstractExpression *expr = column.GetExpr();
+    if (column.IsDictionaryEncoded() && expr->GetResultDictionary(schema_) == column.GetDictionary()) {
+      // Both sides share the dictionary, hand the code over without decoding the string.
+      auto code = static_cast<int32_t>(expr->EvaluateDictionaryCode(tuple, schema_));
+      values.emplace_back(ValueFactory::GetIntegerValue(code));
+    } else {
+      values.emplace_back(expr->Evaluate(tuple, schema_));
+    }
   }
   *tuple = Tuple(values, plan_->OutputSchema());
   ++iter_;
@@ -51,8 +145,7 @@ bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) {
   }
 
   //! 使用predicate判断该tuple是否应该输出，不满足再次发起Next调用
-  const AbstractExpression *predict = plan_->GetPredicate();
-  if (predict != nullptr && !predict->Evaluate(tuple, plan_->OutputSchema()).GetAs<bool>()) {
+  if (!MatchesPredicate(tuple)) {
     return Next(tuple, rid);
   }
 
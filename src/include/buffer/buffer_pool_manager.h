@@ -84,6 +84,13 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Hint that page_id will be fetched soon. The page may be read into the buffer pool in the background, unpinned, so
+   * a later FetchPage finds it without waiting for the disk. It can still be evicted or deleted like any unpinned page.
+   * @param page_id id of the page to read ahead
+   */
+  void PrefetchPage(page_id_t page_id) { PrefetchPgImp(page_id); }
+
   /** @return size of the buffer pool */
   virtual size_t GetPoolSize() = 0;
 
@@ -141,5 +148,11 @@ class BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   virtual void FlushAllPgsImp() = 0;
+
+  /**
+   * Reads a page ahead of its use, see PrefetchPage. A buffer pool that cannot read ahead ignores the hint.
+   * @param page_id id of the page to read ahead
+   */
+  virtual void PrefetchPgImp(page_id_t page_id) {}
 };
 }  // namespace bustub
@@ -12,8 +12,11 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
-#include <mutex>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
 
 #include "buffer/buffer_pool_manager.h"
@@ -100,6 +103,22 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   void FlushAllPgsImp() override;
 
+  /**
+   * Queues a page for the prefetch thread, which is started on the first call. The hint is dropped if the queue is
+   * full.
+   * @param page_id id of the page to read ahead
+   */
+  void PrefetchPgImp(page_id_t page_id) override;
+
+  /** The prefetch thread, loads the queued pages until the buffer pool is destroyed. */
+  void PrefetchLoop();
+
+  /**
+   * Reads a page into an unpinned frame, unless it is in the buffer pool already or every frame is pinned.
+   * @param page_id id of the page to load
+   */
+  void LoadPage(page_id_t page_id);
+
   /**
    * Allocate a page on disk.∂
    * @return the id of the allocated page
@@ -144,5 +163,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   std::list<frame_id_t> free_list_;  // buffer bool中的空闲frame
   /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
   std::mutex latch_;
+
+  /** The most pages waiting for the prefetch thread, a prefetch beyond it is dropped. */
+  static constexpr size_t MAX_PREFETCH_QUEUE = 16;
+  /** Protects the prefetch queue and the stop flag. */
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+  std::deque<page_id_t> prefetch_queue_;
+  bool stop_prefetch_{false};
+  std::thread prefetch_thread_;
 };
 }  // namespace bustub
@@ -89,6 +89,12 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   void FlushAllPgsImp() override;
 
+  /**
+   * Reads a page ahead of its use in the responsible BufferPoolManagerInstance.
+   * @param page_id id of the page to read ahead
+   */
+  void PrefetchPgImp(page_id_t page_id) override;
+
  private:
   std::vector<BufferPoolManager *> bp_instances_;
   size_t pool_size_;
@@ -21,8 +21,11 @@
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/schema.h"
 #include "container/hash/hash_function.h"
+#include "storage/index/b_plus_tree_index.h"
 #include "storage/index/extendible_hash_table_index.h"
 #include "storage/index/index.h"
+#include "storage/page/header_page.h"
+#include "storage/table/dictionary.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
@@ -34,6 +37,12 @@ using table_oid_t = uint32_t;
 using column_oid_t = uint32_t;
 using index_oid_t = uint32_t;
 
+/**
+ * The access method behind an index, a NON_UNIQUE_B_PLUS_TREE lets many tuples share a key, a B_LINK_TREE is a unique
+ * B+ tree in B-link mode, for indexes that are read a lot more than they are written
+ */
+enum class IndexType { HASH_TABLE, B_PLUS_TREE, NON_UNIQUE_B_PLUS_TREE, B_LINK_TREE };
+
 /**
  * The TableInfo class maintains metadata about a table.
  */
@@ -55,6 +64,8 @@ struct TableInfo {
   std::unique_ptr<TableHeap> table_;
   /** The table OID */
   const table_oid_t oid_;
+  /** The dictionaries of the dictionary encoded columns of the schema */
+  std::vector<std::unique_ptr<Dictionary>> dictionaries_;
 };
 
 /**
@@ -119,21 +130,40 @@ class Catalog {  // Table的Controller
    * @param txn The transaction in which the table is being created
    * @param table_name The name of the new table
    * @param schema The schema of the new table
+   * @param format The page format of the new table, row-wise (NSM) or PAX
+   * @param zone_map_columns The columns to keep per-page min/max summaries of, used to skip pages in scans
+   * @param dictionary_columns The VARCHAR columns to store as codes of a per-column dictionary
    * @return A (non-owning) pointer to the metadata for the table
    */
-  TableInfo *CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema) {
+  TableInfo *CreateTable(Transaction *txn, const std::string &table_name, const Schema &table_schema,
+                         TableFormat format = TableFormat::ROW, const std::vector<uint32_t> &zone_map_columns = {},
+                         const std::vector<uint32_t> &dictionary_columns = {}) {
     if (table_names_.count(table_name) != 0) {
       return NULL_TABLE_INFO;
     }
 
+    // Swap the dictionary encoded columns for columns that store codes
+    std::vector<std::unique_ptr<Dictionary>> dictionaries;
+    std::vector<Column> columns = table_schema.GetColumns();
+    for (auto col_idx : dictionary_columns) {
+      BUSTUB_ASSERT(columns[col_idx].GetType() == TypeId::VARCHAR, "Only VARCHAR columns can be dictionary encoded.");
+      dictionaries.emplace_back(std::make_unique<Dictionary>());
+      columns[col_idx] = Column(columns[col_idx].GetName(), dictionaries.back().get());
+    }
+    const Schema schema(columns);
+
     // Construct the table heap
-    auto table = std::make_unique<TableHeap>(bpm_, lock_manager_, log_manager_, txn);
+    auto table = std::make_unique<TableHeap>(bpm_, lock_manager_, log_manager_, txn, schema, format);
+    if (!zone_map_columns.empty()) {
+      table->EnableZoneMap(schema, zone_map_columns);
+    }
 
     // Fetch the table OID for the new table
     const auto table_oid = next_table_oid_.fetch_add(1);
 
     // Construct the table information
     auto meta = std::make_unique<TableInfo>(schema, table_name, std::move(table), table_oid);
+    meta->dictionaries_ = std::move(dictionaries);
     auto *tmp = meta.get();
 
     // Update the internal tracking mechanisms
@@ -186,12 +216,14 @@ class Catalog {  // Table的Controller
    * @param key_attrs Key attributes
    * @param keysize Size of the key
    * @param hash_function The hash function for the index
+   * @param index_type The access method of the index, a B+ tree is bulk loaded from the sorted table entries
    * @return A (non-owning) pointer to the metadata of the new table
    */
   template <class KeyType, class ValueType, class KeyComparator>
   IndexInfo *CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
                          const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
-                         std::size_t keysize, HashFunction<KeyType> hash_function) {
+                         std::size_t keysize, HashFunction<KeyType> hash_function,
+                         IndexType index_type = IndexType::HASH_TABLE) {
     // Reject the creation request for nonexistent table
     if (table_names_.find(table_name) == table_names_.end()) {
       return NULL_INDEX_INFO;
@@ -211,18 +243,21 @@ class Catalog {  // Table的Controller
     auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs);
 
     // Construct the index, take ownership of metadata
-    // TODO(Kyle): We should update the API for CreateIndex
-    // to allow specification of the index type itself, not
-    // just the key, value, and comparator types
-    auto index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
-                                                                                               hash_function);
+    std::unique_ptr<Index> index;
+    if (index_type != IndexType::HASH_TABLE) {
+      using TreeIndex = BPlusTreeIndex<KeyType, ValueType, KeyComparator>;
+      index = std::make_unique<TreeIndex>(std::move(meta), bpm_, IndexHeaderPageId(), TreeIndex::DEFAULT_FILL_FACTOR,
+                                          index_type != IndexType::NON_UNIQUE_B_PLUS_TREE,
+                                          index_type == IndexType::B_LINK_TREE);
+    } else {
+      index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
+                                                                                           hash_function);
+    }
 
-    // Populate the index with all tuples in table heap
+    // Populate the index with all tuples in table heap, in one batch so that the index can build itself in bulk
     auto *table_meta = GetTable(table_name);
-    auto *heap = table_meta->table_.get();
-    for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
-      index->InsertEntry(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid(), txn);
-    }
+    TableEntrySource entries(table_meta->table_.get(), txn, schema, key_schema, key_attrs);
+    index->InsertEntries(&entries, txn);
 
     // Get the next OID for the new index
     const auto index_oid = next_index_oid_.fetch_add(1);
@@ -323,6 +358,45 @@ class Catalog {  // Table的Controller
   }
 
  private:
+  /** The keys of the tuples of a table heap, read straight from a scan when an index is created. */
+  class TableEntrySource : public IndexEntrySource {
+   public:
+    TableEntrySource(TableHeap *heap, Transaction *txn, const Schema &schema, const Schema &key_schema,
+                     const std::vector<uint32_t> &key_attrs)
+        : heap_(heap), tuple_(heap->Begin(txn)), schema_(schema), key_schema_(key_schema), key_attrs_(key_attrs) {}
+
+    bool Next(Tuple *key, RID *rid) override {
+      if (tuple_ == heap_->End()) {
+        return false;
+      }
+      *key = tuple_->KeyFromTuple(schema_, key_schema_, key_attrs_);
+      *rid = tuple_->GetRid();
+      ++tuple_;
+      return true;
+    }
+
+   private:
+    TableHeap *heap_;
+    TableIterator tuple_;
+    const Schema &schema_;
+    const Schema &key_schema_;
+    const std::vector<uint32_t> &key_attrs_;
+  };
+
+  /**
+   * @return The header page that records the root page ids of the B+ tree indexes. It is allocated on first use, as
+   * the first page of the buffer pool already belongs to a table.
+   */
+  page_id_t IndexHeaderPageId() {
+    if (index_header_page_id_ == INVALID_PAGE_ID) {
+      auto *header_page = static_cast<HeaderPage *>(bpm_->NewPage(&index_header_page_id_));
+      BUSTUB_ASSERT(header_page != nullptr, "Out of buffer pool frames.");
+      header_page->Init();
+      bpm_->UnpinPage(index_header_page_id_, true);
+    }
+    return index_header_page_id_;
+  }
+
   [[maybe_unused]] BufferPoolManager *bpm_;
   [[maybe_unused]] LockManager *lock_manager_;
   [[maybe_unused]] LogManager *log_manager_;
@@ -352,6 +426,9 @@ class Catalog {  // Table的Controller
 
   /** The next index identifier to be used. */
   std::atomic<index_oid_t> next_index_oid_{0};
+
+  /** The header page of the B+ tree indexes, see IndexHeaderPageId. */
+  page_id_t index_header_page_id_{INVALID_PAGE_ID};
 };
 
 }  // namespace bustub
@@ -22,6 +22,7 @@
 
 namespace bustub {
 class AbstractExpression;
+class Dictionary;
 
 class Column {
   friend class Schema;
@@ -50,6 +51,21 @@ class Column {
     BUSTUB_ASSERT(type == TypeId::VARCHAR, "Wrong constructor for non-VARCHAR type.");
   }
 
+  /**
+   * Dictionary encoded constructor for creating a VARCHAR Column that stores 4-byte dictionary codes inline.
+   * @param column_name name of the column
+   * @param dictionary the dictionary holding the strings of the column
+   * @param expr expression used to create this column
+   */
+  Column(std::string column_name, Dictionary *dictionary, const AbstractExpression *expr = nullptr)
+      : column_name_(std::move(column_name)),
+        column_type_(TypeId::VARCHAR),
+        fixed_length_(sizeof(uint32_t)),
+        expr_{expr},
+        dictionary_{dictionary} {
+    BUSTUB_ASSERT(dictionary != nullptr, "Dictionary encoded column needs a dictionary.");
+  }
+
   /** @return column name */
   std::string GetName() const { return column_name_; }
 
@@ -74,7 +90,13 @@ class Column {
   TypeId GetType() const { return column_type_; }
 
   /** @return true if column is inlined, false otherwise */
-  bool IsInlined() const { return column_type_ != TypeId::VARCHAR; }
+  bool IsInlined() const { return column_type_ != TypeId::VARCHAR || dictionary_ != nullptr; }
+
+  /** @return true if the column stores dictionary codes instead of strings */
+  bool IsDictionaryEncoded() const { return dictionary_ != nullptr; }
+
+  /** @return the dictionary of the column, nullptr if it is not dictionary encoded */
+  Dictionary *GetDictionary() const { return dictionary_; }
 
   /** @return a string representation of this column */
   std::string ToString() const;
@@ -128,6 +150,9 @@ class Column {
 
   /** Expression used to create this column **/
   const AbstractExpression *expr_;
+
+  /** Dictionary of a dictionary encoded VARCHAR column, otherwise nullptr. */
+  Dictionary *dictionary_{nullptr};
 };
 
 }  // namespace bustub
@@ -78,6 +78,12 @@ class Schema {
   /** @return true if all columns are inlined, false otherwise */
   inline bool IsInlined() const { return tuple_is_inlined_; }
 
+  /** @return the offset of a column in the tuple, without going through its Column */
+  inline uint32_t GetColumnOffset(const uint32_t col_idx) const { return column_offsets_[col_idx]; }
+
+  /** @return the type of a column, without going through its Column */
+  inline TypeId GetColumnType(const uint32_t col_idx) const { return column_types_[col_idx]; }
+
   /** @return string representation of this schema */
   std::string ToString() const;
 
@@ -93,6 +99,10 @@ class Schema {
 
   /** Indices of all uninlined columns. */
   std::vector<uint32_t> uninlined_columns_;
+
+  /** Offset and type of every column, kept densely for the fixed-width tuple paths. */
+  std::vector<uint32_t> column_offsets_;
+  std::vector<TypeId> column_types_;
 };
 
 }  // namespace bustub
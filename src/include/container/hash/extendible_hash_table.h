@@ -12,20 +12,52 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <string>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/transaction.h"
+#include "container/hash/extendible_hash_table_iterator.h"
 #include "container/hash/hash_function.h"
+#include "container/hash/hash_table_directory.h"
 #include "storage/page/hash_table_bucket_page.h"
-#include "storage/page/hash_table_directory_page.h"
 
 namespace bustub {
 
 #define HASH_TABLE_TYPE ExtendibleHashTable<KeyType, ValueType, KeyComparator>
 
+/**
+ * Statistics of an extendible hash table, see ExtendibleHashTable::GetStats.
+ */
+struct ExtendibleHashTableStats {
+  /** The fill histogram has one bin per tenth of a bucket, full buckets are counted in the last bin */
+  static constexpr uint32_t NUM_FILL_BINS = 10;
+
+  /** @return the fraction of all bucket slots that hold a pair */
+  double LoadFactor() const {
+    return num_buckets_ == 0 ? 0 : static_cast<double>(num_entries_) / (num_buckets_ * bucket_capacity_);
+  }
+
+  /** @return the number of times the directory can still double */
+  uint32_t DirectoryHeadroom() const { return DIRECTORY_MAX_DEPTH - global_depth_; }
+
+  uint64_t num_entries_{0};
+  uint32_t num_buckets_{0};
+  // pairs per bucket page
+  uint32_t bucket_capacity_{0};
+  uint32_t global_depth_{0};
+  // fill_histogram_[i] is the number of buckets filled to [i, i + 1) tenths
+  std::vector<uint32_t> fill_histogram_;
+  // local_depth_histogram_[d] is the number of buckets of local depth d, for d up to the global depth
+  std::vector<uint32_t> local_depth_histogram_;
+  uint32_t num_full_buckets_{0};
+  // full buckets at DIRECTORY_MAX_DEPTH, they cannot split, so inserting another pair into one of them fails
+  uint32_t num_overflowing_buckets_{0};
+};
+
 /**
  * Implementation of extendible hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
@@ -33,6 +65,8 @@ namespace bustub {
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class ExtendibleHashTable {
+  friend class ExtendibleHashTableIterator<KeyType, ValueType, KeyComparator>;
+
  public:
   /**
    * Creates a new ExtendibleHashTable.
@@ -74,11 +108,62 @@ class ExtendibleHashTable {
    */
   bool GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result);
 
+  /**
+   * Performs a batch of point queries. The keys are hashed up front and grouped by bucket, so every bucket is
+   * fetched and latched once per batch, and the next bucket is fetched ahead while the current one is probed.
+   *
+   * @param transaction the current transaction
+   * @param keys the keys to look up
+   * @param[out] results results[i] holds the value(s) associated with keys[i]
+   * @return true if at least one key was found
+   */
+  bool GetValues(Transaction *transaction, const std::vector<KeyType> &keys,
+                 std::vector<std::vector<ValueType>> *results);
+
+  /**
+   * Builds the table from a batch of pairs in one pass instead of inserting them one at a time. Every key is hashed
+   * once, the pairs are radix sorted by the low bits of their hashes, and each run of pairs that fits in a bucket is
+   * written to a fresh bucket page exactly once. The directory is created at its final global depth, so there are
+   * no splits and no directory doublings. Falls back to Insert if the table is not empty, or if some run of equal
+   * hashes does not fit in a bucket at DIRECTORY_MAX_DEPTH.
+   *
+   * The pairs must be distinct, as the (key, rid) pairs of a table heap are.
+   *
+   * @param transaction the current transaction
+   * @param keys the keys to insert
+   * @param values values[i] is the value of keys[i]
+   * @return true if every pair was inserted
+   */
+  bool BulkLoad(Transaction *transaction, const std::vector<KeyType> &keys, const std::vector<ValueType> &values);
+
+  /**
+   * @return an iterator positioned on the first pair of the table, see ExtendibleHashTableIterator
+   */
+  HASH_TABLE_ITERATOR_TYPE Begin() { return HASH_TABLE_ITERATOR_TYPE(this); }
+
+  /**
+   * Collects the statistics of the table, visiting every bucket once under its read latch.
+   *
+   * @param transaction the current transaction
+   * @return the statistics
+   */
+  ExtendibleHashTableStats GetStats(Transaction *transaction);
+
   /**
    * Returns the global depth.  Do not touch.
    */
   uint32_t GetGlobalDepth();
 
+  /**
+   * Merges every bucket with its split image while their pairs fit in half a bucket, cascading up as far as
+   * possible, then shrinks the directory and frees the emptied bucket and directory pages. Remove already merges
+   * the buckets it drains, Compact catches the rest, e.g. after a bulk delete.
+   *
+   * @param transaction the current transaction
+   * @return the number of bucket pages freed
+   */
+  uint32_t Compact(Transaction *transaction);
+
   /**
    * Helper function to verify the integrity of the extendible hash table's directory.  Do not touch.
    */
@@ -107,26 +192,27 @@ class ExtendibleHashTable {
    * representation.
    *
    * @param key the key to use for lookup
-   * @param dir_page to use for lookup of global depth
+   * @param dir the directory to use for lookup of global depth
    * @return the directory index
    */
-  inline uint32_t KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page);
+  inline uint32_t KeyToDirectoryIndex(KeyType key, HashTableDirectory *dir);
 
   /**
    * Get the bucket page_id corresponding to a key.
    *
    * @param key the key for lookup
-   * @param dir_page a pointer to the hash table's directory page
+   * @param dir the hash table's directory
    * @return the bucket page_id corresponding to the input key
    */
-  inline uint32_t KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page);
+  inline uint32_t KeyToPageId(KeyType key, HashTableDirectory *dir);
 
   /**
-   * Fetches the directory page from the buffer pool manager.
+   * Gets the directory, creating it on first use. The directory pages stay pinned for the lifetime of the table,
+   * so looking up a bucket costs no buffer pool operation.
    *
-   * @return a pointer to the directory page
+   * @return the directory
    */
-  HashTableDirectoryPage *FetchDirectoryPage();
+  HashTableDirectory *FetchDirectory();
 
   /**
    * Fetches the a bucket page from the buffer pool manager using the bucket's page_id.
@@ -138,6 +224,19 @@ class ExtendibleHashTable {
 
   HASH_TABLE_BUCKET_TYPE *RetrieveBucketPage(Page *page);
 
+  /**
+   * Fetches and latches the bucket a hash maps to. The directory is read again once the bucket is latched, and the
+   * lookup is retried if a concurrent split rebound the slot in between, so the returned bucket holds every pair
+   * with that hash.
+   *
+   * @param dir the hash table's directory
+   * @param hash the hash of the key
+   * @param exclusive whether to take the write latch instead of the read latch
+   * @param[out] bucket_index the directory index the bucket was found at
+   * @return the pinned and latched bucket page
+   */
+  Page *FetchLatchedBucketPage(HashTableDirectory *dir, uint32_t hash, bool exclusive, uint32_t *bucket_index);
+
   /**
    * Performs insertion with an optional bucket splitting.
    *
@@ -149,32 +248,45 @@ class ExtendibleHashTable {
   bool SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value);
 
   /**
-   * Optionally merges an empty bucket into it's pair.  This is called by Remove,
-   * if Remove makes a bucket empty.
-   *
-   * There are three conditions under which we skip the merge:
-   * 1. The bucket is no longer empty.
-   * 2. The bucket has local depth 0.
-   * 3. The bucket's local depth doesn't match its split image's local depth.
+   * Optionally merges an under-full bucket into it's pair, and the result into its own pair, and so on.
+   * This is called by Remove, if Remove makes a bucket empty or drains it to a quarter full.
    *
    * @param transaction a pointer to the current transaction
-   * @param key the key that was removed
-   * @param value the value that was removed
+   * @param target_bucket_index the directory index of the bucket that was removed from
    */
   void Merge(Transaction *transaction, uint32_t target_bucket_index);
 
+  /**
+   * Merges a bucket with its split image. The caller holds table_latch_ in write mode.
+   *
+   * There are three conditions under which we skip the merge:
+   * 1. The bucket has local depth 0.
+   * 2. The bucket's local depth doesn't match its split image's local depth.
+   * 3. Neither bucket is empty and the pairs of both do not fit in half a bucket, so that a merged bucket does not
+   *    split again right away.
+   *
+   * @param dir the hash table's directory
+   * @param[in,out] bucket_index a directory index of the bucket, set to the index of the merged bucket
+   * @return true if the buckets were merged
+   */
+  bool MergeBucket(HashTableDirectory *dir, uint32_t *bucket_index);
+
   Page *AssertPage(Page *page);
 
   // member variables
-  page_id_t directory_page_id_ = INVALID_PAGE_ID;
   BufferPoolManager *buffer_pool_manager_;
+  HashTableDirectory directory_;
+  // Set once directory_ is created
+  std::atomic<bool> directory_created_{false};
   KeyComparator comparator_;
 
-  // Readers includes inserts and removes, writers are splits and merges
+  // Readers includes inserts, removes and splits, only merges take it in write mode
   ReaderWriterLatch table_latch_;
   HashFunction<KeyType> hash_fn_;
 
   std::mutex mu_;
+  // Serializes every change to the directory made under table_latch_ in read mode, i.e. by splits
+  std::mutex directory_latch_;
 };
 
 }  // namespace bustub
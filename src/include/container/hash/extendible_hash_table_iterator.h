@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table_iterator.h
+//
+// Identification: src/include/container/hash/extendible_hash_table_iterator.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+#include "container/hash/hash_table_directory.h"
+#include "storage/page/hash_table_bucket_page.h"
+
+namespace bustub {
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class ExtendibleHashTable;
+
+#define HASH_TABLE_ITERATOR_TYPE ExtendibleHashTableIterator<KeyType, ValueType, KeyComparator>
+
+/**
+ * Iterates over every pair of an extendible hash table, bucket by bucket in the order of the buckets' lowest
+ * directory slots. Stepping into a bucket takes the table latch in read mode and the bucket's read latch, copies the
+ * pairs of the bucket out and releases both, so the iterator holds no latch or pin between steps and the table may
+ * be used, also by the thread that owns the iterator, while it is live.
+ *
+ * It is weakly consistent: a pair that is inserted, removed, or moved by a split or a merge while the iterator is
+ * live may be missed or visited twice, and the pairs of the current bucket are the ones it held when the iterator
+ * stepped into it.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class ExtendibleHashTableIterator {
+ public:
+  /**
+   * Positions the iterator on the first pair of the table, see ExtendibleHashTable::Begin.
+   *
+   * @param table the table to iterate over
+   */
+  explicit ExtendibleHashTableIterator(ExtendibleHashTable<KeyType, ValueType, KeyComparator> *table);
+
+  ~ExtendibleHashTableIterator();
+
+  DISALLOW_COPY_AND_MOVE(ExtendibleHashTableIterator);
+
+  /** @return true if the iterator is past the last pair */
+  bool IsEnd() const { return item_index_ >= items_.size(); }
+
+  /** @return the current pair */
+  MappingType operator*() const { return items_[item_index_]; }
+
+  /** Advances to the next pair */
+  ExtendibleHashTableIterator &operator++();
+
+ private:
+  /** Copies out the pairs of the first non-empty bucket at or after directory index bucket_idx */
+  void SeekBucket(uint32_t bucket_idx);
+
+  ExtendibleHashTable<KeyType, ValueType, KeyComparator> *table_;
+  HashTableDirectory *dir_;
+  // the pairs of the current bucket, the iterator is on items_[item_index_]
+  std::vector<MappingType> items_;
+  size_t item_index_{0};
+  uint32_t bucket_index_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,198 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_directory.h
+//
+// Identification: src/include/container/hash/hash_table_directory.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
+#include "storage/page/hash_table_directory_index_page.h"
+#include "storage/page/hash_table_directory_page.h"
+#include "storage/page/hash_table_root_directory_page.h"
+
+namespace bustub {
+
+/**
+ * HashTableDirectory is the logical directory of an extendible hash table: 2^global_depth slots, each holding a
+ * bucket page id and the local depth of that bucket. The slots live in HashTableDirectoryPages that are found through
+ * the HashTableDirectoryIndexPages of a HashTableRootDirectoryPage. The directory page ids are cached in memory as
+ * well, so a reader goes straight to the directory page it needs. Only the root stays pinned for the lifetime of the
+ * directory, the directory pages are fetched when a slot is read or written and unpinned right after, so a deep
+ * directory does not hold on to frames.
+ *
+ * Slots are read optimistically: a reader notes the version, reads the mask and the slot, and retries if a writer
+ * changed the version in between. Writers (Bind, SetBucketPageId, IncrGlobalDepth, DecrGlobalDepth) must be
+ * serialized by the caller, the directory does not order two writers against each other.
+ */
+class HashTableDirectory {
+ public:
+  /**
+   * The directory is created, or bulk built, on first use of the hash table.
+   *
+   * @param buffer_pool_manager the buffer pool holding the directory pages
+   */
+  explicit HashTableDirectory(BufferPoolManager *buffer_pool_manager)
+      : buffer_pool_manager_(buffer_pool_manager),
+        directory_page_ids_(1U << (DIRECTORY_MAX_DEPTH - DIRECTORY_PAGE_DEPTH), INVALID_PAGE_ID) {}
+
+  /** Unpin the root, it stays in the buffer pool until it is evicted. */
+  ~HashTableDirectory();
+
+  DISALLOW_COPY_AND_MOVE(HashTableDirectory);
+
+  /**
+   * Allocate the root directory page and the directory pages of a directory of the given global depth, and point
+   * every slot at bucket_page_id with local depth 0. Throws an OUT_OF_MEMORY exception if the buffer pool has no
+   * frame for a new page.
+   *
+   * @param bucket_page_id the first bucket
+   * @param global_depth the initial global depth, a bulk build sizes the directory to its final depth up front
+   */
+  void Create(page_id_t bucket_page_id, uint32_t global_depth = 0);
+
+  /** @return the root directory page */
+  HashTableRootDirectoryPage *GetRoot() const { return root_; }
+
+  /** @return the global depth of the directory */
+  uint32_t GetGlobalDepth() const { return root_->GetGlobalDepth(); }
+
+  /** @return mask of global_depth 1's and the rest 0's (with 1's from LSB upwards) */
+  uint32_t GetGlobalDepthMask() const { return (1U << GetGlobalDepth()) - 1; }
+
+  /** @return the current directory size */
+  uint32_t Size() const { return 1U << GetGlobalDepth(); }
+
+  /** @return bucket page_id corresponding to bucket_idx */
+  page_id_t GetBucketPageId(uint32_t bucket_idx) const;
+
+  /**
+   * Look up the bucket of a hash, reading the global depth mask and the slot as of one version of the directory.
+   *
+   * @param hash the hash of a key
+   * @param[out] bucket_idx the directory index of the hash
+   * @return the bucket page id at bucket_idx
+   */
+  page_id_t GetBucketPageIdOfHash(uint32_t hash, uint32_t *bucket_idx) const;
+
+  /**
+   * Look up the buckets of many hashes under one global depth mask.
+   *
+   * @param hashes the hashes to look up, best sorted by their low bits so that neighbouring slots are read together
+   * @param[out] page_ids page_ids[i] is the bucket page id of hashes[i] under the current global depth
+   */
+  void GetBucketPageIds(const std::vector<uint32_t> &hashes, std::vector<page_id_t> *page_ids) const;
+
+  /** Updates the directory index using a bucket index and page_id */
+  void SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id);
+
+  /** @return the local depth of the bucket at bucket_idx */
+  uint32_t GetLocalDepth(uint32_t bucket_idx) const;
+
+  /** @return mask of local 1's and the rest 0's (with 1's from LSB upwards) */
+  uint32_t GetLocalDepthMask(uint32_t bucket_idx) const { return (1U << GetLocalDepth(bucket_idx)) - 1; }
+
+  /** @return the directory index of the split image of bucket_idx */
+  uint32_t GetSplitImageIndex(uint32_t bucket_idx) const {
+    return (1U << (GetLocalDepth(bucket_idx) - 1)) ^ bucket_idx;
+  }
+
+  /** @return true if bucket_idx is the lowest of the slots that point at its bucket */
+  bool IsFirstIndexOfBucket(uint32_t bucket_idx) const { return (bucket_idx >> GetLocalDepth(bucket_idx)) == 0; }
+
+  /**
+   * Point the slots first, first + stride, first + 2 * stride, ... at bucket_page_id with the given local depth.
+   */
+  void Bind(uint32_t first, uint32_t stride, page_id_t bucket_page_id, uint8_t local_depth);
+
+  /**
+   * Double the directory: the upper half becomes a copy of the lower half, allocating directory pages as needed,
+   * and only then the new global depth is published. Readers that still use the old global depth never look at
+   * the upper half, so they do not need to be blocked while the directory grows. Throws an OUT_OF_MEMORY exception
+   * if the buffer pool has no frame for a new directory page, the global depth is then unchanged.
+   *
+   * @return false if the directory is at DIRECTORY_MAX_DEPTH
+   */
+  bool IncrGlobalDepth();
+
+  /**
+   * Halve the directory and delete the directory pages that fall out of use. There must be no concurrent readers.
+   */
+  void DecrGlobalDepth();
+
+  /** @return true if every local depth is lower than the global depth */
+  bool CanShrink() const;
+
+  /**
+   * Verify the following invariants:
+   * (1) All LD <= GD.
+   * (2) Each bucket has precisely 2^(GD - LD) pointers pointing to it.
+   * (3) The LD is the same at each index with the same bucket_page_id
+   */
+  void VerifyIntegrity() const;
+
+ private:
+  /**
+   * Pin the directory_idx'th directory page, release it with UnpinDirectoryPage. Throws an OUT_OF_MEMORY exception
+   * if the buffer pool has no frame for it.
+   */
+  HashTableDirectoryPage *FetchDirectoryPage(uint32_t directory_idx) const;
+
+  void UnpinDirectoryPage(HashTableDirectoryPage *directory_page, bool is_dirty) const;
+
+  /**
+   * Allocate a directory page, make it the directory_idx'th one and leave it pinned. Throws an OUT_OF_MEMORY
+   * exception if the buffer pool has no frame for it.
+   */
+  HashTableDirectoryPage *NewDirectoryPage(uint32_t directory_idx);
+
+  /**
+   * List a directory page as the directory_idx'th one in its directory index page, allocating the index page for the
+   * first directory page it lists.
+   */
+  void SetDirectoryPageId(uint32_t directory_idx, page_id_t directory_page_id);
+
+  /**
+   * Run read(directory_page) on the directory_idx'th directory page until it ran as of one version of the directory.
+   */
+  template <typename Reader>
+  void ReadDirectoryPage(uint32_t directory_idx, Reader read) const;
+
+  /**
+   * Mark the pinned root page dirty. The buffer pool only takes the dirty flag on unpin, so this pins and unpins it
+   * once more. Only writers pay for this.
+   */
+  void MarkRootDirty();
+
+  /** @return the version to validate a read against, once no writer is in progress */
+  uint64_t BeginRead() const;
+
+  /** @return true if no writer started since BeginRead returned version */
+  bool ValidateRead(uint64_t version) const;
+
+  /** Mark a writer in progress, optimistic readers retry until EndWrite */
+  void BeginWrite();
+
+  void EndWrite();
+
+  BufferPoolManager *buffer_pool_manager_;
+  // pinned for the lifetime of the directory
+  HashTableRootDirectoryPage *root_{nullptr};
+  // directory_page_ids_[i] is the page id of the i'th directory page, as listed by the directory index pages. The
+  // entries are written before a new global depth is published, and the vector is never resized.
+  std::vector<page_id_t> directory_page_ids_;
+  // Odd while a writer changes slots
+  std::atomic<uint64_t> version_{0};
+};
+
+}  // namespace bustub
@@ -12,6 +12,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <string>
 #include <vector>
@@ -32,6 +35,16 @@ namespace bustub {
  * Implementation of linear probing hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table dynamically grows once full.
+ *
+ * The slots live in block pages listed by a header page. Removed pairs leave tombstones, which a resize drops.
+ *
+ * Concurrency:
+ * - GetValue takes no latch at all, it relies on the atomic occupied/readable bits of the block pages.
+ * - Insert and Remove take table_latch_ in read mode plus the key latch of the key's hash, which orders the
+ *   duplicate check and the insert of equal keys. Different keys claim slots with a compare and swap.
+ * - Resize builds the new block set and takes table_latch_ in write mode only to publish it. The pairs of the old
+ *   block set are then moved over one block at a time by the inserts that follow, so inserts never wait for a
+ *   whole rehash. While a resize is in progress lookups probe the old block set before the new one.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator> {
@@ -75,7 +88,9 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
   bool GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) override;
 
   /**
-   * Resizes the table to at least twice the initial size provided.
+   * Resizes the table to at least twice the initial size provided. The new block set is allocated and published
+   * right away, the pairs are moved to it incrementally by later inserts. Does nothing if a resize is already in
+   * progress.
    * @param initial_size the initial size of the hash table
    */
   void Resize(size_t initial_size);
@@ -87,6 +102,75 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
   size_t GetSize();
 
  private:
+  /** The number of key latches, see KeyLatch */
+  static constexpr size_t NUM_KEY_LATCHES = 64;
+
+  /** One version of the table: a header page and its block pages. */
+  struct BlockSet {
+    BlockSet(BufferPoolManager *buffer_pool_manager, size_t num_blocks);
+    /** Deletes the pages if the block set was retired by a resize. */
+    ~BlockSet();
+
+    BufferPoolManager *buffer_pool_manager_;
+    page_id_t header_page_id_;
+    // cached from the header page so that probes do not have to fetch it
+    std::vector<page_id_t> block_page_ids_;
+    // number of slots
+    size_t size_;
+    std::atomic<size_t> num_occupied_{0};
+    std::atomic<size_t> num_readable_{0};
+    bool retired_{false};
+  };
+
+  /** The block sets in use. draining_ is set while a resize moves its pairs to active_. */
+  struct TableState {
+    std::shared_ptr<BlockSet> active_;
+    std::shared_ptr<BlockSet> draining_;
+    // the next block of draining_ to move, and the number of blocks moved so far
+    std::atomic<size_t> next_block_{0};
+    std::atomic<size_t> num_moved_blocks_{0};
+  };
+
+  enum class InsertResult { INSERTED, DUPLICATE, FULL };
+
+  /** @return the current state, readers keep its block sets alive for as long as they hold it */
+  std::shared_ptr<TableState> LoadState() const { return std::atomic_load(&state_); }
+
+  /** @return the latch that orders the writers of the keys with this hash */
+  std::mutex &KeyLatch(uint64_t hash) { return key_latches_[hash % NUM_KEY_LATCHES]; }
+
+  /**
+   * Calls visit(block, slot_in_block, slot) for every occupied slot of the probe sequence of hash, until visit
+   * returns false or an empty slot is reached. The block page stays pinned, but is not marked dirty, while visit
+   * runs, so visit must not modify it.
+   * @return the global index of the first empty slot, or block_set->size_ if the probe sequence had none
+   */
+  template <typename Visitor>
+  size_t Probe(BlockSet *block_set, uint64_t hash, Visitor visit);
+
+  /**
+   * @param[out] free_slot if not null, the first empty slot of the probe sequence, or block_set->size_ if none
+   * @return the slot holding the pair, or block_set->size_ if it is not in block_set
+   */
+  size_t FindPair(BlockSet *block_set, uint64_t hash, const KeyType &key, const ValueType &value,
+                  size_t *free_slot = nullptr);
+
+  /** Collects the values of key in block_set that are not in result yet. */
+  void GetValueFrom(BlockSet *block_set, uint64_t hash, const KeyType &key, std::vector<ValueType> *result);
+
+  /** Inserts into block_set. The caller holds the key latch. */
+  InsertResult InsertInto(BlockSet *block_set, uint64_t hash, const KeyType &key, const ValueType &value);
+
+  /** Removes from block_set. The caller holds the key latch. */
+  bool RemoveFrom(BlockSet *block_set, uint64_t hash, const KeyType &key, const ValueType &value);
+
+  /**
+   * Moves the pairs of the next block of state->draining_ to state->active_. The caller holds table_latch_ in read
+   * mode. Publishes a state without draining_ once every block has been moved.
+   * @return false if there was no block left to move
+   */
+  bool MoveBlock(const std::shared_ptr<TableState> &state);
+
   // member variable
   page_id_t header_page_id_;
   BufferPoolManager *buffer_pool_manager_;
@@ -94,6 +178,10 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
 
   // Readers includes inserts and removes, writer is only resize
   ReaderWriterLatch table_latch_;
+  std::mutex key_latches_[NUM_KEY_LATCHES];
+
+  // accessed with std::atomic_load and std::atomic_store
+  std::shared_ptr<TableState> state_;
 
   // Hash function
   HashFunction<KeyType> hash_fn_;
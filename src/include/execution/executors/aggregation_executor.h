@@ -23,6 +23,7 @@
 #include "execution/executors/abstract_executor.h"
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/aggregation_plan.h"
+#include "storage/table/dictionary.h"
 #include "storage/table/tuple.h"
 #include "type/value_factory.h"
 
@@ -189,12 +190,31 @@ class AggregationExecutor : public AbstractExecutor {
   /** @return The tuple as an AggregateKey */
   AggregateKey MakeAggregateKey(const Tuple *tuple) {
     std::vector<Value> keys;
-    for (const auto &expr : plan_->GetGroupBys()) {
-      keys.emplace_back(expr->Evaluate(tuple, child_->GetOutputSchema()));
+    const auto &group_bys = plan_->GetGroupBys();
+    for (uint32_t i = 0; i < group_bys.size(); i++) {
+      if (group_by_dictionaries_[i] != nullptr) {
+        // Group on the dictionary code, the string is decoded once per group in Next().
+        uint32_t code = group_bys[i]->EvaluateDictionaryCode(tuple, child_->GetOutputSchema());
+        keys.emplace_back(code == Dictionary::NULL_CODE ? ValueFactory::GetNullValueByType(TypeId::INTEGER)
+                                                        : ValueFactory::GetIntegerValue(static_cast<int32_t>(code)));
+      } else {
+        keys.emplace_back(group_bys[i]->Evaluate(tuple, child_->GetOutputSchema()));
+      }
     }
     return {keys};
   }
 
+  /** Replace the dictionary codes of a group-by key with their strings */
+  void DecodeAggregateKey(AggregateKey *key) const {
+    for (uint32_t i = 0; i < key->group_bys_.size(); i++) {
+      if (group_by_dictionaries_[i] != nullptr) {
+        const Value &code = key->group_bys_[i];
+        key->group_bys_[i] = code.IsNull() ? ValueFactory::GetNullValueByType(TypeId::VARCHAR)
+                                           : group_by_dictionaries_[i]->Decode(code.GetAs<int32_t>());
+      }
+    }
+  }
+
   /** @return The tuple as an AggregateValue */
   AggregateValue MakeAggregateValue(const Tuple *tuple) {
     std::vector<Value> vals;
@@ -213,5 +233,7 @@ class AggregationExecutor : public AbstractExecutor {
   SimpleAggregationHashTable aht_;
   /** Simple aggregation hash table iterator */
   SimpleAggregationHashTable::Iterator aht_iterator_;
+  /** For every group-by, the dictionary its codes are grouped on, or nullptr if it groups on values */
+  std::vector<const Dictionary *> group_by_dictionaries_;
 };
 }  // namespace bustub
@@ -107,6 +107,8 @@ class HashJoinExecutor : public AbstractExecutor {
   const std::unique_ptr<AbstractExecutor> right_child_;
   std::queue<Tuple> loop_res_{};
   MyHashTable my_map_;
+  /** True if both join keys are codes of the same dictionary and the hash table is keyed on the codes */
+  bool join_on_codes_{false};
 };
 
 }  // namespace bustub
@@ -12,20 +12,25 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "common/rid.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/expressions/comparison_expression.h"
 #include "execution/plans/index_scan_plan.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
 /**
- * IndexScanExecutor executes an index scan over a table.
+ * IndexScanExecutor executes an index scan over a table: it walks the key range of the plan in an ordered index and
+ * fetches each matching tuple from the table.
+ *
+ * If every output column is a key column, the scan is index-only: the output is decoded from the keys in the index.
+ * The table is then only read to check that a locked tuple still exists, and not at all by dirty reads.
  */
-
 class IndexScanExecutor : public AbstractExecutor {
  public:
   /**
@@ -42,7 +47,27 @@ class IndexScanExecutor : public AbstractExecutor {
   bool Next(Tuple *tuple, RID *rid) override;
 
  private:
+  /** Check whether each output column is a plain key column. If so, remember which one so Next can skip the table. */
+  void InitCovering();
+
+  /** @return true if a tuple of the output schema satisfies the predicate of the plan */
+  bool MatchesPredicate(const Tuple *tuple) const;
+
   /** The index scan plan node to be executed. */
   const IndexScanPlanNode *plan_;
+  /** The table the index is on */
+  TableInfo *table_info_{nullptr};
+  /** The index to be scanned */
+  IndexInfo *index_info_{nullptr};
+  /** Walks the key range of the plan */
+  std::unique_ptr<IndexRangeCursor> cursor_;
+  /** Index-only scan, key_columns_[i] is the key column of output column i */
+  bool covering_{false};
+  std::vector<uint32_t> key_columns_;
+  /** The decoded key of the current entry */
+  std::vector<Value> key_values_;
+  /** The predicate if it is a comparison, bound to the dictionaries of the output schema */
+  const ComparisonExpression *predicate_{nullptr};
+  ComparisonExpression::DictionaryBinding predicate_binding_;
 };
 }  // namespace bustub
@@ -16,6 +16,7 @@
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/expressions/comparison_expression.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "storage/table/tuple.h"
 
@@ -48,10 +49,32 @@ class SeqScanExecutor : public AbstractExecutor {
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
 
  private:
+  /**
+   * Check whether the predicate is a comparison between a column summarized by the table's zone map and a constant.
+   * If it is, remember the column, the comparison and the constant so Next can skip pages.
+   */
+  void InitPagePruning();
+
+  /** Move the iterator past every page whose zone map rules out the predicate. */
+  void SkipPrunedPages();
+
+  /** @return true if a tuple of the output schema satisfies the predicate of the plan */
+  bool MatchesPredicate(const Tuple *tuple) const;
+
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
   Schema *schema_;
   TableHeap *table_heap_;
   TableIterator iter_;
+  /** Page pruning through the zone map, only used if can_prune_ is set */
+  bool can_prune_{false};
+  uint32_t prune_col_idx_{0};
+  ComparisonType prune_comp_type_{ComparisonType::Equal};
+  Value prune_constant_;
+  /** The last page the zone map allowed, so every page is checked once */
+  page_id_t checked_page_id_{INVALID_PAGE_ID};
+  /** The predicate if it is a comparison, bound to the dictionaries of the output schema */
+  const ComparisonExpression *predicate_{nullptr};
+  ComparisonExpression::DictionaryBinding predicate_binding_;
 };
 }  // namespace bustub
@@ -19,6 +19,8 @@
 #include "storage/table/tuple.h"
 
 namespace bustub {
+class Dictionary;
+
 /**
  * AbstractExpression is the base class of all the expressions in the system.
  * Expressions are modeled as trees, i.e. every expression may have a variable number of children.
@@ -58,6 +60,22 @@ class AbstractExpression {
    */
   virtual Value EvaluateAggregate(const std::vector<Value> &group_bys, const std::vector<Value> &aggregates) const = 0;
 
+  /**
+   * @param schema the schema of the tuples the expression is evaluated on
+   * @return the dictionary of the result if the expression reads a dictionary encoded column, otherwise nullptr
+   */
+  virtual const Dictionary *GetResultDictionary(const Schema *schema) const { return nullptr; }
+
+  /**
+   * Returns the dictionary code of the result without decoding it, only valid if GetResultDictionary is not nullptr.
+   * @param tuple The tuple
+   * @param schema The tuple's schema
+   * @return The code of the value obtained by evaluating the tuple
+   */
+  virtual uint32_t EvaluateDictionaryCode(const Tuple *tuple, const Schema *schema) const {
+    UNREACHABLE("Expression does not produce dictionary codes.");
+  }
+
   /** @return the child_idx'th child of this expression */
   const AbstractExpression *GetChildAt(uint32_t child_idx) const { return children_[child_idx]; }
 
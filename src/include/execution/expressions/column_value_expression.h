@@ -41,6 +41,14 @@ class ColumnValueExpression : public AbstractExpression {
                            : right_tuple->GetValue(right_schema, col_idx_);
   }
 
+  const Dictionary *GetResultDictionary(const Schema *schema) const override {
+    return schema->GetColumn(col_idx_).GetDictionary();
+  }
+
+  uint32_t EvaluateDictionaryCode(const Tuple *tuple, const Schema *schema) const override {
+    return tuple->GetDictionaryCode(schema, col_idx_);
+  }
+
   Value EvaluateAggregate(const std::vector<Value> &group_bys, const std::vector<Value> &aggregates) const override {
     BUSTUB_ASSERT(false, "Aggregation should only refer to group-by and aggregates.");
   }
@@ -17,6 +17,8 @@
 
 #include "catalog/schema.h"
 #include "execution/expressions/abstract_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "storage/table/dictionary.h"
 #include "storage/table/tuple.h"
 #include "type/value_factory.h"
 
@@ -30,6 +32,24 @@ enum class ComparisonType { Equal, NotEqual, LessThan, LessThanOrEqual, GreaterT
  */
 class ComparisonExpression : public AbstractExpression {
  public:
+  /**
+   * The dictionaries a comparison reads, resolved against the schema an executor evaluates it on. The plan is shared,
+   * so the binding lives in the executor.
+   */
+  struct DictionaryBinding {
+    /** the dictionary the comparison is decided on, nullptr if it has to compare the decoded values */
+    const Dictionary *dictionary_{nullptr};
+    /** true if both children read the dictionary, otherwise child encoded_child_ is compared against constant_ */
+    bool both_encoded_{false};
+    uint32_t encoded_child_{0};
+    Value constant_;
+    /** the code of constant_, only valid if constant_found_ */
+    bool constant_found_{false};
+    uint32_t constant_code_{0};
+    /** the size of the dictionary when it was bound, a constant that was not in it can only get a later code */
+    uint32_t dictionary_size_{0};
+  };
+
   /** Creates a new comparison expression representing (left comp_type right). */
   ComparisonExpression(const AbstractExpression *left, const AbstractExpression *right, ComparisonType comp_type)
       : AbstractExpression({left, right}, TypeId::BOOLEAN), comp_type_{comp_type} {}
@@ -53,7 +73,79 @@ class ComparisonExpression : public AbstractExpression {
     return ValueFactory::GetBooleanValue(PerformComparison(lhs, rhs));
   }
 
+  /** @return the type of the comparison */
+  ComparisonType GetComparisonType() const { return comp_type_; }
+
+  /**
+   * Resolve the dictionaries of the children against the schema the comparison will be evaluated on, and look up the
+   * code of a constant operand. An executor binds its predicate once and evaluates it with the binding on every tuple.
+   * @param schema the schema of the tuples
+   * @return the binding, its dictionary_ is nullptr if the comparison cannot be decided on codes
+   */
+  DictionaryBinding BindDictionaries(const Schema *schema) const {
+    DictionaryBinding binding;
+    if (comp_type_ != ComparisonType::Equal && comp_type_ != ComparisonType::NotEqual) {
+      return binding;
+    }
+    const Dictionary *left_dictionary = GetChildAt(0)->GetResultDictionary(schema);
+    const Dictionary *right_dictionary = GetChildAt(1)->GetResultDictionary(schema);
+    if (left_dictionary == right_dictionary) {
+      binding.dictionary_ = left_dictionary;
+      binding.both_encoded_ = true;
+      return binding;
+    }
+    if (left_dictionary != nullptr && right_dictionary != nullptr) {
+      return binding;
+    }
+
+    // One side is encoded: the other side must be a string constant, whose code is looked up here once.
+    binding.encoded_child_ = left_dictionary != nullptr ? 0 : 1;
+    const auto *constant = dynamic_cast<const ConstantValueExpression *>(GetChildAt(1 - binding.encoded_child_));
+    if (constant == nullptr) {
+      return binding;
+    }
+    binding.constant_ = constant->Evaluate(nullptr, nullptr);
+    if (binding.constant_.GetTypeId() != TypeId::VARCHAR) {
+      return binding;
+    }
+    binding.dictionary_ = left_dictionary != nullptr ? left_dictionary : right_dictionary;
+    binding.dictionary_size_ = binding.dictionary_->Size();
+    binding.constant_found_ = binding.dictionary_->Lookup(binding.constant_, &binding.constant_code_);
+    return binding;
+  }
+
+  /**
+   * Evaluate the comparison with a binding of the tuple's schema. Equality on a dictionary encoded column is decided
+   * on the codes, without decoding the strings.
+   */
+  Value Evaluate(const Tuple *tuple, const Schema *schema, const DictionaryBinding &binding) const {
+    if (binding.dictionary_ == nullptr) {
+      return Evaluate(tuple, schema);
+    }
+    if (binding.both_encoded_) {
+      return CompareCodes(GetChildAt(0)->EvaluateDictionaryCode(tuple, schema),
+                          GetChildAt(1)->EvaluateDictionaryCode(tuple, schema));
+    }
+    uint32_t code = GetChildAt(binding.encoded_child_)->EvaluateDictionaryCode(tuple, schema);
+    if (binding.constant_found_ || code == Dictionary::NULL_CODE) {
+      return CompareCodes(code, binding.constant_code_);
+    }
+    uint32_t constant_code;
+    if (code < binding.dictionary_size_ || !binding.dictionary_->Lookup(binding.constant_, &constant_code)) {
+      // A string that is not in the dictionary is not equal to any value of the column.
+      return ValueFactory::GetBooleanValue(comp_type_ == ComparisonType::NotEqual);
+    }
+    return CompareCodes(code, constant_code);
+  }
+
  private:
+  Value CompareCodes(uint32_t lhs, uint32_t rhs) const {
+    if (lhs == Dictionary::NULL_CODE || rhs == Dictionary::NULL_CODE) {
+      return ValueFactory::GetBooleanValue(CmpBool::CmpNull);
+    }
+    return ValueFactory::GetBooleanValue((lhs == rhs) == (comp_type_ == ComparisonType::Equal));
+  }
+
   CmpBool PerformComparison(const Value &lhs, const Value &rhs) const {
     switch (comp_type_) {
       case ComparisonType::Equal:
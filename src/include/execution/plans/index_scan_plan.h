@@ -32,6 +32,25 @@ class IndexScanPlanNode : public AbstractPlanNode {
   IndexScanPlanNode(const Schema *output, const AbstractExpression *predicate, index_oid_t index_oid)
       : AbstractPlanNode(output, {}), predicate_{predicate}, index_oid_(index_oid) {}
 
+  /**
+   * Creates a new index scan plan node over a key range of an ordered index.
+   * @param output the output format of this scan plan node
+   * @param predicate the predicate to scan with, tuples are returned if predicate(tuple) == true or predicate ==
+   * nullptr
+   * @param index_oid the identifier of the index to be scanned
+   * @param start_key the lowest key to scan, in the key schema of the index, or nullptr to start at the first key
+   * @param end_key the highest key to scan, in the key schema of the index, or nullptr to run to the last key
+   */
+  IndexScanPlanNode(const Schema *output, const AbstractExpression *predicate, index_oid_t index_oid,
+                    const Tuple *start_key, const Tuple *end_key)
+      : AbstractPlanNode(output, {}),
+        predicate_{predicate},
+        index_oid_(index_oid),
+        start_key_(start_key != nullptr ? *start_key : Tuple{}),
+        end_key_(end_key != nullptr ? *end_key : Tuple{}),
+        has_start_key_(start_key != nullptr),
+        has_end_key_(end_key != nullptr) {}
+
   PlanType GetType() const override { return PlanType::IndexScan; }
 
   /** @return the predicate to test tuples against; tuples should only be returned if they evaluate to true */
@@ -40,11 +59,22 @@ class IndexScanPlanNode : public AbstractPlanNode {
   /** @return the identifier of the table that should be scanned */
   index_oid_t GetIndexOid() const { return index_oid_; }
 
+  /** @return the lowest key to scan, nullptr if the scan starts at the first key */
+  const Tuple *GetStartKey() const { return has_start_key_ ? &start_key_ : nullptr; }
+
+  /** @return the highest key to scan, nullptr if the scan runs to the last key */
+  const Tuple *GetEndKey() const { return has_end_key_ ? &end_key_ : nullptr; }
+
  private:
   /** The predicate that all returned tuples must satisfy. */
   const AbstractExpression *predicate_;
   /** The table whose tuples should be scanned. */
   index_oid_t index_oid_;
+  /** The key range to scan, both ends inclusive */
+  Tuple start_key_;
+  Tuple end_key_;
+  bool has_start_key_{false};
+  bool has_end_key_{false};
 };
 
 }  // namespace bustub
@@ -17,11 +17,41 @@
 #include <future>  // NOLINT
 #include <mutex>   // NOLINT
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "common/config.h"
 
 namespace bustub {
 
+/**
+ * Counters of the page compression in the DiskManager.
+ */
+struct CompressionStats {
+  /** Number of pages written and read */
+  uint64_t pages_written_{0};
+  uint64_t pages_read_{0};
+  /** Number of pages stored uncompressed because compression did not save space */
+  uint64_t pages_stored_raw_{0};
+  /** Bytes handed to WritePage and bytes actually stored for them */
+  uint64_t bytes_in_{0};
+  uint64_t bytes_out_{0};
+  /** Time spent compressing and decompressing, in nanoseconds */
+  uint64_t compress_ns_{0};
+  uint64_t decompress_ns_{0};
+
+  /** @return uncompressed bytes per stored byte */
+  double CompressionRatio() const { return bytes_out_ == 0 ? 1.0 : static_cast<double>(bytes_in_) / bytes_out_; }
+  /** @return average nanoseconds spent compressing one page */
+  double CompressNsPerPage() const {
+    return pages_written_ == 0 ? 0 : static_cast<double>(compress_ns_) / pages_written_;
+  }
+  /** @return average nanoseconds spent decompressing one page */
+  double DecompressNsPerPage() const {
+    return pages_read_ == 0 ? 0 : static_cast<double>(decompress_ns_) / pages_read_;
+  }
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
@@ -31,8 +61,12 @@ class DiskManager {
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param enable_compression compress pages on write. Compressed pages are packed into variable-size extents of the
+   * database file, located through an in-memory indirection map. Every extent starts with a header naming its page,
+   * so the map is rebuilt by scanning the file when it is opened, also after a crash. A database file must always be
+   * opened with the same setting.
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool enable_compression = false);
 
   ~DiskManager() = default;
 
@@ -80,6 +114,12 @@ class DiskManager {
   /** @return the number of disk writes */
   int GetNumWrites() const;
 
+  /** @return true if pages are compressed on write */
+  bool IsCompressionEnabled() const { return compression_enabled_; }
+
+  /** @return a snapshot of the page compression counters */
+  CompressionStats GetCompressionStats();
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -90,7 +130,36 @@ class DiskManager {
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
  private:
+  /** Where a compressed page lives in the database file. */
+  struct PageExtent {
+    size_t offset_;
+    /** Stored bytes, PAGE_SIZE if the page is stored uncompressed */
+    uint32_t size_;
+    /** Bytes reserved for the page with its header, a multiple of EXTENT_ALIGNMENT */
+    uint32_t extent_size_;
+  };
+  /**
+   * The header in front of the stored bytes of every extent. Of the extents that name the same page, the one written
+   * last, with the highest sequence number, holds the page, the others are free.
+   */
+  struct ExtentHeader {
+    uint32_t magic_;
+    page_id_t page_id_;
+    uint32_t size_;
+    uint32_t extent_size_;
+    uint64_t sequence_;
+  };
+  static constexpr uint32_t EXTENT_ALIGNMENT = 256;
+  static constexpr uint32_t EXTENT_MAGIC = 0x45585431;
+
   int GetFileSize(const std::string &file_name);
+  void WriteCompressedPage(page_id_t page_id, const char *page_data);
+  void ReadCompressedPage(page_id_t page_id, char *page_data);
+  /** Find room for an extent, reusing a freed extent of the same size if there is one. */
+  size_t AllocateExtent(uint32_t extent_size);
+  /** Rebuild the extent map and the free extents by scanning the extent headers of the database file */
+  void LoadExtentMap();
+
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
@@ -103,6 +172,16 @@ class DiskManager {
   std::future<void> *flush_log_f_;
   // With multiple buffer pool instances, need to protect file access
   std::mutex db_io_latch_;
+
+  bool compression_enabled_;
+  // page id -> extent of the compressed page, protected by db_io_latch_
+  std::unordered_map<page_id_t, PageExtent> extent_map_;
+  // freed extent offsets, indexed by extent size / EXTENT_ALIGNMENT
+  std::vector<std::vector<size_t>> free_extents_;
+  size_t next_extent_offset_{0};
+  // the sequence number of the next extent written
+  uint64_t next_sequence_{0};
+  CompressionStats compression_stats_;
 };
 
 }  // namespace bustub
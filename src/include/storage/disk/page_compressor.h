@@ -0,0 +1,59 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_compressor.h
+//
+// Identification: src/include/storage/disk/page_compressor.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * PageCompressor is a small LZ77 style byte compressor for pages, in the spirit of LZ4.
+ *
+ * The compressed stream is a sequence of tokens, each starting with a control byte:
+ *  - control < 0x80: a literal run of (control + 1) bytes follows.
+ *  - control >= 0x80: a match of ((control & 0x7F) + MIN_MATCH) bytes, followed by a 2-byte little-endian
+ *    distance back into the output. The match may overlap the bytes it produces, so a run of one byte (e.g. the
+ *    zeroed free space of a page) becomes a literal and a chain of matches of up to MAX_MATCH bytes, 3 bytes for
+ *    every 131 bytes of the run.
+ */
+class PageCompressor {
+ public:
+  /**
+   * Compress src into dst.
+   * @param src the bytes to compress
+   * @param src_size number of bytes in src, at most 65535
+   * @param[out] dst output buffer
+   * @param dst_capacity size of dst
+   * @return the compressed size, or 0 if the result would not fit into dst_capacity
+   */
+  static size_t Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity);
+
+  /**
+   * Decompress src into dst.
+   * @param src the compressed bytes
+   * @param src_size number of compressed bytes
+   * @param[out] dst output buffer
+   * @param dst_size the expected decompressed size
+   * @return true if src was well formed and decompressed to exactly dst_size bytes
+   */
+  static bool Decompress(const char *src, size_t src_size, char *dst, size_t dst_size);
+
+ private:
+  static constexpr size_t MIN_MATCH = 4;
+  static constexpr size_t MAX_MATCH = 0x7F + MIN_MATCH;
+  static constexpr size_t MAX_LITERAL = 0x80;
+  static constexpr size_t HASH_BITS = 12;
+};
+
+}  // namespace bustub
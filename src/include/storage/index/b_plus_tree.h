@@ -10,14 +10,17 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/b_plus_tree_posting_page.h"
 
 namespace bustub {
 
@@ -28,10 +31,38 @@ namespace bustub {
  *
  * Implementation of simple b+ tree data structure where internal pages direct
  * the search and leaf pages contain actual data.
- * (1) We only support unique key
+ * (1) Keys are unique, unless the tree is built for duplicate keys
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * Concurrency: readers crab down with read latches. Writers first try optimistically, read latching the internal
+ * pages and write latching only the leaf; if the leaf could split or underflow they restart and crab down with write
+ * latches, releasing the latches above the deepest node that is safe for the operation. root_latch_ guards
+ * root_page_id_ and is held like the latch of a virtual page above the root. The ancestors a writer holds are kept in
+ * the transaction's page set, a nullptr entry standing for root_latch_, and pages emptied by a merge are deleted
+ * from the transaction's deleted page set once every latch is released.
+ *
+ * B-link mode: every page links to its right sibling and keeps the first key of that sibling as its high key. Readers
+ * and the optimistic pass of writers then latch one page at a time and take no root_latch_, a page read through a
+ * stale parent is left to the right by following the links while the key is past the high key. This holds because
+ * keys only ever move right, by splits: a B-link tree never merges or redistributes, pages emptied by removes stay
+ * in the tree and no page is deleted. Writers do not crab either, an insert descends like a reader, remembering the
+ * page it left on every level, and write latches only the leaf. A page that splits is linked to its new right sibling
+ * before either is released, then its parent is write latched, found again from the remembered page by moving right,
+ * and takes the new separator. The split page is only released once the parent is latched, so latches are always
+ * taken up or to the right and at most two pages of a level and the one above are held. root_latch_ is only taken to
+ * start the tree and to publish a new root.
+ *
+ * Duplicate keys: a key is still stored once in its leaf. Its first value is kept in the slot like a unique key's,
+ * the second one turns the slot into a reference to an inline list, the values sorted in the free space of the leaf.
+ * A key with more values than an inline list holds, or whose list outgrows the room left in its leaf, spills them to
+ * a posting list, a chain of BPlusTreePostingPages holding the values sorted. Adding or removing a value of a key that
+ * stays in the tree does not change the leaf's size, so it never splits or merges the tree and always takes the
+ * optimistic pass. A list holds two values or more, it is turned back into a single value when it is down to one.
+ * Inline lists take room a leaf could give to pairs, so a leaf also splits when its lists leave no room for one more
+ * pair, and the lists of leaves that merge or redistribute spill when they do not fit. Posting pages are only reached
+ * through their leaf, so they are written, and deleted, under the leaf's latch, in B-link mode too.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
@@ -39,19 +70,38 @@ class BPlusTree {
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
 
  public:
+  // key_size is the number of bytes stored per key in the pages. Keys that are zero past their first key_size bytes,
+  // like the normalized keys of a fixed-width key schema, can be stored shorter to fit more of them in a page.
+  // b_link picks the B-link mode, for read heavy trees, it must be the same every time the tree is opened.
+  // duplicate_keys lets a key have many values, each pair is then unique instead of each key.
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE,
+                     page_id_t header_page_id = HEADER_PAGE_ID, int key_size = sizeof(KeyType), bool b_link = false,
+                     bool duplicate_keys = false);
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
 
-  // Insert a key-value pair into this B+ tree.
+  // Insert a key-value pair into this B+ tree. @return false if the key, or with duplicate keys the pair, is there
   bool Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
 
-  // Remove a key and its value from this B+ tree.
+  // Insert pairs sorted by key, pairs whose key is already in the tree are skipped. A leaf takes every pair below its
+  // high key before the batch moves on along the leaf chain, and the batch starts on the leaf the last one ended on if
+  // the first key falls there, so appending batches rarely descend from the root. @return the number of pairs inserted
+  size_t InsertBatch(const std::vector<MappingType> &items, Transaction *transaction = nullptr);
+
+  // Remove a key and its value from this B+ tree, every value of it if the tree has duplicate keys.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
-  // return the value associated with a given key
+  // Remove one value of a key, the key goes with its last value.
+  void Remove(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+
+  // Build an empty tree bottom up from pairs sorted by key, without duplicate keys unless the tree allows them. The
+  // leaves are packed to fill_factor of their capacity and every level is written left to right in one pass.
+  // @return false if the tree is not empty, nothing is inserted then.
+  bool BulkLoad(const std::vector<MappingType> &items, double fill_factor = 1.0, Transaction *transaction = nullptr);
+
+  // return the value associated with a given key, or every value of it read from the key's leaf and posting list
   bool GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr);
 
   // index iterator
@@ -77,22 +127,123 @@ class BPlusTree {
   // read data from file and remove one by one
   void RemoveFromFile(const std::string &file_name, Transaction *transaction = nullptr);
   // expose for test purpose
+  // @return the leaf page that may hold key, pinned and read latched, or nullptr if the tree is empty
   Page *FindLeafPage(const KeyType &key, bool leftMost = false);
 
  private:
+  enum class Operation { INSERT, REMOVE };
+
+  // @return the leaf page that may hold key, pinned and write latched with nothing else held, or nullptr if the tree
+  // is empty. The internal pages are only read latched on the way down.
+  Page *FindLeafPageOptimistic(const KeyType &key);
+
+  // The descent of the B-link mode, FindLeafPage and FindLeafPageOptimistic take it in that mode. If path is given,
+  // the root the descent starts at is pushed onto it, then the internal page left downwards on every level. @return
+  // the leaf page that holds key, pinned and latched, write latched if exclusive, with nothing else held, or nullptr
+  // if the tree is empty.
+  Page *FindLeafPageBLink(const KeyType &key, bool exclusive, bool leftMost = false,
+                          std::vector<page_id_t> *path = nullptr);
+
+  // The insert of the B-link mode, splits go up the tree through InsertIntoParentBLink
+  bool InsertBLink(const KeyType &key, const ValueType &value, Transaction *transaction);
+
+  // Add the separator key of new_node to the parent of old_node. Both nodes are write latched in the transaction's
+  // page set and released once the parent is latched, path holds the pages the insert descended through and level
+  // counts the levels of old_node above the leaves.
+  void InsertIntoParentBLink(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
+                             std::vector<page_id_t> *path, size_t level, Transaction *transaction);
+
+  // @return the internal page level + 1 levels above the leaves whose range holds key, pinned and write latched. The
+  // search starts from the page of that level in path, or from the leftmost page of the level if path is too short.
+  Page *FindParentBLink(const KeyType &key, std::vector<page_id_t> *path, size_t level);
+
+  // Crab down to the leaf page that may hold key with write latches. The pages still latched, the leaf last, are left
+  // in the transaction's page set. @return false if the tree is empty, root_latch_ is then held in write mode.
+  bool FindLeafPagePessimistic(const KeyType &key, Operation op, Transaction *transaction);
+
+  // @return a hint that leads InsertBatch back to the leaf page_id
+  uint64_t MakeLeafHint(page_id_t page_id) const;
+
+  // @return the leaf of hint, pinned and write latched, if no page was deleted since the hint was made and key is not
+  // less than the first key of the leaf, or nullptr
+  Page *FetchLeafHint(uint64_t hint, const KeyType &key);
+
+  // @return true if the node does not split (insert) or underflow (remove) when one entry is added or removed
+  bool IsSafe(BPlusTreePage *node, Operation op) const;
+
+  // Unlatch and unpin every page in the transaction's page set, and release root_latch_ if it is held
+  void ReleaseWLatches(Transaction *transaction);
+
+  // Delete the pages in the transaction's deleted page set, once no latch is held
+  void DeletePages(Transaction *transaction);
+
+  // Remove key, or only value if it is given, with the write latches of FindLeafPagePessimistic, the slow path of
+  // Remove
+  void RemoveFromLeaf(const KeyType &key, const ValueType *value, Transaction *transaction);
+
+  // Remove key and every value of it from the leaf. @return true if the leaf held key
+  bool EraseKey(LeafPage *leaf, const KeyType &key);
+
+  // With duplicate keys, add value to the values of key if the leaf holds key already, else leave it to the caller.
+  // The leaf is left as it is too if the inline list of key has no room to grow, the leaf must split first.
+  // @return true if value was added or was there already, *inserted then tells whether value was new
+  bool AddDuplicate(LeafPage *leaf, const KeyType &key, const ValueType &value, bool *inserted);
+
+  // Remove value from the values of the key at index of the leaf. If it is the only one, it is left in the slot and
+  // *last is set, the caller removes the key. @return false if the key does not have value
+  bool RemoveValue(LeafPage *leaf, int index, const ValueType &value, bool *last);
+
+  // Turn the inline list of the key at index into a posting list. @return false if the key has no inline list
+  bool SpillInlineList(LeafPage *leaf, int index);
+
+  // Turn the first inline list of the leaf into a posting list. @return false if the leaf has no inline list
+  bool SpillInlineList(LeafPage *leaf);
+
+  // Append the values of the posting list ref to result
+  void ReadPostingList(const ValueType &ref, std::vector<ValueType> *result);
+
+  // Delete the pages of the posting list ref
+  void DeletePostingList(const ValueType &ref);
+
+  // @return the value of a key with the count values sorted at values, a posting list if there are two or more
+  ValueType BuildPostingList(const ValueType *values, size_t count);
+
+  // @return the page of page_id pinned, throws if the buffer pool is out of frames
+  Page *FetchPage(page_id_t page_id);
+
   void StartNewTree(const KeyType &key, const ValueType &value);
 
+  // The node sizes of every level of a bulk load, leaves first, the rightmost node of each level being filled, and
+  // the node closed before it, kept pinned until it is linked to its right sibling
+  struct BulkLoadState {
+    std::vector<std::vector<int>> sizes_;
+    std::vector<Page *> open_;
+    std::vector<Page *> closed_;
+    std::vector<size_t> node_;
+  };
+
+  // @return the open node of level during a bulk load, opening it under its parent with first key key if needed
+  Page *BulkLoadOpen(BulkLoadState *state, size_t level, const KeyType &key);
+
+  // close the open node of level once it holds its share
+  void BulkLoadClose(BulkLoadState *state, size_t level);
+
   bool InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
 
+  LeafPage *InsertOrSplit(LeafPage *leaf, const KeyType &key, const ValueType &value, bool *inserted,
+                          Transaction *transaction);
+
   void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
                         Transaction *transaction = nullptr);
 
   template <typename N>
-  N *Split(N *node);
+  N *Split(N *node, Transaction *transaction);
 
   template <typename N>
   bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr);
 
+  int PrefixSizeAfterRedistribute(LeafPage *neighbor, LeafPage *leaf, int index);
+
   template <typename N>
   bool Coalesce(N **neighbor_node, N **node, BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent,
                 int index, Transaction *transaction = nullptr);
@@ -111,11 +262,23 @@ class BPlusTree {
 
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  // written under root_latch_, B-link readers read it without
+  std::atomic<page_id_t> root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
+  // the header page holding the root page id of the tree
+  page_id_t header_page_id_;
+  // the bytes stored per key in the pages, keys are zero past them
+  int key_size_;
+  bool b_link_;
+  bool duplicate_keys_;
+  mutable ReaderWriterLatch root_latch_;
+  // bumped by every remove that deletes pages, before they are unlatched
+  std::atomic<uint32_t> merge_version_{0};
+  // merge_version_ and the leaf the last InsertBatch ended on, in the high and the low half
+  std::atomic<uint64_t> last_leaf_hint_{static_cast<uint32_t>(INVALID_PAGE_ID)};
 };
 
 }  // namespace bustub
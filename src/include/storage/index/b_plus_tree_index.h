@@ -23,13 +23,72 @@ namespace bustub {
 
 #define BPLUSTREE_INDEX_TYPE BPlusTreeIndex<KeyType, ValueType, KeyComparator>
 
+/**
+ * Walks a key range of a B+ tree. The entries are copied out of the leaves a batch at a time, so no latch is held
+ * between two calls of Next, while the caller waits for a lock on a tuple for example. The next batch resumes after
+ * the last key copied with a descent from the root, so a batch takes every value of its last key and may grow past
+ * BATCH_SIZE for a duplicate key. The keys are decoded in the key schema on request.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTreeRangeCursor : public IndexRangeCursor {
+ public:
+  static constexpr size_t BATCH_SIZE = 1024;
+
+  BPlusTreeRangeCursor(BPlusTree<KeyType, ValueType, KeyComparator> *tree, const KeyComparator &comparator,
+                       const Schema *key_schema, const KeyType *start_key, const KeyType *end_key);
+
+  bool Next(RID *rid) override;
+
+  /** The key is left empty if it was truncated in the tree */
+  bool Next(RID *rid, std::vector<Value> *key) override;
+
+ private:
+  /** Copies the next batch of the range into rids_ */
+  void Refill();
+
+  BPlusTree<KeyType, ValueType, KeyComparator> *tree_;
+  KeyComparator comparator_;
+  const Schema *key_schema_;
+  // where the next batch starts, after it if resuming
+  KeyType resume_key_;
+  bool has_resume_key_;
+  bool resuming_{false};
+  KeyType end_key_;
+  bool has_end_key_;
+  bool done_{false};
+  std::vector<MappingType> items_;
+  size_t next_{0};
+};
+
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeIndex : public Index {
  public:
-  BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager);
+  /** The default share of a leaf or internal page filled by a bulk load, leaving room for later inserts */
+  static constexpr double DEFAULT_FILL_FACTOR = 0.9;
+
+  /**
+   * @param metadata the index metadata
+   * @param buffer_pool_manager the buffer pool of the tree pages
+   * @param header_page_id the header page that records the root page id of the tree
+   * @param fill_factor the share of each page filled by InsertEntries when it bulk loads the tree
+   * @param unique false lets many entries share a key, the tree then keeps the RIDs of a key in a posting list
+   * @param b_link true builds the tree in B-link mode, see BPlusTree
+   */
+  BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager,
+                 page_id_t header_page_id = HEADER_PAGE_ID, double fill_factor = DEFAULT_FILL_FACTOR,
+                 bool unique = true, bool b_link = false);
 
   void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
+  /**
+   * Sorts the entries and bulk loads them if the tree is empty, else inserts them one at a time. Of the entries with
+   * equal keys only the first is kept in a unique index, as with InsertEntry.
+   */
+  void InsertEntries(IndexEntrySource *entries, Transaction *transaction) override;
+
+  using Index::InsertEntries;
+
+  /** A unique index removes the key whatever its RID, else only the entry of rid is removed */
   void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
@@ -40,9 +99,16 @@ class BPlusTreeIndex : public Index {
 
   INDEXITERATOR_TYPE GetEndIterator();
 
+  std::unique_ptr<IndexRangeCursor> ScanRange(const Tuple *start_key, const Tuple *end_key,
+                                              Transaction *transaction) override;
+
  protected:
   // comparator for key
   KeyComparator comparator_;
+  double fill_factor_;
+  bool unique_;
+  // the bytes stored per key in the tree pages
+  int key_size_;
   // container
   BPlusTree<KeyType, ValueType, KeyComparator> container_;
 };
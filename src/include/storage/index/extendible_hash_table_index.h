@@ -35,10 +35,23 @@ class ExtendibleHashTableIndex : public Index {
 
   void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
+  using Index::InsertEntries;
+
+  void InsertEntries(IndexEntrySource *entries, Transaction *transaction) override;
+
   void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                Transaction *transaction) override;
+
+  /**
+   * @param transaction The transaction context
+   * @return the entry count, bucket fill, depth distribution and overflow risk of the hash table behind the index
+   */
+  ExtendibleHashTableStats GetStats(Transaction *transaction);
+
  protected:
   // comparator for key
   KeyComparator comparator_;
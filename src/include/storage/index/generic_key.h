@@ -12,8 +12,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
 
+#include "storage/table/dictionary.h"
 #include "storage/table/tuple.h"
 #include "type/value.h"
 
@@ -25,39 +30,95 @@ namespace bustub {
  * This key type uses an fixed length array to hold data for indexing
  * purposes, the actual size of which is specified and instantiated
  * with a template argument.
+ *
+ * The columns of the key are stored normalized, one after the other, so that comparing two keys byte for byte
+ * orders them like their values. Integers are stored big-endian with the sign bit flipped, decimals big-endian with
+ * the sign bit flipped if positive and every bit flipped if negative, and strings with each zero byte escaped as
+ * 0x00 0xFF and terminated by 0x00 0x00. The rest of the array is zeroed, equal keys are equal byte arrays. A key
+ * longer than KeySize is truncated, keys that differ only past KeySize compare equal.
  */
 template <size_t KeySize>
 class GenericKey {
  public:
-  inline void SetFromKey(const Tuple &tuple) {
+  inline void SetFromKey(const Tuple &tuple, const Schema *key_schema) {
     // intialize to 0
     memset(data_, 0, KeySize);
-    memcpy(data_, tuple.GetData(), tuple.GetLength());
+    size_t pos = 0;
+    for (uint32_t i = 0; i < key_schema->GetColumnCount(); i++) {
+      const auto &col = key_schema->GetColumn(i);
+      if (col.IsDictionaryEncoded() || !col.IsInlined()) {
+        // a dictionary encoded column orders by its strings, not by its codes
+        PutVarchar(tuple.GetValue(key_schema, i), &pos);
+      } else {
+        PutFixed(tuple.GetData() + col.GetOffset(), col.GetType(), &pos);
+      }
+    }
+  }
+
+  /**
+   * @return the most bytes the normalized columns of key_schema take, the rest of a key is always zero. This is
+   * KeySize if a column is a string.
+   */
+  static inline size_t NormalizedSize(const Schema *key_schema) {
+    size_t size = 0;
+    for (const auto &col : key_schema->GetColumns()) {
+      if (col.GetType() == TypeId::VARCHAR) {
+        return KeySize;
+      }
+      size += FixedWidth(col.GetType());
+    }
+    return std::min(size, KeySize);
   }
 
   // NOTE: for test purpose only
+  // store key as a single BIGINT column
   inline void SetFromInteger(int64_t key) {
     memset(data_, 0, KeySize);
-    memcpy(data_, &key, sizeof(int64_t));
+    size_t pos = 0;
+    PutFixed(reinterpret_cast<const char *>(&key), TypeId::BIGINT, &pos);
   }
 
-  inline Value ToValue(Schema *schema, uint32_t column_idx) const {
-    const char *data_ptr;
+  inline Value ToValue(const Schema *schema, uint32_t column_idx) const {
+    size_t pos = 0;
+    for (uint32_t i = 0; i < column_idx; i++) {
+      const auto &col = schema->GetColumn(i);
+      if (col.GetType() == TypeId::VARCHAR) {
+        GetVarchar(&pos);
+      } else {
+        pos += FixedWidth(col.GetType());
+      }
+    }
     const auto &col = schema->GetColumn(column_idx);
-    const TypeId column_type = col.GetType();
-    const bool is_inlined = col.IsInlined();
-    if (is_inlined) {
-      data_ptr = (data_ + col.GetOffset());
-    } else {
-      int32_t offset = *reinterpret_cast<int32_t *>(const_cast<char *>(data_ + col.GetOffset()));
-      data_ptr = (data_ + offset);
+    if (col.GetType() == TypeId::VARCHAR) {
+      return GetVarchar(&pos);
     }
-    return Value::DeserializeFrom(data_ptr, column_type);
+    return GetFixed(col.GetType(), &pos);
+  }
+
+  /**
+   * Decode every column of the key.
+   * @return false if the key was truncated when it was stored, the values are not those of the key then
+   */
+  inline bool ToValues(const Schema *schema, std::vector<Value> *values) const {
+    values->clear();
+    size_t pos = 0;
+    bool complete = true;
+    for (const auto &col : schema->GetColumns()) {
+      if (col.GetType() == TypeId::VARCHAR) {
+        values->emplace_back(GetVarchar(&pos, &complete));
+      } else {
+        values->emplace_back(GetFixed(col.GetType(), &pos));
+      }
+    }
+    return complete && pos <= KeySize;
   }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
-  inline int64_t ToString() const { return *reinterpret_cast<int64_t *>(const_cast<char *>(data_)); }
+  // interpret the first 8 bytes as a BIGINT column
+  inline int64_t ToString() const {
+    size_t pos = 0;
+    return GetFixed(TypeId::BIGINT, &pos).template GetAs<int64_t>();
+  }
 
   // NOTE: for test purpose only
   // interpret the first 8 bytes as int64_t from data vector
@@ -68,39 +129,194 @@ class GenericKey {
 
   // actual location of data, extends past the end.
   char data_[KeySize];
+
+ private:
+  static inline size_t FixedWidth(TypeId type) {
+    switch (type) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        return sizeof(int8_t);
+      case TypeId::SMALLINT:
+        return sizeof(int16_t);
+      case TypeId::INTEGER:
+        return sizeof(int32_t);
+      default:
+        return sizeof(int64_t);
+    }
+  }
+
+  // Copy up to n bytes to pos, as many as fit before KeySize
+  inline void Put(const void *src, size_t n, size_t *pos) {
+    size_t len = std::min(n, KeySize - std::min(*pos, KeySize));
+    if (len > 0) {
+      memcpy(data_ + *pos, src, len);
+    }
+    *pos += n;
+  }
+
+  // Copy n bytes from pos, the bytes past KeySize read as zero
+  inline void Get(void *dst, size_t n, size_t *pos) const {
+    memset(dst, 0, n);
+    size_t len = std::min(n, KeySize - std::min(*pos, KeySize));
+    if (len > 0) {
+      memcpy(dst, data_ + *pos, len);
+    }
+    *pos += n;
+  }
+
+  inline void PutFixed(const char *src, TypeId type, size_t *pos) {
+    switch (type) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT: {
+        uint8_t v = static_cast<uint8_t>(*src) ^ 0x80U;
+        Put(&v, sizeof(v), pos);
+        break;
+      }
+      case TypeId::SMALLINT: {
+        uint16_t v;
+        memcpy(&v, src, sizeof(v));
+        v = __builtin_bswap16(v ^ 0x8000U);
+        Put(&v, sizeof(v), pos);
+        break;
+      }
+      case TypeId::INTEGER: {
+        uint32_t v;
+        memcpy(&v, src, sizeof(v));
+        v = __builtin_bswap32(v ^ 0x80000000U);
+        Put(&v, sizeof(v), pos);
+        break;
+      }
+      case TypeId::DECIMAL: {
+        uint64_t v;
+        memcpy(&v, src, sizeof(v));
+        v = __builtin_bswap64((v >> 63) != 0 ? ~v : v ^ (1ULL << 63));
+        Put(&v, sizeof(v), pos);
+        break;
+      }
+      case TypeId::TIMESTAMP: {
+        uint64_t v;
+        memcpy(&v, src, sizeof(v));
+        v = __builtin_bswap64(v);
+        Put(&v, sizeof(v), pos);
+        break;
+      }
+      default: {
+        uint64_t v;
+        memcpy(&v, src, sizeof(v));
+        v = __builtin_bswap64(v ^ (1ULL << 63));
+        Put(&v, sizeof(v), pos);
+      }
+    }
+  }
+
+  inline Value GetFixed(TypeId type, size_t *pos) const {
+    switch (type) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT: {
+        uint8_t v;
+        Get(&v, sizeof(v), pos);
+        return Value(type, static_cast<int8_t>(v ^ 0x80U));
+      }
+      case TypeId::SMALLINT: {
+        uint16_t v;
+        Get(&v, sizeof(v), pos);
+        return Value(type, static_cast<int16_t>(__builtin_bswap16(v) ^ 0x8000U));
+      }
+      case TypeId::INTEGER: {
+        uint32_t v;
+        Get(&v, sizeof(v), pos);
+        return Value(type, static_cast<int32_t>(__builtin_bswap32(v) ^ 0x80000000U));
+      }
+      case TypeId::DECIMAL: {
+        uint64_t v;
+        Get(&v, sizeof(v), pos);
+        v = __builtin_bswap64(v);
+        v = (v >> 63) != 0 ? v ^ (1ULL << 63) : ~v;
+        double d;
+        memcpy(&d, &v, sizeof(d));
+        return Value(type, d);
+      }
+      case TypeId::TIMESTAMP: {
+        uint64_t v;
+        Get(&v, sizeof(v), pos);
+        return Value(type, __builtin_bswap64(v));
+      }
+      default: {
+        uint64_t v;
+        Get(&v, sizeof(v), pos);
+        return Value(TypeId::BIGINT, static_cast<int64_t>(__builtin_bswap64(v) ^ (1ULL << 63)));
+      }
+    }
+  }
+
+  inline void PutVarchar(const Value &value, size_t *pos) {
+    uint32_t len = value.IsNull() ? 0 : value.GetLength();
+    const char *str = value.GetData();
+    // the stored length counts the terminating null
+    if (len > 0 && str[len - 1] == '\0') {
+      len--;
+    }
+    static constexpr uint8_t ESCAPE[2] = {0x00, 0xFF};
+    static constexpr uint8_t TERMINATOR[2] = {0x00, 0x00};
+    for (uint32_t i = 0; i < len && *pos < KeySize; i++) {
+      if (str[i] == '\0') {
+        Put(ESCAPE, sizeof(ESCAPE), pos);
+      } else {
+        Put(str + i, 1, pos);
+      }
+    }
+    Put(TERMINATOR, sizeof(TERMINATOR), pos);
+  }
+
+  // complete is cleared if the string runs to the end of the key without its terminator
+  inline Value GetVarchar(size_t *pos, bool *complete = nullptr) const {
+    std::string str;
+    bool terminated = false;
+    while (*pos < KeySize) {
+      char c = data_[(*pos)++];
+      if (c != '\0') {
+        str.push_back(c);
+        continue;
+      }
+      bool escaped = *pos < KeySize && static_cast<uint8_t>(data_[*pos]) == 0xFF;
+      (*pos)++;
+      if (!escaped) {
+        terminated = true;
+        break;
+      }
+      str.push_back('\0');
+    }
+    if (complete != nullptr && !terminated) {
+      *complete = false;
+    }
+    return Value(TypeId::VARCHAR, str);
+  }
 };
 
 /**
  * Function object returns true if lhs < rhs, used for trees
+ *
+ * The keys are normalized, so they compare with a single memcmp and without their schema.
  */
 template <size_t KeySize>
 class GenericComparator {
  public:
   inline int operator()(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const {
-    uint32_t column_count = key_schema_->GetColumnCount();
-
-    for (uint32_t i = 0; i < column_count; i++) {
-      Value lhs_value = (lhs.ToValue(key_schema_, i));
-      Value rhs_value = (rhs.ToValue(key_schema_, i));
-
-      if (lhs_value.CompareLessThan(rhs_value) == CmpBool::CmpTrue) {
-        return -1;
-      }
-      if (lhs_value.CompareGreaterThan(rhs_value) == CmpBool::CmpTrue) {
-        return 1;
-      }
-    }
-    // equals
-    return 0;
+    int cmp = memcmp(lhs.data_, rhs.data_, KeySize);
+    return (cmp > 0) - (cmp < 0);
   }
 
-  GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
+  GenericComparator(const GenericComparator &other) = default;
 
   // constructor
-  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
-
- private:
-  Schema *key_schema_;
+  explicit GenericComparator(Schema *key_schema) {}
 };
 
+/** True for the comparators of normalized generic keys, which compare the key bytes with memcmp */
+template <typename KeyComparator>
+struct IsGenericComparator : std::false_type {};
+
+template <size_t KeySize>
+struct IsGenericComparator<GenericComparator<KeySize>> : std::true_type {};
+
 }  // namespace bustub
@@ -100,6 +100,71 @@ class IndexMetadata {
 // Index class definition
 /////////////////////////////////////////////////////////////////////
 
+/**
+ * A cursor over a key range of an ordered index, see Index::ScanRange.
+ */
+class IndexRangeCursor {
+ public:
+  virtual ~IndexRangeCursor() = default;
+
+  /**
+   * Move to the next entry of the range, in key order.
+   * @param[out] rid The RID of the entry
+   * @return false once the range is exhausted
+   */
+  virtual bool Next(RID *rid) = 0;
+
+  /**
+   * Move to the next entry of the range, in key order, and decode its key. An index whose keys cannot be decoded
+   * returns no key values, the default does so for every entry.
+   * @param[out] rid The RID of the entry
+   * @param[out] key The values of the key columns in the key schema, or empty if the key is not known
+   * @return false once the range is exhausted
+   */
+  virtual bool Next(RID *rid, std::vector<Value> *key) {
+    key->clear();
+    return Next(rid);
+  }
+};
+
+/**
+ * The entries of a batch insert, see Index::InsertEntries. They are produced one at a time so that an index built
+ * from a whole table does not need a copy of every key first.
+ */
+class IndexEntrySource {
+ public:
+  virtual ~IndexEntrySource() = default;
+
+  /**
+   * Move to the next entry.
+   * @param[out] key The key of the entry, in the key schema of the index
+   * @param[out] rid The RID associated with the key
+   * @return false once there are no more entries
+   */
+  virtual bool Next(Tuple *key, RID *rid) = 0;
+};
+
+/** The entries of keys and rids, rids[i] is the RID associated with keys[i]. */
+class IndexEntryVectorSource : public IndexEntrySource {
+ public:
+  IndexEntryVectorSource(const std::vector<Tuple> &keys, const std::vector<RID> &rids) : keys_(keys), rids_(rids) {}
+
+  bool Next(Tuple *key, RID *rid) override {
+    if (next_ == keys_.size()) {
+      return false;
+    }
+    *key = keys_[next_];
+    *rid = rids_[next_];
+    next_++;
+    return true;
+  }
+
+ private:
+  const std::vector<Tuple> &keys_;
+  const std::vector<RID> &rids_;
+  size_t next_{0};
+};
+
 /**
  * class Index - Base class for derived indices of different types
  *
@@ -159,6 +224,31 @@ class Index {
    */
   virtual void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) = 0;
 
+  /**
+   * Insert a batch of entries, e.g. every entry of a table when the index is created. Indexes that can build
+   * themselves faster from the whole batch override this, the default inserts the entries one at a time.
+   * @param entries The entries to insert
+   * @param transaction The transaction context
+   */
+  virtual void InsertEntries(IndexEntrySource *entries, Transaction *transaction) {
+    Tuple key;
+    RID rid;
+    while (entries->Next(&key, &rid)) {
+      InsertEntry(key, rid, transaction);
+    }
+  }
+
+  /**
+   * Insert a batch of entries already collected in vectors.
+   * @param keys The index keys
+   * @param rids rids[i] is the RID associated with keys[i]
+   * @param transaction The transaction context
+   */
+  void InsertEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids, Transaction *transaction) {
+    IndexEntryVectorSource entries(keys, rids);
+    InsertEntries(&entries, transaction);
+  }
+
   /**
    * Delete an index entry by key.
    * @param key The index key
@@ -175,6 +265,35 @@ class Index {
    */
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  /**
+   * Search the index for a batch of keys. Indexes that can share work between the keys override this,
+   * the default searches the keys one at a time.
+   * @param keys The index keys
+   * @param results results[i] is populated with the RIDs of keys[i]
+   * @param transaction The transaction context
+   */
+  virtual void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                        Transaction *transaction) {
+    results->clear();
+    results->resize(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      ScanKey(keys[i], &(*results)[i], transaction);
+    }
+  }
+
+  /**
+   * Open a cursor over the entries whose keys lie in [start_key, end_key], in key order. Only ordered indexes
+   * support this, the default returns nullptr.
+   * @param start_key The lowest key of the range, or nullptr to start at the first entry
+   * @param end_key The highest key of the range, or nullptr to run to the last entry
+   * @param transaction The transaction context
+   * @return The cursor, or nullptr if the index is not ordered
+   */
+  virtual std::unique_ptr<IndexRangeCursor> ScanRange(const Tuple *start_key, const Tuple *end_key,
+                                                      Transaction *transaction) {
+    return nullptr;
+  }
+
  private:
   /** The Index structure owns its metadata */
   std::unique_ptr<IndexMetadata> metadata_;
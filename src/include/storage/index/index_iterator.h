@@ -13,31 +13,87 @@
  * For range scan of b+ tree
  */
 #pragma once
+
+#include "buffer/buffer_pool_manager.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/b_plus_tree_posting_page.h"
 
 namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+/**
+ * Walks the leaf chain of a B+ tree in key order. Only the current leaf is pinned and read latched, so the pair under
+ * the iterator stays valid. The next leaf is latched before the current one is released; writers latch sibling
+ * leaves from left to right as well, so the two never deadlock and no pair is lost to a merge or a redistribution
+ * between two leaves.
+ *
+ * On entering a leaf the iterator asks the buffer pool to prefetch the next one, so its read overlaps with the scan of
+ * the current leaf. The prefetched leaf is not pinned, a merge can still delete it.
+ *
+ * A duplicate key yields one pair per value of its inline list or its posting list, in the order of the list. The
+ * posting page under the iterator is pinned as well, the leaf latch covers it.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+
  public:
-  // you may define your own constructor based on your member variables
-  IndexIterator();
+  /**
+   * @param buffer_pool_manager the buffer pool of the tree
+   * @param page the leaf to start on, pinned and read latched, or nullptr for the end iterator
+   * @param index the index in the leaf of the first pair, the iterator moves on if it is past the last one
+   */
+  IndexIterator(BufferPoolManager *buffer_pool_manager, Page *page, int index);
   ~IndexIterator();
 
+  IndexIterator(IndexIterator &&other) noexcept;
+  IndexIterator &operator=(IndexIterator &&other) noexcept;
+  IndexIterator(const IndexIterator &) = delete;
+  IndexIterator &operator=(const IndexIterator &) = delete;
+
   bool IsEnd();
 
   const MappingType &operator*();
 
   IndexIterator &operator++();
 
-  bool operator==(const IndexIterator &itr) const { throw std::runtime_error("unimplemented"); }
+  bool operator==(const IndexIterator &itr) const {
+    return page_ == itr.page_ && (page_ == nullptr || index_ == itr.index_);
+  }
 
-  bool operator!=(const IndexIterator &itr) const { throw std::runtime_error("unimplemented"); }
+  bool operator!=(const IndexIterator &itr) const { return !(*this == itr); }
 
  private:
-  // add your own private member variables here
+  /** Moves to the first pair at or after index_ in the leaf chain */
+  void SkipToValid();
+
+  /** Hints the buffer pool to read the leaf after the current one */
+  void PrefetchNextLeaf();
+
+  /** Enters the inline list or pins the posting list of the pair at index_ if it has one */
+  void EnterPostingList();
+
+  /** Moves to the next value of the inline list or the posting list, @return false if it was the last one */
+  bool NextPostingValue();
+
+  /** Unpins the current posting page */
+  void ReleasePostingPage();
+
+  /** Unlatches and unpins the current leaf */
+  void Release();
+
+  BufferPoolManager *buffer_pool_manager_;
+  Page *page_;
+  LeafPage *leaf_;
+  int index_;
+  // the posting page under the iterator, if the key at index_ has a posting list, or the size of its inline list, and
+  // the index of the value in the list or the page
+  Page *posting_page_{nullptr};
+  int inline_size_{0};
+  int posting_index_{0};
+  // the pair under the iterator, copied out of the leaf by operator*
+  MappingType item_;
 };
 
 }  // namespace bustub
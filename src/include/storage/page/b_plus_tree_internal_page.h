@@ -17,8 +17,8 @@
 namespace bustub {
 
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
-#define INTERNAL_PAGE_HEADER_SIZE 24
-#define INTERNAL_PAGE_SIZE ((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
+#define INTERNAL_PAGE_HEADER_SIZE 32
+#define INTERNAL_PAGE_SIZE ((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE - sizeof(KeyType)) / (sizeof(MappingType)))
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
@@ -29,14 +29,34 @@ namespace bustub {
  *
  * Internal page format (keys are stored in increasing order):
  *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
+ * | HEADER | HIGH KEY | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
  *  --------------------------------------------------------------------------
+ *
+ * The HEADER is the one of BPlusTreePage followed by NextPageId (4), 32 bytes in total. Each KEY takes the KeySize
+ * bytes given in the header, see BPlusTreePage.
+ *
+ * NextPageId links the page to its right sibling on the same level, and once it is set HIGH KEY is the separator of
+ * that sibling: the subtree of this page only holds keys less than it. Both are kept like the ones of a leaf page.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
  public:
   // must call initialize method after "create" a new node
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = INTERNAL_PAGE_SIZE);
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = INTERNAL_PAGE_SIZE,
+            int key_size = sizeof(KeyType));
+  // @return the number of children that fit in a page storing key_size bytes per key
+  static int Capacity(int key_size) {
+    return (PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE - key_size) / (key_size + static_cast<int>(sizeof(ValueType)));
+  }
+
+  page_id_t GetNextPageId() const;
+  void SetNextPageId(page_id_t next_page_id);
+  KeyType GetHighKey() const;
+  void SetHighKey(const KeyType &key);
+  // @return true if key belongs to the subtree of a page right of this one
+  bool IsPastHighKey(const KeyType &key, const KeyComparator &comparator) const {
+    return next_page_id_ != INVALID_PAGE_ID && CompareStoredKey(array_, GetKeySize(), key, comparator) <= 0;
+  }
 
   KeyType KeyAt(int index) const;
   void SetKeyAt(int index, const KeyType &key);
@@ -46,6 +66,8 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   ValueType Lookup(const KeyType &key, const KeyComparator &comparator) const;
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
   int InsertNodeAfter(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
+  // append a child whose parent page id is already set to this page, used by bulk loading
+  void Append(const KeyType &key, const ValueType &value);
   void Remove(int index);
   ValueType RemoveAndReturnOnlyChild();
 
@@ -58,9 +80,18 @@ class BPlusTreeInternalPage : public BPlusTreePage {
                          BufferPoolManager *buffer_pool_manager);
 
  private:
-  void CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager);
-  void CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager);
-  void CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager);
-  MappingType array_[0];
+  int SlotSize() const { return GetKeySize() + static_cast<int>(sizeof(ValueType)); }
+  // the slots follow the high key
+  char *SlotAt(int index) { return array_ + GetKeySize() + index * SlotSize(); }
+  const char *SlotAt(int index) const { return array_ + GetKeySize() + index * SlotSize(); }
+  void SetValueAt(int index, const ValueType &value);
+  // shift the entries [from, size) to start at to
+  void ShiftItems(int to, int from);
+  void CopyNFrom(const char *items, int size, BufferPoolManager *buffer_pool_manager);
+  void CopyLastFrom(const KeyType &key, const ValueType &value, BufferPoolManager *buffer_pool_manager);
+  void CopyFirstFrom(const KeyType &key, const ValueType &value, BufferPoolManager *buffer_pool_manager);
+  void Adopt(page_id_t child_page_id, BufferPoolManager *buffer_pool_manager);
+  page_id_t next_page_id_;
+  char array_[0];
 };
 }  // namespace bustub
@@ -10,64 +10,193 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <climits>
 #include <utility>
 #include <vector>
 
+#include "common/rid.h"
 #include "storage/page/b_plus_tree_page.h"
 
 namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
-#define LEAF_PAGE_HEADER_SIZE 28
-#define LEAF_PAGE_SIZE ((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+#define LEAF_PAGE_HEADER_SIZE 44
+#define LEAF_PAGE_SIZE ((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE - sizeof(KeyType)) / sizeof(MappingType))
+
+// The slot number of a leaf value that refers to an inline list of its leaf, its page id is the offset of the list in
+// the page. A record never has this slot number.
+static constexpr uint32_t INLINE_LIST_SLOT = UINT32_MAX - 1;
+
+// The most values an inline list holds, a key with more of them has a posting list
+static constexpr int INLINE_LIST_MAX_SIZE = 16;
+
+/** @return true if the leaf value rid refers to an inline list */
+inline bool IsInlineList(const RID &rid) { return rid.GetSlotNum() == INLINE_LIST_SLOT; }
+
+/** @return the leaf value that refers to the inline list at offset of its leaf */
+inline RID InlineListRef(int offset) { return RID(offset, INLINE_LIST_SLOT); }
 
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
  * see include/common/rid.h for detailed implementation) together within leaf
- * page. Only support unique key.
+ * page. Every key is stored once, in a tree that allows duplicate keys the value
+ * of a key with several records refers to an inline list of the page, or to a
+ * posting list once it has more records than an inline list holds (see
+ * BPlusTreePostingPage).
  *
  * Leaf page format (keys are stored in order):
- *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
- *  ----------------------------------------------------------------------
+ *  ----------------------------------------------------------------------------------------------------------------
+ * | HEADER | HIGH KEY | LOW KEY | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n) | FREE | INLINE LISTS |
+ *  ----------------------------------------------------------------------------------------------------------------
  *
- *  Header format (size in byte, 28 bytes in total):
+ *  Header format (size in byte, 44 bytes in total):
  *  ---------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  *  ---------------------------------------------------------------------
- *  -----------------------------------------------
- * | ParentPageId (4) | PageId (4) | NextPageId (4)
- *  -----------------------------------------------
+ *  ------------------------------------------------------------------
+ * | ParentPageId (4) | PageId (4) | KeySize (4) | NextPageId (4) | InlineSize (4)
+ *  ------------------------------------------------------------------
+ *  ------------------------------------------------------------------
+ * | PrefixSize (4) | HasLowKey (4)
+ *  ------------------------------------------------------------------
+ *
+ * Every key of the page lies between its fence keys, LOW KEY and HIGH KEY, which are the separators of the page in
+ * its parent. The leftmost leaf has no low key and the rightmost no high key. Keys are stored normalized (see
+ * GenericKey), so every key between the fences starts with the bytes the fences have in common. The first PrefixSize
+ * of them are stored once, as the start of HIGH KEY, and each KEY only takes the KeySize - PrefixSize bytes after
+ * them. The prefix only changes with the fences, when the page is split, merged or redistributed, an insert never
+ * changes it. Keys of other comparators are stored whole. A pair takes KeySize - PrefixSize + sizeof(RID) bytes, so
+ * the pairs are not aligned.
+ *
+ * An inline list is a count (4) followed by the RIDs of a key sorted by RID::Get. The lists are packed at the end of
+ * the page and take InlineSize bytes, growing towards the pairs. A page keeps room for the pair of one more key, the
+ * one whose insert splits it, so a page whose lists leave no room for that pair has to split before it is at its max
+ * size.
+ *
+ * NextPageId is the right link of the leaf. Once a leaf has a right sibling, HIGH KEY is the first key that belongs to
+ * the sibling, every key in the leaf is less than it. A reader that reached the leaf through a stale parent sees that
+ * its key is past the high key and follows the right link, see BPlusTree's B-link mode.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
  public:
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = LEAF_PAGE_SIZE);
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = LEAF_PAGE_SIZE,
+            int key_size = sizeof(KeyType));
+  // @return the number of pairs that fit in a page storing key_size bytes per key
+  static int Capacity(int key_size) {
+    return (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE - 2 * key_size) / (key_size + static_cast<int>(sizeof(ValueType)));
+  }
+  // @return the number of pairs that fit in a page whose keys are all in its prefix, Capacity if keys are stored whole
+  static int MaxCapacity(int key_size) {
+    if constexpr (IsGenericComparator<KeyComparator>::value) {  // NOLINT
+      return (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE - 2 * key_size) / static_cast<int>(sizeof(ValueType));
+    } else {
+      return Capacity(key_size);
+    }
+  }
   // helper methods
   page_id_t GetNextPageId() const;
+  // the next page id is set before the high key, the prefix is only kept while the page has both fences
   void SetNextPageId(page_id_t next_page_id);
+  KeyType GetHighKey() const;
+  void SetHighKey(const KeyType &key);
+  bool HasLowKey() const { return has_low_key_ != 0; }
+  KeyType GetLowKey() const;
+  void SetLowKey(const KeyType &key);
+  int GetPrefixSize() const { return prefix_size_; }
+  // @return true if key belongs to a leaf right of this one
+  bool IsPastHighKey(const KeyType &key, const KeyComparator &comparator) const {
+    return next_page_id_ != INVALID_PAGE_ID && CompareStoredKey(array_, GetKeySize(), key, comparator) <= 0;
+  }
   KeyType KeyAt(int index) const;
+  ValueType ValueAt(int index) const;
+  // the inline list of the old value, if it has one, is dropped
+  void SetValueAt(int index, const ValueType &value);
   int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
-  const MappingType &GetItem(int index);
+  // @return the index of key, or -1 if it is not in the page
+  int FindKey(const KeyType &key, const KeyComparator &comparator) const;
+  MappingType GetItem(int index) const;
 
   // insert and delete methods
   int Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator);
+  // append a pair greater than every key in the page, used by bulk loading
+  void Append(const KeyType &key, const ValueType &value);
   bool Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const;
   int RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator);
 
-  // Split and Merge utility methods
+  // room
+  // @return the bytes of a pair with a prefix of prefix_size bytes
+  int SlotSize(int prefix_size) const { return GetKeySize() - prefix_size + static_cast<int>(sizeof(ValueType)); }
+  int SlotSize() const { return SlotSize(prefix_size_); }
+  // @return the bytes the fence keys leave to the pairs and the inline lists
+  int SlotArea() const { return PAGE_SIZE - LEAF_PAGE_HEADER_SIZE - 2 * GetKeySize(); }
+  // @return the bytes the pairs take with a prefix of prefix_size bytes
+  int PairBytes(int prefix_size) const { return GetSize() * SlotSize(prefix_size); }
+  // @return the bytes the pairs and the inline lists take, the room the page needs in a page it is merged into
+  int UsedBytes(int prefix_size) const { return PairBytes(prefix_size) + inline_size_; }
+  int UsedBytes() const { return UsedBytes(prefix_size_); }
+  // @return the bytes left once room is kept for one more pair, negative once the pair is taken and the page must split
+  int FreeBytes(int prefix_size) const { return SlotArea() - UsedBytes(prefix_size) - SlotSize(prefix_size); }
+  int FreeBytes() const { return FreeBytes(prefix_size_); }
+  // @return true if the page must split, it is at its max size or out of room
+  bool IsFull() const { return GetSize() >= GetMaxSize() || FreeBytes() < 0; }
+  // @return true if the page is under its min size and uses less than half of its room
+  bool IsUnderfull() const { return GetSize() < GetMinSize() && 2 * UsedBytes() < SlotArea(); }
+  // @return the prefix size of the page once right, its right sibling, is merged into it
+  int PrefixSizeAfterMerge(const BPlusTreeLeafPage *right) const;
+  // @return the prefix size of the page once its fence is key, key is in the sibling the fence is shared with
+  int PrefixSizeWithHighKey(const KeyType &key) const;
+  int PrefixSizeWithLowKey(const KeyType &key) const;
+
+  // inline lists
+  // @return the bytes taken by an inline list of count values
+  static int InlineListBytes(int count) { return static_cast<int>(sizeof(int32_t) + count * sizeof(ValueType)); }
+  int InlineListSize(const ValueType &ref) const;
+  ValueType InlineListValueAt(const ValueType &ref, int index) const;
+  // Give the key at index the count values sorted at values as an inline list, replacing its value or inline list.
+  // The growth of the list must be within FreeBytes.
+  void SetInlineList(int index, const ValueType *values, int count);
+
+  // Split and Merge utility methods, the inline lists of the pairs move with them and the fences of both pages are
+  // updated. The recipient of a merge or a redistribution must have room for the pairs with its new prefix.
   void MoveHalfTo(BPlusTreeLeafPage *recipient);
   void MoveAllTo(BPlusTreeLeafPage *recipient);
   void MoveFirstToEndOf(BPlusTreeLeafPage *recipient);
   void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
 
  private:
-  void CopyNFrom(MappingType *items, int size);
-  void CopyLastFrom(const MappingType &item);
-  void CopyFirstFrom(const MappingType &item);
+  // the slots follow the fence keys
+  char *SlotAt(int index) { return array_ + 2 * GetKeySize() + index * SlotSize(); }
+  const char *SlotAt(int index) const { return array_ + 2 * GetKeySize() + index * SlotSize(); }
+  // the bytes of a key stored in its slot
+  int SuffixSize() const { return GetKeySize() - prefix_size_; }
+  // compare the key at index with key, its prefix first
+  int CompareKeyAt(int index, const KeyType &key, const KeyComparator &comparator) const;
+  void SetItem(int index, const KeyType &key, const ValueType &value);
+  // shift the pairs [from, size) to start at to
+  void ShiftItems(int to, int from);
+  // append the n pairs of donor from index
+  void CopyNFrom(const BPlusTreeLeafPage *donor, int index, int n);
+  void CopyLastFrom(const KeyType &key, const ValueType &value);
+  void CopyFirstFrom(const KeyType &key, const ValueType &value);
+  // write the value of a slot, leaving the inline list it refers to as it is
+  void SetSlotValue(int index, const ValueType &value);
+  char *InlineListAt(int offset) { return reinterpret_cast<char *>(this) + offset; }
+  const char *InlineListAt(int offset) const { return reinterpret_cast<const char *>(this) + offset; }
+  // Copy the inline lists of donor that the n pairs from index refer to, the pairs were copied from donor
+  void CopyInlineListsFrom(const BPlusTreeLeafPage *donor, int index, int n);
+  // Drop the inline lists no pair refers to, and pack the others at the end of the page
+  void CompactInlineLists();
+  // @return the bytes the fences low and high have in common, 0 if one of them is missing
+  int FencePrefixSize(const char *low, const char *high) const;
+  // Store the pairs with the prefix the fences have now, prefix holds the bytes of the old prefix
+  void UpdatePrefix(const char *prefix);
   page_id_t next_page_id_;
-  MappingType array_[0];
+  int inline_size_;
+  int prefix_size_;
+  int has_low_key_;
+  char array_[0];
 };
 }  // namespace bustub
@@ -13,10 +13,13 @@
 #include <cassert>
 #include <climits>
 #include <cstdlib>
+#include <cstring>
 #include <string>
+#include <type_traits>
 
 #include "buffer/buffer_pool_manager.h"
 #include "storage/index/generic_key.h"
+#include "storage/index/int_comparator.h"
 
 namespace bustub {
 
@@ -25,7 +28,63 @@ namespace bustub {
 #define INDEX_TEMPLATE_ARGUMENTS template <typename KeyType, typename ValueType, typename KeyComparator>
 
 // define page type enum
-enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
+enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE, POSTING_PAGE };
+
+/**
+ * Compare the key stored in the first key_size bytes of slot, the rest of it being zero, with key.
+ * Normalized generic keys are compared in place with memcmp and integer keys as integers, so the comparator is
+ * picked at compile time and the stored key is not copied out of the page. Other comparators get a copy.
+ * A generic key may be stored without its first prefix_size bytes, which the caller has found equal to those of key.
+ */
+template <typename KeyType, typename KeyComparator>
+inline int CompareStoredKey(const char *slot, int key_size, const KeyType &key, const KeyComparator &comparator,
+                            int prefix_size = 0) {
+  if constexpr (std::is_same_v<KeyComparator, IntComparator>) {
+    int stored;
+    memcpy(&stored, slot, sizeof(int));
+    return static_cast<int>(stored > key) - static_cast<int>(stored < key);
+  } else if constexpr (IsGenericComparator<KeyComparator>::value) {  // NOLINT
+    int cmp = memcmp(slot, key.data_ + prefix_size, key_size - prefix_size);
+    if (cmp != 0) {
+      return cmp > 0 ? 1 : -1;
+    }
+    // the stored key is zero past key_size, key is greater if it is not
+    for (size_t i = static_cast<size_t>(key_size); i < sizeof(KeyType); i++) {
+      if (key.data_[i] != 0) {
+        return -1;
+      }
+    }
+    return 0;
+  } else {
+    KeyType stored;
+    memcpy(&stored, slot, key_size);
+    memset(reinterpret_cast<char *>(&stored) + key_size, 0, sizeof(KeyType) - key_size);
+    return comparator(stored, key);
+  }
+}
+
+/**
+ * Search n slots of slot_size bytes, sorted by the keys at their start.
+ * @return the first index whose key is not less than key, or with UPPER the first index whose key is greater
+ * The search halves the range without branching on the comparison, the next probe is picked with a conditional move,
+ * so it does not stall on mispredicted comparisons.
+ */
+template <bool UPPER, typename KeyType, typename KeyComparator>
+inline int SearchStoredKeys(const char *slots, int n, int slot_size, int key_size, const KeyType &key,
+                            const KeyComparator &comparator, int prefix_size = 0) {
+  if (n == 0) {
+    return 0;
+  }
+  int base = 0;
+  while (n > 1) {
+    int half = n / 2;
+    int cmp = CompareStoredKey(slots + (base + half - 1) * slot_size, key_size, key, comparator, prefix_size);
+    base = (UPPER ? cmp <= 0 : cmp < 0) ? base + half : base;
+    n -= half;
+  }
+  int cmp = CompareStoredKey(slots + base * slot_size, key_size, key, comparator, prefix_size);
+  return base + static_cast<int>(UPPER ? cmp <= 0 : cmp < 0);
+}
 
 /**
  * Both internal and leaf page are inherited from this page.
@@ -33,12 +92,16 @@ enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
  * It actually serves as a header part for each B+ tree page and
  * contains information shared by both leaf page and internal page.
  *
- * Header format (size in byte, 24 bytes in total):
+ * Header format (size in byte, 28 bytes in total):
  * ----------------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  * ----------------------------------------------------------------------------
- * | ParentPageId (4) | PageId(4) |
+ * | ParentPageId (4) | PageId(4) | KeySize (4) |
  * ----------------------------------------------------------------------------
+ *
+ * KeySize is the number of bytes stored per key. The keys of an index are stored normalized and zero padded (see
+ * GenericKey), so a tree whose keys never take more than KeySize bytes stores only that prefix of each key and fits
+ * more keys in a page.
  */
 class BPlusTreePage {
  public:
@@ -62,14 +125,18 @@ class BPlusTreePage {
 
   void SetLSN(lsn_t lsn = INVALID_LSN);
 
+  int GetKeySize() const;
+  void SetKeySize(int key_size);
+
  private:
   // member variable, attributes that both internal and leaf page share
-  IndexPageType page_type_ __attribute__((__unused__));
-  lsn_t lsn_ __attribute__((__unused__));
-  int size_ __attribute__((__unused__));
-  int max_size_ __attribute__((__unused__));
-  page_id_t parent_page_id_ __attribute__((__unused__));
-  page_id_t page_id_ __attribute__((__unused__));
+  IndexPageType page_type_;
+  lsn_t lsn_;
+  int size_;
+  int max_size_;
+  page_id_t parent_page_id_;
+  page_id_t page_id_;
+  int key_size_;
 };
 
 }  // namespace bustub
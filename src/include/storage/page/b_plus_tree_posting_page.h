@@ -0,0 +1,78 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/include/page/b_plus_tree_posting_page.h
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <climits>
+
+#include "common/rid.h"
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+#define POSTING_PAGE_HEADER_SIZE 32
+#define POSTING_PAGE_SIZE static_cast<int>((PAGE_SIZE - POSTING_PAGE_HEADER_SIZE) / sizeof(RID))
+
+// The slot number of a leaf value that refers to a posting list, its page id is the first page of the list. A record
+// never has this slot number.
+static constexpr uint32_t POSTING_LIST_SLOT = UINT32_MAX;
+
+/** @return true if the leaf value rid refers to a posting list */
+inline bool IsPostingList(const RID &rid) { return rid.GetSlotNum() == POSTING_LIST_SLOT; }
+
+/** @return the leaf value that refers to the posting list starting on page_id */
+inline RID PostingListRef(page_id_t page_id) { return RID(page_id, POSTING_LIST_SLOT); }
+
+/**
+ * Store the record ids of one key of a B+ tree that allows duplicate keys. The leaf keeps the key once, and its value
+ * refers to the first page of a chain of posting pages, so a key with many records takes one slot of the leaf and
+ * the records are read as a compact array.
+ *
+ * Posting page format (record ids are sorted by RID::Get, across the whole chain):
+ *  ------------------------------------------------
+ * | HEADER | RID(1) | RID(2) | ... | RID(n) |
+ *  ------------------------------------------------
+ *
+ * The HEADER is the one of BPlusTreePage followed by NextPageId (4), 32 bytes in total. NextPageId links the page to
+ * the next one of the chain, a page that is full is split in two like a leaf.
+ *
+ * Posting pages are only reached through the slot of their key, so they take no latch of their own: they are read
+ * and written under the latch of the leaf holding the key.
+ */
+class BPlusTreePostingPage : public BPlusTreePage {
+ public:
+  void Init(page_id_t page_id, int max_size = POSTING_PAGE_SIZE);
+
+  page_id_t GetNextPageId() const { return next_page_id_; }
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  RID ValueAt(int index) const { return array_[index]; }
+
+  /** @return the first index whose record id is not less than rid */
+  int ValueIndex(const RID &rid) const;
+
+  /** Insert rid in order, the page must not be full. @return false if rid is in the page already */
+  bool Insert(const RID &rid);
+
+  /** Append a record id greater than every one in the page, used by bulk loading */
+  void Append(const RID &rid);
+
+  /** @return false if rid is not in the page */
+  bool Remove(const RID &rid);
+
+  /** Move the upper half of the record ids to the empty page recipient */
+  void MoveHalfTo(BPlusTreePostingPage *recipient);
+
+ private:
+  page_id_t next_page_id_;
+  RID array_[0];
+};
+
+}  // namespace bustub
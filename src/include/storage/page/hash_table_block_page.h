@@ -32,6 +32,10 @@ namespace bustub {
  *
  *  Here '+' means concatenation.
  *
+ *  A slot goes from empty to occupied exactly once, and its key and value are written before it becomes readable
+ *  and never change afterwards. A removed slot stays occupied as a tombstone, so probe sequences that run through
+ *  it are not cut short. This lets readers scan a block without any latch: a slot they see readable holds a
+ *  complete pair. Tombstones are only reclaimed by resizing the table.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class HashTableBlockPage {
@@ -71,7 +75,7 @@ class HashTableBlockPage {
   bool Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value);
 
   /**
-   * Removes a key and value at index.
+   * Removes a key and value at index, leaving a tombstone.
    *
    * @param bucket_ind ind to remove the value
    */
@@ -93,50 +97,10 @@ class HashTableBlockPage {
    */
   bool IsReadable(slot_offset_t bucket_ind) const;
 
-  /**
-   * Scan the bucket and collect values that have the matching key
-   *
-   * @return true if at least one key matched
-   */
-  bool GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result);
-
-  /**
-   * Attempts to insert a key and value in the bucket.
-   * The insert is thread safe. It uses compare and swap to claim the index,
-   * and then writes the key and value into the index, and then marks the
-   * index as readable.
-   *
-   * @param key key to insert
-   * @param value value to insert
-   * @return true if inserted, false if duplicate KV pair or bucket is full
-   */
-  bool Insert(KeyType key, ValueType value, KeyComparator cmp);
-
-  /**
-   * Removes a key and value.
-   * @return true if removed, false if not found
-   */
-  bool Remove(KeyType key, ValueType value, KeyComparator cmp);
-
   /**
    * @return the number of readable elements, i.e. current size
    */
-  uint32_t NumReadable();
-
-  /**
-   * @return whether the bucket is full
-   */
-  bool IsFull();
-
-  /**
-   * @return whether the bucket is empty
-   */
-  bool IsEmpty();
-
-  /**
-   * Prints the bucket's occupancy information
-   */
-  void PrintBucket();
+  uint32_t NumReadable() const;
 
  private:
   std::atomic_char occupied_[(BLOCK_ARRAY_SIZE - 1) / 8 + 1];
@@ -33,6 +33,9 @@ namespace bustub {
  *  The above format omits the space required for the occupied_ and
  *  readable_ arrays. More information is in storage/page/hash_table_page_defs.h.
  *
+ *  Every slot also has a one byte fingerprint of its key in the dense fingerprints_ array. Lookups compare the
+ *  fingerprints of 32 slots at a time (AVX2/SSE2 when available) and only call the key comparator on the readable
+ *  slots whose fingerprint matches.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class HashTableBucketPage {
@@ -139,15 +142,55 @@ class HashTableBucketPage {
 
   void Clear();
 
-  MappingType *GetArrayCopy();
+  /**
+   * Writes a pair to a slot without looking for a duplicate first. Used to fill a fresh bucket from pairs that are
+   * known to be distinct.
+   *
+   * @param bucket_idx a slot that is not readable
+   * @param key key to write
+   * @param value value to write
+   */
+  void InsertAt(uint32_t bucket_idx, const KeyType &key, const ValueType &value);
+
+  /**
+   * Moves the pair at bucket_idx to slot image_idx of another bucket, fingerprint included, so the key is neither
+   * hashed nor compared again. The slot in this bucket becomes a tombstone.
+   *
+   * @param bucket_idx a readable slot of this bucket
+   * @param image the bucket to move the pair to
+   * @param image_idx a slot of image that is not readable
+   */
+  void MoveAt(uint32_t bucket_idx, HashTableBucketPage *image, uint32_t image_idx);
+
+  /**
+   * Moves every pair of another bucket into the free slots of this one, without rehashing. Used to merge a bucket
+   * with its split image, the pairs of both must fit.
+   *
+   * @param other the bucket to empty
+   */
+  void MergeFrom(HashTableBucketPage *other);
+
+  /** @return the one byte fingerprint stored for a key */
+  static uint8_t Fingerprint(const KeyType &key);
 
  private:
+  /** @return the readable bits of the slots [start, start + 32), bit i is slot start + i */
+  uint32_t ReadableWord(uint32_t start) const;
+
+  /** @return the readable slots of [start, start + 32) whose fingerprint equals fingerprint, as a bit mask */
+  uint32_t MatchFingerprint(uint32_t start, uint8_t fingerprint) const;
+
+  /** @return the index of the first non-readable slot, or BUCKET_ARRAY_SIZE if the bucket is full */
+  uint32_t FindFreeSlot() const;
+
   //  For more on BUCKET_ARRAY_SIZE see storage/page/hash_table_page_defs.h
   char occupied_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
   // The ith bit of `occupied_` is 1 if the ith index of `array_` has ever been occupied
   // 0 if tombstone/brand new (never occupied), 1 otherwise.
   char readable_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
   // The ith bit of `readable_` is 1 if the ith index of `array_` holds a readable value
+  uint8_t fingerprints_[BUCKET_ARRAY_SIZE];
+  // The ith byte of `fingerprints_` is the fingerprint of the key in the ith index of `array_`
   MappingType array_[BUCKET_ARRAY_SIZE];  //  The array that holds the key-value pairs
 };
 
@@ -0,0 +1,59 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_directory_index_page.h
+//
+// Identification: src/include/storage/page/hash_table_directory_index_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/config.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+
+/**
+ *
+ * Directory index page for extendible hash table, the level between the root directory page and the directory
+ * pages. The directory_idx'th directory page is listed at index directory_idx % DIRECTORY_INDEX_ARRAY_SIZE of the
+ * directory index page IndexPageIds[directory_idx / DIRECTORY_INDEX_ARRAY_SIZE] of the root.
+ *
+ * Directory index format (size in byte):
+ * ----------------------------------------------------------
+ * | LSN (4) | PageId(4) | DirectoryPageIds(2048) | Free(2040)
+ * ----------------------------------------------------------
+ */
+class HashTableDirectoryIndexPage {
+ public:
+  /** @return the page ID of this page */
+  page_id_t GetPageId() const { return page_id_; }
+
+  /** Sets the page ID of this page */
+  void SetPageId(page_id_t page_id) { page_id_ = page_id; }
+
+  /** @return the lsn of this page */
+  lsn_t GetLSN() const { return lsn_; }
+
+  /** Sets the LSN of this page */
+  void SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+  /** @return the page id of the directory page at index_idx */
+  page_id_t GetDirectoryPageId(uint32_t index_idx) const { return directory_page_ids_[index_idx]; }
+
+  /** Sets the page id of the directory page at index_idx */
+  void SetDirectoryPageId(uint32_t index_idx, page_id_t page_id) { directory_page_ids_[index_idx] = page_id; }
+
+ private:
+  lsn_t lsn_;
+  page_id_t page_id_;
+  page_id_t directory_page_ids_[DIRECTORY_INDEX_ARRAY_SIZE];
+};
+
+static_assert(sizeof(HashTableDirectoryIndexPage) <= PAGE_SIZE);
+
+}  // namespace bustub
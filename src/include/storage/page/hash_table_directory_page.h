@@ -26,6 +26,9 @@ namespace bustub {
  *
  * Directory Page for extendible hash table.
  *
+ * The extendible hash table keeps its directory in several of these pages, each holding DIRECTORY_ARRAY_SIZE slots.
+ * See HashTableRootDirectoryPage for how the slots are spread over the pages.
+ *
  * Directory format (size in byte):
  * --------------------------------------------------------------------------------------------
  * | LSN (4) | PageId(4) | GlobalDepth(4) | LocalDepths(512) | BucketPageIds(2048) | Free(1524)
@@ -33,12 +33,24 @@
  */
 #define HASH_TABLE_BUCKET_TYPE HashTableBucketPage<KeyType, ValueType, KeyComparator>
 #define DIRECTORY_ARRAY_SIZE 512
+#define DIRECTORY_PAGE_DEPTH 9  // log2(DIRECTORY_ARRAY_SIZE)
+
+/**
+ * The directory of an extendible hash table is split over directory pages of DIRECTORY_ARRAY_SIZE slots. Their page
+ * ids are kept in directory index pages of DIRECTORY_INDEX_ARRAY_SIZE entries, whose page ids are in turn kept in a
+ * root directory page of ROOT_DIRECTORY_ARRAY_SIZE entries. The two levels could address a global depth of 27,
+ * DIRECTORY_MAX_DEPTH bounds it lower to keep a full directory (2^20 slots in 2048 directory pages) reasonable.
+ */
+#define DIRECTORY_INDEX_ARRAY_SIZE 512
+#define ROOT_DIRECTORY_ARRAY_SIZE 512
+#define DIRECTORY_MAX_DEPTH 20
 
 /**
  * BUCKET_ARRAY_SIZE is the number of (key, value) pairs that can be stored in an extendible hashing bucket page.
  * It is an approximate calculation based on the size of MappingType (which is a std::pair of KeyType and ValueType).
- * For each key/value pair, we need two additional bits for occupied_ and readable_. 4 * (PAGE_SIZE - 4) / (4 * sizeof
- * (MappingType) + 1) = (PAGE_SIZE - 4)/(sizeof (MappingType) + 0.25) because 0.25 bytes = 2 bits is the space required
- * to maintain the occupied and readable flags for a key value pair.
+ * For each key/value pair, we need two additional bits for occupied_ and readable_ and one byte for the key's
+ * fingerprint. 4 * (PAGE_SIZE - 16) / (4 * sizeof (MappingType) + 5) = (PAGE_SIZE - 16)/(sizeof (MappingType) + 1.25)
+ * because 1.25 bytes = 10 bits is the space required to maintain the flags and the fingerprint of a key value pair.
+ * The 16 bytes cover the rounding of the bitmaps and the alignment of the pairs.
  */
-#define BUCKET_ARRAY_SIZE (4 * PAGE_SIZE / (4 * sizeof(MappingType) + 1))
+#define BUCKET_ARRAY_SIZE (4 * (PAGE_SIZE - 16) / (4 * sizeof(MappingType) + 5))
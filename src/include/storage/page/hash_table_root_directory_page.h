@@ -0,0 +1,90 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_root_directory_page.h
+//
+// Identification: src/include/storage/page/hash_table_root_directory_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/config.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+
+/**
+ *
+ * Root directory page for extendible hash table.
+ *
+ * The directory has 2^GlobalDepth slots. Slot i is stored at index i % DIRECTORY_ARRAY_SIZE of the directory page
+ * d = i / DIRECTORY_ARRAY_SIZE, whose page id is listed in the directory index page IndexPageIds[d /
+ * DIRECTORY_INDEX_ARRAY_SIZE], see HashTableDirectoryIndexPage. Until the directory outgrows one directory page only
+ * the first slots of directory page 0 are in use.
+ *
+ * Root directory format (size in byte):
+ * --------------------------------------------------------------------------------
+ * | LSN (4) | PageId(4) | GlobalDepth(4) | IndexPageIds(2048) | Free(2036)
+ * --------------------------------------------------------------------------------
+ */
+class HashTableRootDirectoryPage {
+ public:
+  /** @return the page ID of this page */
+  page_id_t GetPageId() const { return page_id_; }
+
+  /** Sets the page ID of this page */
+  void SetPageId(page_id_t page_id) { page_id_ = page_id; }
+
+  /** @return the lsn of this page */
+  lsn_t GetLSN() const { return lsn_; }
+
+  /** Sets the LSN of this page */
+  void SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+  /**
+   * The global depth is read without the table latch by readers racing a directory doubling,
+   * so it is loaded and published atomically.
+   *
+   * @return the global depth of the directory
+   */
+  uint32_t GetGlobalDepth() const { return __atomic_load_n(&global_depth_, __ATOMIC_ACQUIRE); }
+
+  /**
+   * Publish a new global depth. All slots below 2^global_depth must be in place before.
+   */
+  void SetGlobalDepth(uint32_t global_depth) { __atomic_store_n(&global_depth_, global_depth, __ATOMIC_RELEASE); }
+
+  /** @return the number of directory pages in use for the global depth */
+  uint32_t NumDirectoryPages() const {
+    uint32_t global_depth = GetGlobalDepth();
+    return global_depth <= DIRECTORY_PAGE_DEPTH ? 1 : 1 << (global_depth - DIRECTORY_PAGE_DEPTH);
+  }
+
+  /** @return the number of directory index pages in use for the global depth */
+  uint32_t NumIndexPages() const {
+    return (NumDirectoryPages() + DIRECTORY_INDEX_ARRAY_SIZE - 1) / DIRECTORY_INDEX_ARRAY_SIZE;
+  }
+
+  /** @return the page id of the index_idx'th directory index page */
+  page_id_t GetIndexPageId(uint32_t index_idx) const { return index_page_ids_[index_idx]; }
+
+  /** Sets the page id of the index_idx'th directory index page */
+  void SetIndexPageId(uint32_t index_idx, page_id_t page_id) { index_page_ids_[index_idx] = page_id; }
+
+ private:
+  lsn_t lsn_;
+  page_id_t page_id_;
+  uint32_t global_depth_{0};
+  page_id_t index_page_ids_[ROOT_DIRECTORY_ARRAY_SIZE];
+};
+
+static_assert(sizeof(HashTableRootDirectoryPage) <= PAGE_SIZE);
+static_assert((1U << (DIRECTORY_MAX_DEPTH - DIRECTORY_PAGE_DEPTH)) <=
+                  ROOT_DIRECTORY_ARRAY_SIZE * DIRECTORY_INDEX_ARRAY_SIZE,
+              "The directory index pages must list every directory page of a directory at DIRECTORY_MAX_DEPTH");
+
+}  // namespace bustub
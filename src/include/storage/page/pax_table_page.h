@@ -0,0 +1,267 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_table_page.h
+//
+// Identification: src/include/storage/page/pax_table_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+
+#include "catalog/schema.h"
+#include "common/rid.h"
+#include "concurrency/lock_manager.h"
+#include "recovery/log_manager.h"
+#include "storage/page/page.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * PAX (Partition Attributes Across) page format:
+ *  ---------------------------------------------------------------------------------------
+ *  | HEADER | SLOT STATUS | MINIPAGE(col 0) | ... | MINIPAGE(col n) | FREE | VARLEN HEAP |
+ *  ---------------------------------------------------------------------------------------
+ *                                                                          ^
+ *                                                                          varlen pointer
+ *
+ *  Header format (size in bytes):
+ *  ----------------------------------------------------------------------------
+ *  | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| SlotCount (4) |
+ *  ----------------------------------------------------------------------------
+ *  ----------------------------------------------------------------------------
+ *  | VarlenPointer (4) | Capacity (4) | TupleLength (4) | ColumnCount (4) |
+ *  ----------------------------------------------------------------------------
+ *  ---------------------------------------------------------------------------------
+ *  | Column_1 TupleOffset (2) | Column_1 Width (2) | Column_1 MinipageOffset (2) |
+ *  | Column_1 IsVarlen (2) | ... |
+ *  ---------------------------------------------------------------------------------
+ *
+ * The first 16 bytes match TablePage, so the table heap page chain is walked the same way for both formats.
+ * Each column's values live contiguously in their own minipage, so reading one column touches only that column's
+ * bytes. A varlen minipage entry is a (heap offset, payload size) pair pointing into the varlen heap, which grows
+ * down from the end of the page. The page describes its own layout, so no schema is needed to read it back.
+ */
+class PaxTablePage : public Page {
+ public:
+  /**
+   * Initialize the PaxTablePage header. The column layout must be set afterwards with SetLayout or CopyLayoutFrom.
+   * @param page_id the page ID of this table page
+   * @param page_size the size of this table page
+   * @param prev_page_id the previous table page ID
+   * @param log_manager the log manager in use
+   * @param txn the transaction that this page is created in
+   */
+  void Init(page_id_t page_id, uint32_t page_size, page_id_t prev_page_id, LogManager *log_manager, Transaction *txn);
+
+  /**
+   * Lay out one minipage per column of the schema and compute the slot capacity of the page.
+   * @param schema the schema of the tuples stored in this page
+   */
+  void SetLayout(const Schema &schema);
+
+  /**
+   * Copy the column layout of another PAX page of the same table. The slot capacity is sized again so that every
+   * slot has room for at least varlen_bytes of varlen payload, a page made for a wide tuple holds fewer slots.
+   * @param other the page to copy the columns from
+   * @param varlen_bytes the varlen payload size of the tuple the page is made for, see VarlenBytesOf
+   */
+  void CopyLayoutFrom(PaxTablePage *other, uint32_t varlen_bytes = 0);
+
+  /** @return the total varlen payload size the tuple would need in the heap */
+  uint32_t VarlenBytesOf(const Tuple &tuple);
+
+  /** @return the page ID of this table page */
+  page_id_t GetTablePageId() { return *reinterpret_cast<page_id_t *>(GetData()); }
+
+  /** @return the page ID of the previous table page */
+  page_id_t GetPrevPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_PREV_PAGE_ID); }
+
+  /** @return the page ID of the next table page */
+  page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
+
+  /** Set the page id of the previous page in the table. */
+  void SetPrevPageId(page_id_t prev_page_id) {
+    memcpy(GetData() + OFFSET_PREV_PAGE_ID, &prev_page_id, sizeof(page_id_t));
+  }
+
+  /** Set the page id of the next page in the table. */
+  void SetNextPageId(page_id_t next_page_id) {
+    memcpy(GetData() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
+  }
+
+  /**
+   * Insert a tuple into the table, splitting it into the column minipages.
+   * @param tuple tuple to insert
+   * @param[out] rid rid of the inserted tuple
+   * @param txn transaction performing the insert
+   * @param lock_manager the lock manager
+   * @param log_manager the log manager
+   * @return true if the insert is successful (i.e. there is a free slot and enough varlen space)
+   */
+  bool InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager);
+
+  /**
+   * Mark a tuple as deleted. This does not actually delete the tuple.
+   * @param rid rid of the tuple to mark as deleted
+   * @param txn transaction performing the delete
+   * @param lock_manager the lock manager
+   * @param log_manager the log manager
+   * @return true if marking the tuple as deleted is successful (i.e the tuple exists)
+   */
+  bool MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager);
+
+  /**
+   * Update a tuple in place.
+   * @param new_tuple new value of the tuple
+   * @param[out] old_tuple old value of the tuple
+   * @param rid rid of the tuple
+   * @param txn transaction performing the update
+   * @param lock_manager the lock manager
+   * @param log_manager the log manager
+   * @return true if updating the tuple succeeded
+   */
+  bool UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID &rid, Transaction *txn,
+                   LockManager *lock_manager, LogManager *log_manager);
+
+  /** To be called on commit or abort. Actually perform the delete or rollback an insert. */
+  void ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
+
+  /** To be called on abort. Rollback a delete, i.e. this reverses a MarkDelete. */
+  void RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
+
+  /**
+   * Read a tuple from a table, stitching it back together from the minipages.
+   * @param rid rid of the tuple to read
+   * @param[out] tuple the tuple that was read
+   * @param txn transaction performing the read
+   * @param lock_manager the lock manager
+   * @return true if the read is successful (i.e. the tuple exists)
+   */
+  bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager);
+
+  /**
+   * @param[out] first_rid the RID of the first tuple in this page
+   * @return true if the first tuple exists, false otherwise
+   */
+  bool GetFirstTupleRid(RID *first_rid);
+
+  /**
+   * @param cur_rid the RID of the current tuple
+   * @param[out] next_rid the RID of the tuple following the current tuple
+   * @return true if the next tuple exists, false otherwise
+   */
+  bool GetNextTupleRid(const RID &cur_rid, RID *next_rid);
+
+  /** @return the number of columns in this page's layout */
+  uint32_t GetColumnCount() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_COLUMN_COUNT); }
+
+  /** @return true if the column is stored out of line in the varlen heap */
+  bool IsColumnVarlen(uint32_t col_idx) { return GetColumnField(col_idx, COLUMN_IS_VARLEN) != 0; }
+
+  /** @return the width in bytes of one value of a fixed-length column */
+  uint32_t GetColumnWidth(uint32_t col_idx) { return GetColumnField(col_idx, COLUMN_WIDTH); }
+
+  /**
+   * Copy the values of one fixed-length column of every live tuple into a dense array, without touching the other
+   * columns. No tuple locks are taken.
+   * @param col_idx the column to read
+   * @param[out] out destination with room for GetTupleCount() * GetColumnWidth(col_idx) bytes
+   * @param[out] rids destination with room for GetTupleCount() RIDs, may be nullptr
+   * @return the number of values copied
+   */
+  uint32_t ReadColumn(uint32_t col_idx, char *out, RID *rids);
+
+  /**
+   * @note returned tuple count may be an overestimate because some slots may be empty
+   * @return at least the number of tuples in this page
+   */
+  uint32_t GetTupleCount() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_SLOT_COUNT); }
+
+ private:
+  static_assert(sizeof(page_id_t) == 4);
+
+  static constexpr size_t SIZE_PAX_PAGE_HEADER = 36;
+  static constexpr size_t SIZE_COLUMN_DESC = 8;
+  static constexpr size_t OFFSET_PREV_PAGE_ID = 8;
+  static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
+  static constexpr size_t OFFSET_SLOT_COUNT = 16;
+  static constexpr size_t OFFSET_VARLEN_POINTER = 20;
+  static constexpr size_t OFFSET_CAPACITY = 24;
+  static constexpr size_t OFFSET_TUPLE_LENGTH = 28;
+  static constexpr size_t OFFSET_COLUMN_COUNT = 32;
+  static constexpr size_t OFFSET_COLUMN_DESC = 36;
+
+  /** Column descriptor fields, each 2 bytes. */
+  static constexpr size_t COLUMN_TUPLE_OFFSET = 0;
+  static constexpr size_t COLUMN_WIDTH = 2;
+  static constexpr size_t COLUMN_MINIPAGE_OFFSET = 4;
+  static constexpr size_t COLUMN_IS_VARLEN = 6;
+
+  /** A varlen minipage entry is the heap offset followed by the payload size. */
+  static constexpr uint32_t VARLEN_ENTRY_SIZE = 2 * sizeof(uint32_t);
+  /** Varlen heap bytes reserved per varlen column per slot when sizing the page. */
+  static constexpr uint32_t VARLEN_RESERVE = 16;
+
+  /** Slot states. A deleted slot keeps its values until ApplyDelete frees it. */
+  static constexpr uint8_t SLOT_EMPTY = 0;
+  static constexpr uint8_t SLOT_LIVE = 1;
+  static constexpr uint8_t SLOT_DELETED = 2;
+
+  uint32_t GetVarlenPointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_VARLEN_POINTER); }
+  void SetVarlenPointer(uint32_t ptr) { memcpy(GetData() + OFFSET_VARLEN_POINTER, &ptr, sizeof(uint32_t)); }
+  uint32_t GetCapacity() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_CAPACITY); }
+  uint32_t GetTupleLength() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_LENGTH); }
+  void SetTupleCount(uint32_t count) { memcpy(GetData() + OFFSET_SLOT_COUNT, &count, sizeof(uint32_t)); }
+
+  uint16_t GetColumnField(uint32_t col_idx, size_t field) {
+    return *reinterpret_cast<uint16_t *>(GetData() + OFFSET_COLUMN_DESC + SIZE_COLUMN_DESC * col_idx + field);
+  }
+  void SetColumnField(uint32_t col_idx, size_t field, uint16_t value) {
+    memcpy(GetData() + OFFSET_COLUMN_DESC + SIZE_COLUMN_DESC * col_idx + field, &value, sizeof(uint16_t));
+  }
+
+  /** @return the offset of the slot status array, right after the column descriptors */
+  uint32_t GetSlotStatusOffset() { return OFFSET_COLUMN_DESC + SIZE_COLUMN_DESC * GetColumnCount(); }
+  uint8_t GetSlotStatus(uint32_t slot_num) {
+    return *reinterpret_cast<uint8_t *>(GetData() + GetSlotStatusOffset() + slot_num);
+  }
+  void SetSlotStatus(uint32_t slot_num, uint8_t status) {
+    *reinterpret_cast<uint8_t *>(GetData() + GetSlotStatusOffset() + slot_num) = status;
+  }
+
+  /** @return pointer to the value of column col_idx at slot slot_num inside its minipage */
+  char *GetMinipageEntry(uint32_t col_idx, uint32_t slot_num) {
+    return GetData() + GetColumnField(col_idx, COLUMN_MINIPAGE_OFFSET) + GetColumnWidth(col_idx) * slot_num;
+  }
+
+  /** @return the end of the last minipage, i.e. the lowest address the varlen heap may grow to */
+  uint32_t GetMinipageEnd();
+
+  /** @return the varlen heap bytes reserved per slot by SetLayout, VARLEN_RESERVE per varlen column */
+  uint32_t DefaultVarlenReserve();
+
+  /** Compute the slot capacity and the minipage offsets from the column descriptors. */
+  void LayOutMinipages(uint32_t varlen_reserve);
+
+
+  /** @return the varlen heap bytes used by live or deleted slots, optionally ignoring one slot */
+  uint32_t LiveVarlenBytes(uint32_t skip_slot);
+
+  /** Rewrite the varlen heap contiguously, dropping payloads of empty slots and of skip_slot. */
+  void CompactVarlenHeap(uint32_t skip_slot);
+
+  /** Scatter the tuple into the minipages at slot_num. The varlen heap must have room for it. */
+  void WriteSlot(uint32_t slot_num, const Tuple &tuple);
+
+  /** Gather the tuple at slot_num from the minipages. */
+  void ReadSlot(uint32_t slot_num, Tuple *tuple);
+};
+
+}  // namespace bustub
@@ -0,0 +1,50 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// column_batch.h
+//
+// Identification: src/include/storage/table/column_batch.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/rid.h"
+
+namespace bustub {
+
+/**
+ * ColumnBatch holds the values of a few fixed-length columns for every live tuple of one PAX page.
+ * Column i of the batch is a dense array of GetSize() values of the i-th requested column, and GetRids()
+ * holds the RID of each row.
+ */
+class ColumnBatch {
+  friend class TableHeap;
+
+ public:
+  /** @return the number of rows in the batch */
+  size_t GetSize() const { return rids_.size(); }
+
+  /** @return the RIDs of the rows in the batch */
+  const std::vector<RID> &GetRids() const { return rids_; }
+
+  /**
+   * @param idx position of the column in the list of columns that was scanned
+   * @return the values of that column, T must match the width of the column's type
+   */
+  template <typename T>
+  const T *GetColumn(size_t idx) const {
+    return reinterpret_cast<const T *>(columns_[idx].data());
+  }
+
+ private:
+  std::vector<RID> rids_;
+  std::vector<std::vector<char>> columns_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,65 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// dictionary.h
+//
+// Identification: src/include/storage/table/dictionary.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/rwlatch.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * Dictionary maps the distinct strings of a dictionary encoded VARCHAR column to dense integer codes.
+ * Tuples store the 4-byte code in place of the string, so two values of the same dictionary are equal
+ * if and only if their codes are equal. Codes are handed out in insertion order and never change,
+ * they do not preserve the order of the strings.
+ */
+class Dictionary {
+ public:
+  /** The code stored for a NULL value. */
+  static constexpr uint32_t NULL_CODE = UINT32_MAX;
+
+  Dictionary() = default;
+  DISALLOW_COPY_AND_MOVE(Dictionary);
+
+  /**
+   * Look up the code of a value, adding the value to the dictionary if it is new.
+   * @param value a VARCHAR value
+   * @return the code of the value, NULL_CODE if it is null
+   */
+  uint32_t Encode(const Value &value);
+
+  /**
+   * Look up the code of a value without adding it.
+   * @param value a VARCHAR value
+   * @param[out] code the code of the value
+   * @return false if the value is not in the dictionary
+   */
+  bool Lookup(const Value &value, uint32_t *code) const;
+
+  /** @return the VARCHAR value of a code */
+  Value Decode(uint32_t code) const;
+
+  /** @return the number of distinct strings in the dictionary */
+  uint32_t Size() const;
+
+ private:
+  std::unordered_map<std::string, uint32_t> codes_;
+  std::vector<std::string> strings_;
+  mutable ReaderWriterLatch latch_;
+};
+
+}  // namespace bustub
@@ -12,14 +12,26 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
+#include "storage/page/pax_table_page.h"
 #include "storage/page/table_page.h"
+#include "storage/table/column_batch.h"
 #include "storage/table/table_iterator.h"
+#include "storage/table/zone_map.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
+/**
+ * The page format of a table heap. ROW stores whole tuples in slotted TablePages (NSM), PAX stores each column in
+ * its own minipage inside a PaxTablePage.
+ */
+enum class TableFormat { ROW, PAX };
+
 /**
  * TableHeap represents a physical table on disk.
  * This is just a doubly-linked list of pages.
@@ -36,9 +48,10 @@ class TableHeap {
    * @param lock_manager the lock manager
    * @param log_manager the log manager
    * @param first_page_id the id of the first page
+   * @param format the page format the table was created with
    */
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-            page_id_t first_page_id);
+            page_id_t first_page_id, TableFormat format = TableFormat::ROW);
 
   /**
    * Create a table heap with a transaction. (create table)
@@ -50,6 +63,18 @@ class TableHeap {
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
             Transaction *txn);
 
+  /**
+   * Create a table heap with a transaction in the given page format. (create table)
+   * @param buffer_pool_manager the buffer pool manager
+   * @param lock_manager the lock manager
+   * @param log_manager the log manager
+   * @param txn the creating transaction
+   * @param schema the schema of the tuples, used to lay out PAX pages
+   * @param format the page format of the table
+   */
+  TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
+            Transaction *txn, const Schema &schema, TableFormat format);
+
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
    * @param tuple tuple to insert
@@ -105,14 +130,61 @@ class TableHeap {
   /** @return the end iterator of this table */
   TableIterator End();
 
+  /**
+   * @param page_id a page of this table
+   * @return an iterator at the first tuple stored after the given page
+   */
+  TableIterator SkipPage(page_id_t page_id, Transaction *txn);
+
+  /**
+   * Keep a per-page min/max/null-count summary of some columns, maintained by every insert and update from now on.
+   * Call this before the first tuple is inserted.
+   * @param schema the schema of the table
+   * @param col_idxs the columns to summarize
+   */
+  void EnableZoneMap(const Schema &schema, std::vector<uint32_t> col_idxs);
+
+  /** @return the zone map of this table, nullptr if it has none */
+  const ZoneMap *GetZoneMap() const { return zone_map_.get(); }
+
   /** @return the id of the first page of this table */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /** @return the page format of this table */
+  inline TableFormat GetFormat() const { return format_; }
+
+  /**
+   * Read some fixed-length columns of every live tuple in one page of a PAX table, leaving the other columns
+   * untouched. No tuple locks are taken, so callers needing isolation must lock the returned RIDs themselves.
+   * @param page_id the page to read, start with GetFirstPageId()
+   * @param col_idxs the columns to read
+   * @param[out] batch the column values and RIDs of the page
+   * @return the id of the next page, INVALID_PAGE_ID after the last page
+   */
+  page_id_t ScanColumns(page_id_t page_id, const std::vector<uint32_t> &col_idxs, ColumnBatch *batch);
+
  private:
+  template <typename PageType>
+  bool InsertTupleImpl(const Tuple &tuple, RID *rid, Transaction *txn);
+  template <typename PageType>
+  bool MarkDeleteImpl(const RID &rid, Transaction *txn);
+  template <typename PageType>
+  bool UpdateTupleImpl(const Tuple &tuple, const RID &rid, Transaction *txn);
+  template <typename PageType>
+  void ApplyDeleteImpl(const RID &rid, Transaction *txn);
+  template <typename PageType>
+  void RollbackDeleteImpl(const RID &rid, Transaction *txn);
+  template <typename PageType>
+  bool GetTupleImpl(const RID &rid, Tuple *tuple, Transaction *txn);
+  template <typename PageType>
+  RID GetFirstTupleRidImpl(page_id_t page_id);
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  TableFormat format_{TableFormat::ROW};
+  std::unique_ptr<ZoneMap> zone_map_;
 };
 
 }  // namespace bustub
@@ -56,6 +56,10 @@ class TableIterator {
   }
 
  private:
+  /** Move to the next live tuple, reading the table pages as PageType. */
+  template <typename PageType>
+  void Advance();
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
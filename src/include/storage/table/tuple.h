@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -29,6 +30,7 @@ namespace bustub {
  */
 class Tuple {
   friend class TablePage;
+  friend class PaxTablePage;
   friend class TableHeap;
   friend class TableIterator;
 
@@ -74,6 +76,19 @@ class Tuple {
   // checks the schema to see how to return the Value.
   Value GetValue(const Schema *schema, uint32_t column_idx) const;
 
+  // Read an inlined column straight out of the tuple, T must match the width of the column's type
+  template <typename T>
+  inline T GetInlinedAs(const Schema *schema, uint32_t column_idx) const {
+    T value;
+    memcpy(&value, data_ + schema->GetColumnOffset(column_idx), sizeof(T));
+    return value;
+  }
+
+  // Get the code of a dictionary encoded column
+  inline uint32_t GetDictionaryCode(const Schema *schema, uint32_t column_idx) const {
+    return GetInlinedAs<uint32_t>(schema, column_idx);
+  }
+
   // Generates a key tuple given schemas and attributes
   Tuple KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs);
 
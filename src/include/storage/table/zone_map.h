@@ -0,0 +1,83 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map.h
+//
+// Identification: src/include/storage/table/zone_map.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "execution/expressions/comparison_expression.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * ZoneMap keeps a min/max/null-count summary of some columns for every page of a table heap.
+ * The summaries only ever widen: deleting a tuple does not shrink them, so they stay a conservative
+ * bound on what a page may contain and can be used to skip pages that cannot satisfy a predicate.
+ */
+class ZoneMap {
+ public:
+  /**
+   * @param schema the schema of the table
+   * @param col_idxs the columns to summarize
+   */
+  ZoneMap(const Schema &schema, std::vector<uint32_t> col_idxs);
+
+  /** Widen the summary of a page with a newly inserted tuple. */
+  void Insert(page_id_t page_id, const Tuple &tuple);
+
+  /** Widen the summary of a page with the new value of an updated tuple. */
+  void Update(page_id_t page_id, const Tuple &old_tuple, const Tuple &new_tuple);
+
+  /** @return true if the column is summarized */
+  bool IsTracked(uint32_t col_idx) const;
+
+  /**
+   * @param page_id the page to check
+   * @param col_idx the column on the left hand side of the comparison
+   * @param comp_type the comparison
+   * @param constant the constant on the right hand side of the comparison
+   * @return false only if no tuple of the page can satisfy (column comp_type constant)
+   */
+  bool MayMatch(page_id_t page_id, uint32_t col_idx, ComparisonType comp_type, const Value &constant) const;
+
+  /**
+   * Read the summary of one column of a page.
+   * @return false if the page or the column has no summary
+   */
+  bool GetSummary(page_id_t page_id, uint32_t col_idx, Value *min, Value *max, uint32_t *null_count) const;
+
+ private:
+  struct ColumnSummary {
+    Value min_;
+    Value max_;
+    uint32_t null_count_{0};
+    bool has_value_{false};
+  };
+
+  /** @return the position of col_idx in col_idxs_, or col_idxs_.size() if it is not tracked */
+  size_t SummaryIndex(uint32_t col_idx) const;
+
+  void Widen(std::vector<ColumnSummary> *summaries, const Tuple &tuple);
+
+  Schema schema_;
+  std::vector<uint32_t> col_idxs_;
+  std::unordered_map<page_id_t, std::vector<ColumnSummary>> pages_;
+  mutable std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -11,16 +11,22 @@
 //===----------------------------------------------------------------------===//
 
 #include <sys/stat.h>
+#include <algorithm>
 #include <cassert>
+#include <chrono>  // NOLINT
 #include <cstring>
 #include <iostream>
 #include <mutex>  // NOLINT
+#include <optional>
 #include <string>
 #include <thread>  // NOLINT
+#include <unordered_map>
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/macros.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/page_compressor.h"
 
 namespace bustub {
 
@@ -30,8 +36,13 @@ static char *buffer_used;
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, bool enable_compression)
+    : file_name_(db_file),
+      num_flushes_(0),
+      num_writes_(0),
+      flush_log_(false),
+      flush_log_f_(nullptr),
+      compression_enabled_(enable_compression) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
@@ -68,6 +79,9 @@ DiskManager::DiskManager(const std::string &db_file)
     }
   }
   buffer_used = nullptr;
+  if (compression_enabled_) {
+    LoadExtentMap();
+  }
 }
 
 /**
@@ -85,6 +99,10 @@ void DiskManager::ShutDown() {
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  if (compression_enabled_) {
+    WriteCompressedPage(page_id, page_data);
+    return;
+  }
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
   size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
   // set write cursor to offset
@@ -104,6 +122,10 @@ void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  if (compression_enabled_) {
+    ReadCompressedPage(page_id, page_data);
+    return;
+  }
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
   int offset = page_id * PAGE_SIZE;
   // check if read beyond file length
@@ -129,6 +151,171 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
   }
 }
 
+/**
+ * Compress the page and write it into its extent, moving it to a new extent if it no longer fits
+ * A page that moves is written to its new extent, with a higher sequence number, before the old extent is freed, so
+ * the file always names one extent holding the latest copy of the page, and a reused extent has a new header.
+ */
+void DiskManager::WriteCompressedPage(page_id_t page_id, const char *page_data) {
+  // Compress outside of the latch, only the file access needs to be serialized.
+  char buffer[PAGE_SIZE];
+  auto start = std::chrono::steady_clock::now();
+  size_t size = PageCompressor::Compress(page_data, PAGE_SIZE, buffer, PAGE_SIZE - 1);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  const char *stored_data = buffer;
+  if (size == 0) {
+    // Incompressible, store the page as it is.
+    stored_data = page_data;
+    size = PAGE_SIZE;
+  }
+  auto extent_size = static_cast<uint32_t>((sizeof(ExtentHeader) + size + EXTENT_ALIGNMENT - 1) / EXTENT_ALIGNMENT *
+                                           EXTENT_ALIGNMENT);
+
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  auto it = extent_map_.find(page_id);
+  size_t offset;
+  std::optional<PageExtent> old_extent;
+  if (it != extent_map_.end() && it->second.extent_size_ == extent_size) {
+    offset = it->second.offset_;
+  } else {
+    if (it != extent_map_.end()) {
+      old_extent = it->second;
+    }
+    offset = AllocateExtent(extent_size);
+  }
+  extent_map_[page_id] = {offset, static_cast<uint32_t>(size), extent_size};
+  ExtentHeader header{EXTENT_MAGIC, page_id, static_cast<uint32_t>(size), extent_size, next_sequence_++};
+
+  num_writes_ += 1;
+  compression_stats_.pages_written_++;
+  compression_stats_.pages_stored_raw_ += size == PAGE_SIZE ? 1 : 0;
+  compression_stats_.bytes_in_ += PAGE_SIZE;
+  compression_stats_.bytes_out_ += size;
+  compression_stats_.compress_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  db_io_.seekp(offset);
+  db_io_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  db_io_.write(stored_data, size);
+  if (db_io_.bad()) {
+    LOG_DEBUG("I/O error while writing");
+    return;
+  }
+  db_io_.flush();
+  // only now that the page is in its new extent, the old one may be reused
+  if (old_extent.has_value()) {
+    free_extents_[old_extent->extent_size_ / EXTENT_ALIGNMENT].push_back(old_extent->offset_);
+  }
+}
+
+/**
+ * Look the page up in the extent map and decompress it into the given memory area
+ */
+void DiskManager::ReadCompressedPage(page_id_t page_id, char *page_data) {
+  char buffer[PAGE_SIZE];
+  uint32_t size;
+  {
+    std::scoped_lock scoped_db_io_latch(db_io_latch_);
+    auto it = extent_map_.find(page_id);
+    if (it == extent_map_.end()) {
+      LOG_DEBUG("I/O error reading a page that was never written");
+      memset(page_data, 0, PAGE_SIZE);
+      return;
+    }
+    size = it->second.size_;
+    db_io_.seekp(it->second.offset_ + sizeof(ExtentHeader));
+    db_io_.read(size == PAGE_SIZE ? page_data : buffer, size);
+    if (db_io_.bad() || db_io_.gcount() != static_cast<std::streamsize>(size)) {
+      LOG_DEBUG("I/O error while reading");
+      db_io_.clear();
+      memset(page_data, 0, PAGE_SIZE);
+      return;
+    }
+  }
+  if (size == PAGE_SIZE) {
+    std::scoped_lock scoped_db_io_latch(db_io_latch_);
+    compression_stats_.pages_read_++;
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  bool ok = PageCompressor::Decompress(buffer, size, page_data, PAGE_SIZE);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  if (!ok) {
+    throw Exception("corrupted compressed page " + std::to_string(page_id));
+  }
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  compression_stats_.pages_read_++;
+  compression_stats_.decompress_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+size_t DiskManager::AllocateExtent(uint32_t extent_size) {
+  size_t size_class = extent_size / EXTENT_ALIGNMENT;
+  if (free_extents_.size() <= size_class) {
+    free_extents_.resize(size_class + 1);
+  }
+  if (!free_extents_[size_class].empty()) {
+    size_t offset = free_extents_[size_class].back();
+    free_extents_[size_class].pop_back();
+    return offset;
+  }
+  size_t offset = next_extent_offset_;
+  next_extent_offset_ += extent_size;
+  return offset;
+}
+
+/**
+ * The extents are laid out back to back from the start of the file. A header that is not valid was cut short by a
+ * crash. Its extent size cannot be trusted, so the scan looks for the next header at the following aligned offsets
+ * and leaves the space in between unused. The file is extended after the end of the last valid extent.
+ */
+void DiskManager::LoadExtentMap() {
+  std::unordered_map<page_id_t, uint64_t> sequences;
+  auto free_extent = [this](const PageExtent &extent) {
+    size_t size_class = extent.extent_size_ / EXTENT_ALIGNMENT;
+    if (free_extents_.size() <= size_class) {
+      free_extents_.resize(size_class + 1);
+    }
+    free_extents_[size_class].push_back(extent.offset_);
+  };
+
+  auto file_size = static_cast<size_t>(std::max(GetFileSize(file_name_), 0));
+  size_t offset = 0;
+  size_t end_offset = 0;
+  ExtentHeader header{};
+  while (offset + sizeof(header) <= file_size) {
+    db_io_.seekp(offset);
+    db_io_.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (db_io_.gcount() != sizeof(header) || header.magic_ != EXTENT_MAGIC || header.extent_size_ == 0 ||
+        header.extent_size_ % EXTENT_ALIGNMENT != 0 || header.size_ > PAGE_SIZE ||
+        sizeof(header) + header.size_ > header.extent_size_ || offset + sizeof(header) + header.size_ > file_size) {
+      db_io_.clear();
+      offset += EXTENT_ALIGNMENT;
+      continue;
+    }
+    PageExtent extent{offset, header.size_, header.extent_size_};
+    next_sequence_ = std::max(next_sequence_, header.sequence_ + 1);
+    //! 同一个页的多个extent中序号最大的是最新的, 其余的都是空闲的
+    auto seen = sequences.find(header.page_id_);
+    if (seen == sequences.end()) {
+      sequences.emplace(header.page_id_, header.sequence_);
+      extent_map_[header.page_id_] = extent;
+    } else if (seen->second < header.sequence_) {
+      seen->second = header.sequence_;
+      free_extent(extent_map_[header.page_id_]);
+      extent_map_[header.page_id_] = extent;
+    } else {
+      free_extent(extent);
+    }
+    offset += header.extent_size_;
+    end_offset = offset;
+  }
+  db_io_.clear();
+  next_extent_offset_ = end_offset;
+}
+
+CompressionStats DiskManager::GetCompressionStats() {
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  return compression_stats_;
+}
+
 /**
  * Write the contents of the log into disk file
  * Only return when sync is done, and only perform sequence write
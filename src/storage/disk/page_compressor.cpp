@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_compressor.cpp
+//
+// Identification: src/storage/disk/page_compressor.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/page_compressor.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace bustub {
+
+namespace {
+inline uint32_t Load32(const char *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(uint32_t));
+  return v;
+}
+}  // namespace
+
+size_t PageCompressor::Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) {
+  // The last position each 4-byte sequence was seen at, plus one so that 0 means empty.
+  std::vector<uint16_t> last_seen(1 << HASH_BITS, 0);
+  size_t out = 0;
+  size_t literal_start = 0;
+  size_t pos = 0;
+
+  // Emit src[literal_start, end) as literal runs.
+  auto flush_literals = [&](size_t end) {
+    while (literal_start < end) {
+      size_t run = std::min(end - literal_start, MAX_LITERAL);
+      if (out + 1 + run > dst_capacity) {
+        return false;
+      }
+      dst[out++] = static_cast<char>(run - 1);
+      memcpy(dst + out, src + literal_start, run);
+      out += run;
+      literal_start += run;
+    }
+    return true;
+  };
+
+  while (pos + MIN_MATCH <= src_size) {
+    uint32_t hash = (Load32(src + pos) * 2654435761U) >> (32 - HASH_BITS);
+    size_t candidate = last_seen[hash];
+    last_seen[hash] = static_cast<uint16_t>(pos + 1);
+    if (candidate == 0 || Load32(src + candidate - 1) != Load32(src + pos)) {
+      pos++;
+      continue;
+    }
+    candidate--;
+    size_t length = MIN_MATCH;
+    while (length < MAX_MATCH && pos + length < src_size && src[candidate + length] == src[pos + length]) {
+      length++;
+    }
+    if (!flush_literals(pos) || out + 3 > dst_capacity) {
+      return 0;
+    }
+    size_t distance = pos - candidate;
+    dst[out++] = static_cast<char>(0x80 | (length - MIN_MATCH));
+    dst[out++] = static_cast<char>(distance & 0xFF);
+    dst[out++] = static_cast<char>(distance >> 8);
+    pos += length;
+    literal_start = pos;
+  }
+  if (!flush_literals(src_size)) {
+    return 0;
+  }
+  return out;
+}
+
+bool PageCompressor::Decompress(const char *src, size_t src_size, char *dst, size_t dst_size) {
+  size_t in = 0;
+  size_t out = 0;
+  while (in < src_size) {
+    auto control = static_cast<uint8_t>(src[in++]);
+    if (control < 0x80) {
+      size_t run = control + 1;
+      if (in + run > src_size || out + run > dst_size) {
+        return false;
+      }
+      memcpy(dst + out, src + in, run);
+      in += run;
+      out += run;
+      continue;
+    }
+    if (in + 2 > src_size) {
+      return false;
+    }
+    size_t length = (control & 0x7F) + MIN_MATCH;
+    size_t distance = static_cast<uint8_t>(src[in]) | (static_cast<size_t>(static_cast<uint8_t>(src[in + 1])) << 8);
+    in += 2;
+    if (distance == 0 || distance > out || out + length > dst_size) {
+      return false;
+    }
+    // Copy byte by byte, the source may overlap the bytes being produced.
+    for (size_t i = 0; i < length; i++, out++) {
+      dst[out] = dst[out - distance];
+    }
+  }
+  return out == dst_size;
+}
+
+}  // namespace bustub
@@ -9,7 +9,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cassert>
 #include <string>
+#include <vector>
 
 #include "common/exception.h"
 #include "common/rid.h"
@@ -17,32 +20,79 @@
 #include "storage/page/header_page.h"
 
 namespace bustub {
+
+namespace {
+// Spread n entries over as few nodes of at most per entries as possible, but with at least min entries in each node
+// unless there is only one.
+std::vector<int> PackSizes(int n, int per, int min) {
+  int count = (n + per - 1) / per;
+  if (count > 1 && n / count < min) {
+    count = std::max(n / min, 1);
+  }
+  std::vector<int> sizes(count, n / count);
+  for (int i = 0; i < n % count; i++) {
+    sizes[i]++;
+  }
+  return sizes;
+}
+}  // namespace
+
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, page_id_t header_page_id, int key_size,
+                          bool b_link, bool duplicate_keys)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
-      leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      leaf_max_size_(std::min(leaf_max_size, LeafPage::MaxCapacity(key_size))),
+      // an internal page holds one entry over its max size until it is split
+      internal_max_size_(std::min(internal_max_size, InternalPage::Capacity(key_size) - 1)),
+      header_page_id_(header_page_id),
+      key_size_(key_size),
+      b_link_(b_link),
+      duplicate_keys_(duplicate_keys) {}
 
 /*
  * Helper function to decide whether current b+tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::IsEmpty() const { return true; }
+bool BPLUSTREE_TYPE::IsEmpty() const {
+  root_latch_.RLock();
+  bool empty = root_page_id_ == INVALID_PAGE_ID;
+  root_latch_.RUnlock();
+  return empty;
+}
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 /*
  * Return the only value that associated with input key
  * This method is used for point query
+ * A duplicate key's values are read from its inline list or its posting list while the leaf is still latched.
  * @return : true means key exists
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) {
-  return false;
+  Page *page = FindLeafPage(key);
+  if (page == nullptr) {
+    return false;
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  ValueType value;
+  bool found = leaf->Lookup(key, &value, comparator_);
+  if (found && IsPostingList(value)) {
+    ReadPostingList(value, result);
+  } else if (found && IsInlineList(value)) {
+    for (int i = 0; i < leaf->InlineListSize(value); i++) {
+      result->push_back(leaf->InlineListValueAt(value, i));
+    }
+  } else if (found) {
+    result->push_back(value);
+  }
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  return found;
 }
 
 /*****************************************************************************
@@ -52,31 +102,360 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  * Insert constant key & value pair into b+ tree
  * if current tree is empty, start new tree, update root page id and insert
  * entry, otherwise insert into leaf page.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * @return: if user try to insert duplicate keys return false, or with
+ * duplicate keys a pair that is there already, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) { return false; }
+bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  //! 乐观路径: 只写锁叶子, 叶子不会分裂时直接插入, 否则带着写锁从根重新下降. B-link模式只下降一次
+  Page *page = b_link_ ? nullptr : FindLeafPageOptimistic(key);
+  if (page != nullptr) {
+    auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    bool inserted = false;
+    if (AddDuplicate(leaf, key, value, &inserted)) {
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), inserted);
+      return inserted;
+    }
+    if (IsSafe(leaf, Operation::INSERT)) {
+      int size = leaf->GetSize();
+      inserted = leaf->Insert(key, value, comparator_) != size;
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), inserted);
+      return inserted;
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  }
+
+  if (transaction != nullptr) {
+    return InsertIntoLeaf(key, value, transaction);
+  }
+  Transaction local_transaction(INVALID_TXN_ID);
+  return InsertIntoLeaf(key, value, &local_transaction);
+}
+/*
+ * Insert sorted pairs leaf by leaf. The leaf is write latched once and takes pairs until the next key is past its high
+ * key, then the batch moves to the right sibling, latching it before the leaf is released like an iterator does.
+ * A pair that would split the leaf takes the pessimistic path of Insert, and the batch comes back to the leaf through
+ * a hint: the split leaf or its new right sibling holds the next key if the batch is sorted.
+ * A hint only names a page id, so it is checked against merge_version_ once the page is latched. A remove that
+ * deletes pages bumps it while it still holds their latches, so a page fetched after it was deleted is never used.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+size_t BPLUSTREE_TYPE::InsertBatch(const std::vector<MappingType> &items, Transaction *transaction) {
+  Transaction local_transaction(INVALID_TXN_ID);
+  if (transaction == nullptr) {
+    transaction = &local_transaction;
+  }
+  size_t inserted = 0;
+  uint64_t hint = last_leaf_hint_;
+  Page *page = nullptr;
+  bool dirty = false;
+  for (size_t i = 0; i < items.size();) {
+    const KeyType &key = items[i].first;
+    if (page == nullptr) {
+      page = FetchLeafHint(hint, key);
+      if (page == nullptr) {
+        page = FindLeafPageOptimistic(key);
+      }
+      dirty = false;
+    }
+    if (page == nullptr) {
+      inserted += InsertIntoLeaf(key, items[i].second, transaction) ? 1 : 0;
+      i++;
+      continue;
+    }
+
+    auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    if (leaf->IsPastHighKey(key, comparator_)) {
+      Page *next = FetchPage(leaf->GetNextPageId());
+      next->WLatch();
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), dirty);
+      page = next;
+      dirty = false;
+      continue;
+    }
+    bool added = false;
+    if (AddDuplicate(leaf, key, items[i].second, &added)) {
+      inserted += added ? 1 : 0;
+      dirty = dirty || added;
+      i++;
+      continue;
+    }
+    if (!IsSafe(leaf, Operation::INSERT)) {
+      hint = MakeLeafHint(page->GetPageId());
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), dirty);
+      page = nullptr;
+      inserted += InsertIntoLeaf(key, items[i].second, transaction) ? 1 : 0;
+      i++;
+      continue;
+    }
+    int size = leaf->GetSize();
+    if (leaf->Insert(key, items[i].second, comparator_) != size) {
+      inserted++;
+      dirty = true;
+    }
+    i++;
+  }
+
+  if (page != nullptr) {
+    hint = MakeLeafHint(page->GetPageId());
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), dirty);
+  }
+  last_leaf_hint_ = hint;
+  return inserted;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+uint64_t BPLUSTREE_TYPE::MakeLeafHint(page_id_t page_id) const {
+  return (static_cast<uint64_t>(merge_version_) << 32) | static_cast<uint32_t>(page_id);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FetchLeafHint(uint64_t hint, const KeyType &key) {
+  auto page_id = static_cast<page_id_t>(static_cast<uint32_t>(hint));
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  Page *page = FetchPage(page_id);
+  page->WLatch();
+  //! 先判断版本: 页被删除后再读进来的是旧数据, 不能看它的内容
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  if (static_cast<uint32_t>(hint >> 32) == merge_version_ && leaf->GetSize() > 0 &&
+      comparator_(leaf->KeyAt(0), key) <= 0) {
+    return page;
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  return nullptr;
+}
+
 /*
  * Insert constant key & value pair into an empty tree
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
  * an "out of memory" exception if returned value is nullptr), then update b+
  * tree's root page id and insert entry directly into leaf page.
+ * The caller holds root_latch_ in write mode.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {}
+void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPage(&page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "out of memory");
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  leaf->Init(page_id, INVALID_PAGE_ID, leaf_max_size_, key_size_);
+  leaf->Insert(key, value, comparator_);
+  root_page_id_ = page_id;
+  UpdateRootPageId(1);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+}
+
+/*
+ * Build the tree bottom up from sorted unique pairs. The node sizes of every level are worked out first, so that the
+ * last node of a level is not left underfull. Then the pairs are appended to the leaves in order. A node is opened
+ * under the open node of the level above, so only the rightmost node of each level is pinned, and it is closed once it
+ * holds its share. No page latch is taken, the new pages are unreachable until the root is published.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::BulkLoad(const std::vector<MappingType> &items, double fill_factor, Transaction *transaction) {
+  root_latch_.WLock();
+  if (root_page_id_ != INVALID_PAGE_ID) {
+    root_latch_.WUnlock();
+    return false;
+  }
+  if (items.empty()) {
+    root_latch_.WUnlock();
+    return true;
+  }
+
+  //! 重复键先合并成一项, 它的值排好序放在values里, 从starts[i]开始
+  const std::vector<MappingType> *entries = &items;
+  std::vector<MappingType> collapsed;
+  std::vector<ValueType> values;
+  std::vector<size_t> starts;
+  if (duplicate_keys_) {
+    for (size_t first = 0, last; first < items.size(); first = last) {
+      size_t start = values.size();
+      for (last = first; last < items.size() && comparator_(items[last].first, items[first].first) == 0; last++) {
+        values.push_back(items[last].second);
+      }
+      std::sort(values.begin() + start, values.end(),
+                [](const ValueType &a, const ValueType &b) { return a.Get() < b.Get(); });
+      values.erase(std::unique(values.begin() + start, values.end()), values.end());
+      starts.push_back(start);
+      collapsed.emplace_back(items[first].first, values[start]);
+    }
+    starts.push_back(values.size());
+    entries = &collapsed;
+  }
+
+  //! 叶子在达到max时分裂, 所以最多放max-1个; 内部节点最多放max个
+  //! 叶子的前缀要等它的右边界定下来才知道, 所以按整个键的宽度来装
+  int leaf_max = std::min(leaf_max_size_, LeafPage::Capacity(key_size_));
+  int leaf_min = leaf_max / 2;
+  int internal_min = std::max((internal_max_size_ + 1) / 2, 2);
+  int per_leaf =
+      std::clamp(static_cast<int>((leaf_max - 1) * fill_factor), std::max(leaf_min, 1), leaf_max - 1);
+  int per_internal =
+      std::clamp(static_cast<int>(internal_max_size_ * fill_factor), internal_min, internal_max_size_);
+
+  BulkLoadState state;
+  state.sizes_.push_back(PackSizes(static_cast<int>(entries->size()), per_leaf, leaf_min));
+  while (state.sizes_.back().size() > 1) {
+    state.sizes_.push_back(PackSizes(static_cast<int>(state.sizes_.back().size()), per_internal, internal_min));
+  }
+  state.open_.assign(state.sizes_.size(), nullptr);
+  state.closed_.assign(state.sizes_.size(), nullptr);
+  state.node_.assign(state.sizes_.size(), 0);
+
+  for (size_t i = 0; i < entries->size(); i++) {
+    const MappingType &item = (*entries)[i];
+    auto *leaf = reinterpret_cast<LeafPage *>(BulkLoadOpen(&state, 0, item.first)->GetData());
+    leaf->Append(item.first, item.second);
+    int leaf_size = state.sizes_[0][state.node_[0]];
+    if (duplicate_keys_ && starts[i + 1] - starts[i] > 1) {
+      // a key's values go inline if the leaf keeps room for the pairs still to come
+      auto count = static_cast<int>(starts[i + 1] - starts[i]);
+      int room = leaf->FreeBytes() - (leaf_size - leaf->GetSize()) * leaf->SlotSize();
+      if (count <= INLINE_LIST_MAX_SIZE && room >= LeafPage::InlineListBytes(count)) {
+        leaf->SetInlineList(leaf->GetSize() - 1, values.data() + starts[i], count);
+      } else {
+        leaf->SetValueAt(leaf->GetSize() - 1, BuildPostingList(values.data() + starts[i], count));
+      }
+    }
+    if (leaf->GetSize() == leaf_size) {
+      BulkLoadClose(&state, 0);
+    }
+  }
+  // the root is the last node closed, B-link readers may descend as soon as it is published
+  root_page_id_ = state.closed_.back()->GetPageId();
+  // the rightmost node of every level has no right sibling
+  for (Page *page : state.closed_) {
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  }
+
+  UpdateRootPageId(1);
+  root_latch_.WUnlock();
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::BulkLoadOpen(BulkLoadState *state, size_t level, const KeyType &key) {
+  if (state->open_[level] != nullptr) {
+    return state->open_[level];
+  }
+  bool is_root = level + 1 == state->sizes_.size();
+  Page *parent = is_root ? nullptr : BulkLoadOpen(state, level + 1, key);
+  page_id_t parent_page_id = is_root ? INVALID_PAGE_ID : parent->GetPageId();
+
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPage(&page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "out of memory");
+  }
+  if (level == 0) {
+    reinterpret_cast<LeafPage *>(page->GetData())->Init(page_id, parent_page_id, leaf_max_size_, key_size_);
+  } else {
+    reinterpret_cast<InternalPage *>(page->GetData())->Init(page_id, parent_page_id, internal_max_size_, key_size_);
+  }
+  state->open_[level] = page;
+  // key is the first key under the new node, the high key of its left sibling
+  if (Page *left = state->closed_[level]; left != nullptr) {
+    if (level == 0) {
+      reinterpret_cast<LeafPage *>(page->GetData())->SetLowKey(key);
+      reinterpret_cast<LeafPage *>(left->GetData())->SetNextPageId(page_id);
+      reinterpret_cast<LeafPage *>(left->GetData())->SetHighKey(key);
+    } else {
+      reinterpret_cast<InternalPage *>(left->GetData())->SetNextPageId(page_id);
+      reinterpret_cast<InternalPage *>(left->GetData())->SetHighKey(key);
+    }
+    buffer_pool_manager_->UnpinPage(left->GetPageId(), true);
+    state->closed_[level] = nullptr;
+  }
+
+  if (is_root) {
+    return page;
+  }
+  // key is the first key under the new node, the separator of the node in its parent
+  auto *parent_node = reinterpret_cast<InternalPage *>(parent->GetData());
+  parent_node->Append(key, page_id);
+  if (parent_node->GetSize() == state->sizes_[level + 1][state->node_[level + 1]]) {
+    BulkLoadClose(state, level + 1);
+  }
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BulkLoadClose(BulkLoadState *state, size_t level) {
+  state->closed_[level] = state->open_[level];
+  state->open_[level] = nullptr;
+  state->node_[level]++;
+}
 
 /*
  * Insert constant key & value pair into leaf page
  * User needs to first find the right leaf page as insertion target, then look
  * through leaf page to see whether insert key exist or not. If Exist, return
  * immdiately, otherwise insert entry. Remember to deal with split if necessary.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * This is the pessimistic path of Insert, it holds write latches from the deepest safe node down.
+ * @return: if user try to insert duplicate keys return false, or with
+ * duplicate keys a pair that is there already, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) {
-  return false;
+  if (b_link_) {
+    return InsertBLink(key, value, transaction);
+  }
+  if (!FindLeafPagePessimistic(key, Operation::INSERT, transaction)) {
+    StartNewTree(key, value);
+    root_latch_.WUnlock();
+    return true;
+  }
+
+  auto *leaf = reinterpret_cast<LeafPage *>(transaction->GetPageSet()->back()->GetData());
+  bool inserted = false;
+  LeafPage *new_leaf = InsertOrSplit(leaf, key, value, &inserted, transaction);
+  if (new_leaf != nullptr) {
+    InsertIntoParent(leaf, new_leaf->KeyAt(0), new_leaf, transaction);
+  }
+  ReleaseWLatches(transaction);
+  return inserted;
+}
+
+/*
+ * Add the pair to the write latched leaf and split the leaf if it is full. The new leaf is in the transaction's page
+ * set, the caller adds it to the parent. A duplicate key whose inline list has no room left in the leaf splits it
+ * before the list grows, the value is added to the half that holds the key.
+ * @return the new leaf if the leaf was split, or nullptr
+ */
+INDEX_TEMPLATE_ARGUMENTS
+typename BPLUSTREE_TYPE::LeafPage *BPLUSTREE_TYPE::InsertOrSplit(LeafPage *leaf, const KeyType &key,
+                                                                 const ValueType &value, bool *inserted,
+                                                                 Transaction *transaction) {
+  if (AddDuplicate(leaf, key, value, inserted)) {
+    return nullptr;
+  }
+  bool grow_list = duplicate_keys_ && leaf->FindKey(key, comparator_) != -1;
+  if (!grow_list) {
+    int size = leaf->GetSize();
+    *inserted = leaf->Insert(key, value, comparator_) != size;
+    if (!*inserted || !leaf->IsFull()) {
+      return nullptr;
+    }
+  }
+  LeafPage *new_leaf = Split(leaf, transaction);
+  if (grow_list) {
+    [[maybe_unused]] bool added =
+        AddDuplicate(leaf->IsPastHighKey(key, comparator_) ? new_leaf : leaf, key, value, inserted);
+    assert(added);
+  }
+  return new_leaf;
 }
 
 /*
@@ -85,11 +464,38 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
  * an "out of memory" exception if returned value is nullptr), then move half
  * of key & value pairs from input page to newly created page
+ * The new page is write latched and put into the transaction's page set, so that it is released with the others.
+ * The new page takes over the right link and the high key of the input page, which links to it, so that a B-link
+ * reader that reads the input page before the parent knows of the new page finds the moved keys to the right.
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-N *BPLUSTREE_TYPE::Split(N *node) {
-  return nullptr;
+N *BPLUSTREE_TYPE::Split(N *node, Transaction *transaction) {
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPage(&page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "out of memory");
+  }
+  page->WLatch();
+  transaction->AddIntoPageSet(page);
+
+  auto *new_node = reinterpret_cast<N *>(page->GetData());
+  if (node->IsLeafPage()) {
+    auto *leaf = reinterpret_cast<LeafPage *>(node);
+    auto *new_leaf = reinterpret_cast<LeafPage *>(new_node);
+    new_leaf->Init(page_id, leaf->GetParentPageId(), leaf_max_size_, key_size_);
+    leaf->MoveHalfTo(new_leaf);
+  } else {
+    auto *internal = reinterpret_cast<InternalPage *>(node);
+    auto *new_internal = reinterpret_cast<InternalPage *>(new_node);
+    new_internal->Init(page_id, internal->GetParentPageId(), internal_max_size_, key_size_);
+    internal->MoveHalfTo(new_internal, buffer_pool_manager_);
+    new_internal->SetNextPageId(internal->GetNextPageId());
+    new_internal->SetHighKey(internal->GetHighKey());
+    internal->SetNextPageId(page_id);
+    internal->SetHighKey(new_internal->KeyAt(0));
+  }
+  return new_node;
 }
 
 /*
@@ -100,10 +506,144 @@ N *BPLUSTREE_TYPE::Split(N *node) {
  * User needs to first find the parent page of old_node, parent node must be
  * adjusted to take info of new_node into account. Remember to deal with split
  * recursively if necessary.
+ * The parent is write latched already, a node that splits is never safe.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                                      Transaction *transaction) {}
+                                      Transaction *transaction) {
+  if (old_node->IsRootPage()) {
+    page_id_t root_page_id;
+    Page *page = buffer_pool_manager_->NewPage(&root_page_id);
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "out of memory");
+    }
+    auto *root = reinterpret_cast<InternalPage *>(page->GetData());
+    root->Init(root_page_id, INVALID_PAGE_ID, internal_max_size_, key_size_);
+    root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    old_node->SetParentPageId(root_page_id);
+    new_node->SetParentPageId(root_page_id);
+    root_page_id_ = root_page_id;
+    UpdateRootPageId();
+    buffer_pool_manager_->UnpinPage(root_page_id, true);
+    return;
+  }
+
+  page_id_t parent_page_id = old_node->GetParentPageId();
+  auto *parent = reinterpret_cast<InternalPage *>(FetchPage(parent_page_id)->GetData());
+  parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+  if (parent->GetSize() > parent->GetMaxSize()) {
+    InternalPage *new_parent = Split(parent, transaction);
+    InsertIntoParent(parent, new_parent->KeyAt(0), new_parent, transaction);
+  }
+  buffer_pool_manager_->UnpinPage(parent_page_id, true);
+}
+
+/*
+ * The leaf is found like a reader finds it, only the leaf is write latched. A leaf that fills up splits and the split
+ * goes up the levels through InsertIntoParentBLink, no other latch is held on the way down.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::InsertBLink(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  std::vector<page_id_t> path;
+  Page *page = FindLeafPageBLink(key, true, false, &path);
+  while (page == nullptr) {
+    root_latch_.WLock();
+    if (root_page_id_ == INVALID_PAGE_ID) {
+      StartNewTree(key, value);
+      root_latch_.WUnlock();
+      return true;
+    }
+    root_latch_.WUnlock();
+    page = FindLeafPageBLink(key, true, false, &path);
+  }
+
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  bool inserted = false;
+  transaction->AddIntoPageSet(page);
+  LeafPage *new_leaf = InsertOrSplit(leaf, key, value, &inserted, transaction);
+  if (new_leaf == nullptr) {
+    transaction->GetPageSet()->pop_back();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), inserted);
+    return inserted;
+  }
+  InsertIntoParentBLink(leaf, new_leaf->KeyAt(0), new_leaf, &path, 0, transaction);
+  return inserted;
+}
+
+/*
+ * The split nodes are in the transaction's page set. A node without a parent is the root, nobody else can split it
+ * while it is latched, so the new root is made under root_latch_ like in the other mode. Otherwise the parent is
+ * latched before the split nodes are released: until it holds the separator, the new node is only reachable through
+ * the right link of the old one, and a writer splitting the new node must find it in the parent.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::InsertIntoParentBLink(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
+                                           std::vector<page_id_t> *path, size_t level, Transaction *transaction) {
+  if (old_node->IsRootPage()) {
+    root_latch_.WLock();
+    InsertIntoParent(old_node, key, new_node, transaction);
+    root_latch_.WUnlock();
+    ReleaseWLatches(transaction);
+    return;
+  }
+
+  Page *page = FindParentBLink(key, path, level);
+  auto *parent = reinterpret_cast<InternalPage *>(page->GetData());
+  parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+  old_node->SetParentPageId(page->GetPageId());
+  new_node->SetParentPageId(page->GetPageId());
+  ReleaseWLatches(transaction);
+  if (parent->GetSize() <= parent->GetMaxSize()) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+    return;
+  }
+  transaction->AddIntoPageSet(page);
+  InternalPage *new_parent = Split(parent, transaction);
+  InsertIntoParentBLink(parent, new_parent->KeyAt(0), new_parent, path, level + 1, transaction);
+}
+
+/*
+ * key is the separator of a split child, the parent that points to the child is the one whose range holds key, so
+ * the search moves right from the remembered page while key is past the high key. A level above the root the insert
+ * descended from has no remembered page. Pages only split to the right, so the page the descent started at, the
+ * first of path, is still the leftmost page of its level, and the page above it found down the left edge of the tree
+ * is the leftmost of the next level. It takes the place of the first page, and is the page remembered for its level.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindParentBLink(const KeyType &key, std::vector<page_id_t> *path, size_t level) {
+  if (level + 1 == path->size()) {
+    page_id_t page_id = root_page_id_;
+    while (true) {
+      Page *page = FetchPage(page_id);
+      page->RLatch();
+      page_id_t child = reinterpret_cast<InternalPage *>(page->GetData())->ValueAt(0);
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      if (child == path->front()) {
+        break;
+      }
+      page_id = child;
+    }
+    path->front() = page_id;
+    path->insert(path->begin() + 1, page_id);
+  }
+
+  page_id_t page_id = (*path)[path->size() - 1 - level];
+
+  while (true) {
+    Page *page = FetchPage(page_id);
+    page->WLatch();
+    auto *parent = reinterpret_cast<InternalPage *>(page->GetData());
+    if (!parent->IsPastHighKey(key, comparator_)) {
+      return page;
+    }
+    page_id = parent->GetNextPageId();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  }
+}
 
 /*****************************************************************************
  * REMOVE
@@ -114,21 +654,439 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
  * If not, User needs to first find the right leaf page as deletion target, then
  * delete entry from leaf page. Remember to deal with redistribute or merge if
  * necessary.
+ * A B-link tree only removes the key from its leaf, the leaf may be left underfull or empty.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  Page *page = FindLeafPageOptimistic(key);
+  if (page == nullptr) {
+    return;
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  if (b_link_ || IsSafe(leaf, Operation::REMOVE)) {
+    bool removed = EraseKey(leaf, key);
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), removed);
+    return;
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+
+  if (transaction != nullptr) {
+    RemoveFromLeaf(key, nullptr, transaction);
+    return;
+  }
+  Transaction local_transaction(INVALID_TXN_ID);
+  RemoveFromLeaf(key, nullptr, &local_transaction);
+}
+
+/*
+ * Remove one value of key. A value of a key with others is removed from its posting list without changing the leaf's
+ * size, only the last value of a key takes the key with it and may need the pessimistic path.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Remove(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  Page *page = FindLeafPageOptimistic(key);
+  if (page == nullptr) {
+    return;
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  int index = leaf->FindKey(key, comparator_);
+  bool last = false;
+  bool removed = index != -1 && RemoveValue(leaf, index, value, &last);
+  if (!removed || !last || b_link_ || IsSafe(leaf, Operation::REMOVE)) {
+    if (last) {
+      EraseKey(leaf, key);
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), removed);
+    return;
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+
+  if (transaction != nullptr) {
+    RemoveFromLeaf(key, &value, transaction);
+    return;
+  }
+  Transaction local_transaction(INVALID_TXN_ID);
+  RemoveFromLeaf(key, &value, &local_transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RemoveFromLeaf(const KeyType &key, const ValueType *value, Transaction *transaction) {
+  if (!FindLeafPagePessimistic(key, Operation::REMOVE, transaction)) {
+    root_latch_.WUnlock();
+    return;
+  }
+
+  //! 两次下降之间键的值可能变了, 重新判断要删的值是不是最后一个
+  auto *leaf = reinterpret_cast<LeafPage *>(transaction->GetPageSet()->back()->GetData());
+  int index = leaf->FindKey(key, comparator_);
+  bool last = value == nullptr;
+  if (index != -1 && (value == nullptr || RemoveValue(leaf, index, *value, &last)) && last) {
+    EraseKey(leaf, key);
+    CoalesceOrRedistribute(leaf, transaction);
+  }
+  if (!transaction->GetDeletedPageSet()->empty()) {
+    merge_version_++;
+  }
+  ReleaseWLatches(transaction);
+  DeletePages(transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::EraseKey(LeafPage *leaf, const KeyType &key) {
+  int index = leaf->FindKey(key, comparator_);
+  if (index == -1) {
+    return false;
+  }
+  if (IsPostingList(leaf->ValueAt(index))) {
+    DeletePostingList(leaf->ValueAt(index));
+  }
+  leaf->RemoveAndDeleteRecord(key, comparator_);
+  return true;
+}
+
+/*****************************************************************************
+ * POSTING LISTS
+ *****************************************************************************/
+/*
+ * The values of a duplicate key are sorted by RID::Get, in its inline list or across the pages of its posting list.
+ * A key with a few values keeps them in an inline list of its leaf. The list spills to a posting list once it would
+ * take more than INLINE_LIST_MAX_SIZE values. A list that has no room left to grow in its leaf is left as it is, the
+ * caller splits the leaf first, see InsertOrSplit. In a posting list a value goes to the last page whose first value is not greater than it, a full page is
+ * split in two and the value goes to the half that covers it. The caller holds the leaf write latched, which covers
+ * the posting pages.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
+bool BPLUSTREE_TYPE::AddDuplicate(LeafPage *leaf, const KeyType &key, const ValueType &value, bool *inserted) {
+  int index = duplicate_keys_ ? leaf->FindKey(key, comparator_) : -1;
+  if (index == -1) {
+    return false;
+  }
+  ValueType head = leaf->ValueAt(index);
+  if (!IsPostingList(head)) {
+    ValueType values[INLINE_LIST_MAX_SIZE + 1];
+    int count = IsInlineList(head) ? leaf->InlineListSize(head) : 1;
+    for (int i = 0; i < count; i++) {
+      values[i] = IsInlineList(head) ? leaf->InlineListValueAt(head, i) : head;
+    }
+    auto *position = std::lower_bound(values, values + count, value,
+                                      [](const ValueType &a, const ValueType &b) { return a.Get() < b.Get(); });
+    *inserted = position == values + count || !(*position == value);
+    if (!*inserted) {
+      return true;
+    }
+    std::copy_backward(position, values + count, values + count + 1);
+    *position = value;
+    count++;
+    if (count > INLINE_LIST_MAX_SIZE) {
+      leaf->SetValueAt(index, BuildPostingList(values, count));
+      return true;
+    }
+    int growth = LeafPage::InlineListBytes(count) - (count == 2 ? 0 : LeafPage::InlineListBytes(count - 1));
+    if (leaf->FreeBytes() < growth) {
+      *inserted = false;
+      return false;
+    }
+    leaf->SetInlineList(index, values, count);
+    return true;
+  }
+
+  Page *page = FetchPage(head.GetPageId());
+  auto *posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+  while (posting->GetNextPageId() != INVALID_PAGE_ID) {
+    Page *next = FetchPage(posting->GetNextPageId());
+    auto *next_posting = reinterpret_cast<BPlusTreePostingPage *>(next->GetData());
+    if (value.Get() < next_posting->ValueAt(0).Get()) {
+      buffer_pool_manager_->UnpinPage(next->GetPageId(), false);
+      break;
+    }
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = next;
+    posting = next_posting;
+  }
+
+  int position = posting->ValueIndex(value);
+  if (position < posting->GetSize() && posting->ValueAt(position) == value) {
+    *inserted = false;
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    return true;
+  }
+  if (posting->GetSize() == posting->GetMaxSize()) {
+    page_id_t new_page_id;
+    Page *new_page = buffer_pool_manager_->NewPage(&new_page_id);
+    if (new_page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "out of memory");
+    }
+    auto *new_posting = reinterpret_cast<BPlusTreePostingPage *>(new_page->GetData());
+    new_posting->Init(new_page_id);
+    posting->MoveHalfTo(new_posting);
+    new_posting->SetNextPageId(posting->GetNextPageId());
+    posting->SetNextPageId(new_page_id);
+    if (value.Get() < new_posting->ValueAt(0).Get()) {
+      posting->Insert(value);
+    } else {
+      new_posting->Insert(value);
+    }
+    buffer_pool_manager_->UnpinPage(new_page_id, true);
+  } else {
+    posting->Insert(value);
+  }
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  *inserted = true;
+  return true;
+}
+
+/*
+ * A posting page emptied by the remove is unlinked and deleted, and a posting list or an inline list down to one
+ * value gives it back to the leaf slot. No reader can see the pages in between, they are only reached under the leaf
+ * latch.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::RemoveValue(LeafPage *leaf, int index, const ValueType &value, bool *last) {
+  ValueType head = leaf->ValueAt(index);
+  if (IsInlineList(head)) {
+    ValueType values[INLINE_LIST_MAX_SIZE];
+    int count = leaf->InlineListSize(head);
+    for (int i = 0; i < count; i++) {
+      values[i] = leaf->InlineListValueAt(head, i);
+    }
+    auto *end = std::remove(values, values + count, value);
+    if (end == values + count) {
+      return false;
+    }
+    if (count == 2) {
+      leaf->SetValueAt(index, values[0]);
+    } else {
+      leaf->SetInlineList(index, values, count - 1);
+    }
+    *last = false;
+    return true;
+  }
+  if (!IsPostingList(head)) {
+    *last = head == value;
+    return *last;
+  }
+
+  Page *prev = nullptr;
+  Page *page = FetchPage(head.GetPageId());
+  auto *posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+  while (posting->GetNextPageId() != INVALID_PAGE_ID) {
+    Page *next = FetchPage(posting->GetNextPageId());
+    auto *next_posting = reinterpret_cast<BPlusTreePostingPage *>(next->GetData());
+    if (value.Get() < next_posting->ValueAt(0).Get()) {
+      buffer_pool_manager_->UnpinPage(next->GetPageId(), false);
+      break;
+    }
+    if (prev != nullptr) {
+      buffer_pool_manager_->UnpinPage(prev->GetPageId(), false);
+    }
+    prev = page;
+    page = next;
+    posting = next_posting;
+  }
+
+  bool removed = posting->Remove(value);
+  page_id_t emptied = INVALID_PAGE_ID;
+  if (removed && posting->GetSize() == 0) {
+    // the list holds two values or more, so an emptied page has a neighbour
+    if (prev != nullptr) {
+      reinterpret_cast<BPlusTreePostingPage *>(prev->GetData())->SetNextPageId(posting->GetNextPageId());
+    } else {
+      head = PostingListRef(posting->GetNextPageId());
+      leaf->SetValueAt(index, head);
+    }
+    emptied = page->GetPageId();
+  }
+  if (prev != nullptr) {
+    buffer_pool_manager_->UnpinPage(prev->GetPageId(), emptied != INVALID_PAGE_ID);
+  }
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), removed);
+  if (emptied != INVALID_PAGE_ID) {
+    buffer_pool_manager_->DeletePage(emptied);
+  }
+  if (!removed) {
+    return false;
+  }
+
+  Page *head_page = FetchPage(head.GetPageId());
+  auto *head_posting = reinterpret_cast<BPlusTreePostingPage *>(head_page->GetData());
+  bool single = head_posting->GetSize() == 1 && head_posting->GetNextPageId() == INVALID_PAGE_ID;
+  if (single) {
+    leaf->SetValueAt(index, head_posting->ValueAt(0));
+  }
+  buffer_pool_manager_->UnpinPage(head_page->GetPageId(), false);
+  if (single) {
+    buffer_pool_manager_->DeletePage(head_page->GetPageId());
+  }
+  *last = false;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::SpillInlineList(LeafPage *leaf, int index) {
+  ValueType ref = leaf->ValueAt(index);
+  if (!IsInlineList(ref)) {
+    return false;
+  }
+  ValueType values[INLINE_LIST_MAX_SIZE];
+  int count = leaf->InlineListSize(ref);
+  for (int i = 0; i < count; i++) {
+    values[i] = leaf->InlineListValueAt(ref, i);
+  }
+  leaf->SetValueAt(index, BuildPostingList(values, count));
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::SpillInlineList(LeafPage *leaf) {
+  for (int i = 0; i < leaf->GetSize(); i++) {
+    if (SpillInlineList(leaf, i)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReadPostingList(const ValueType &ref, std::vector<ValueType> *result) {
+  for (page_id_t page_id = ref.GetPageId(); page_id != INVALID_PAGE_ID;) {
+    Page *page = FetchPage(page_id);
+    auto *posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+    for (int i = 0; i < posting->GetSize(); i++) {
+      result->push_back(posting->ValueAt(i));
+    }
+    page_id = posting->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::DeletePostingList(const ValueType &ref) {
+  for (page_id_t page_id = ref.GetPageId(); page_id != INVALID_PAGE_ID;) {
+    Page *page = FetchPage(page_id);
+    page_id_t next_page_id = reinterpret_cast<BPlusTreePostingPage *>(page->GetData())->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    buffer_pool_manager_->DeletePage(page->GetPageId());
+    page_id = next_page_id;
+  }
+}
+
+/*
+ * The pages of a new posting list are filled up, later inserts split them as needed.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ValueType BPLUSTREE_TYPE::BuildPostingList(const ValueType *values, size_t count) {
+  if (count == 1) {
+    return values[0];
+  }
+  page_id_t head_page_id = INVALID_PAGE_ID;
+  Page *prev = nullptr;
+  for (size_t i = 0; i < count;) {
+    page_id_t page_id;
+    Page *page = buffer_pool_manager_->NewPage(&page_id);
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "out of memory");
+    }
+    auto *posting = reinterpret_cast<BPlusTreePostingPage *>(page->GetData());
+    posting->Init(page_id);
+    for (; i < count && posting->GetSize() < posting->GetMaxSize(); i++) {
+      posting->Append(values[i]);
+    }
+    if (prev == nullptr) {
+      head_page_id = page_id;
+    } else {
+      reinterpret_cast<BPlusTreePostingPage *>(prev->GetData())->SetNextPageId(page_id);
+      buffer_pool_manager_->UnpinPage(prev->GetPageId(), true);
+    }
+    prev = page;
+  }
+  buffer_pool_manager_->UnpinPage(prev->GetPageId(), true);
+  return PostingListRef(head_page_id);
+}
 
 /*
  * User needs to first find the sibling of input page. If sibling's size + input
  * page's size > page's max size, then redistribute. Otherwise, merge.
  * Using template N to represent either internal page or leaf page.
+ * The node, its parent and, from here on, its sibling are write latched.
  * @return: true means target leaf page should be deleted, false means no
  * deletion happens
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
-  return false;
+  if (node->IsRootPage()) {
+    if (AdjustRoot(node)) {
+      transaction->AddIntoDeletedPageSet(node->GetPageId());
+      return true;
+    }
+    return false;
+  }
+  if (node->IsLeafPage() ? !reinterpret_cast<LeafPage *>(node)->IsUnderfull() : node->GetSize() >= node->GetMinSize()) {
+    return false;
+  }
+
+  page_id_t parent_page_id = node->GetParentPageId();
+  auto *parent = reinterpret_cast<InternalPage *>(FetchPage(parent_page_id)->GetData());
+  int index = parent->ValueIndex(node->GetPageId());
+  //! 优先取左兄弟, 最左边的孩子取右兄弟
+  Page *sibling_page = FetchPage(parent->ValueAt(index == 0 ? 1 : index - 1));
+  if (node->IsLeafPage() && index != 0) {
+    // Iterators and batch inserts latch leaves from left to right, so a leaf gives up its latch to take its left
+    // sibling's first. With the parent write latched only they can take the leaf meanwhile, a batch insert may add
+    // keys to it, so the sizes are only read once both leaves are latched again.
+    Page *node_page = FetchPage(node->GetPageId());
+    node_page->WUnlatch();
+    sibling_page->WLatch();
+    node_page->WLatch();
+    buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+  } else {
+    sibling_page->WLatch();
+  }
+  transaction->AddIntoPageSet(sibling_page);
+  auto *sibling = reinterpret_cast<N *>(sibling_page->GetData());
+
+  // a leaf splits once it reaches its max size, an internal page once it goes over it
+  int max_size = node->IsLeafPage() ? node->GetMaxSize() - 1 : node->GetMaxSize();
+  bool merge = sibling->GetSize() + node->GetSize() <= max_size;
+  bool redistribute = !merge;
+  if (node->IsLeafPage()) {
+    // The fences of a merged or redistributed leaf are further apart, its prefix may get shorter and its pairs wider.
+    // The inline lists can spill to make room, the pairs cannot, a leaf that has room for neither stays underfull.
+    auto *leaf = reinterpret_cast<LeafPage *>(node);
+    auto *neighbor = reinterpret_cast<LeafPage *>(sibling);
+    LeafPage *left = index == 0 ? leaf : neighbor;
+    LeafPage *right = index == 0 ? neighbor : leaf;
+    int prefix_size = left->PrefixSizeAfterMerge(right);
+    merge = merge && left->PairBytes(prefix_size) + right->PairBytes(prefix_size) + left->SlotSize(prefix_size) <=
+                         left->SlotArea();
+    prefix_size = neighbor->GetSize() < 2 ? 0 : PrefixSizeAfterRedistribute(neighbor, leaf, index);
+    redistribute = !merge && neighbor->GetSize() >= 2 &&
+                   leaf->PairBytes(prefix_size) + 2 * leaf->SlotSize(prefix_size) <= leaf->SlotArea();
+  }
+  bool deleted = false;
+  if (merge) {
+    Coalesce(&sibling, &node, &parent, index, transaction);
+    deleted = index != 0;
+  } else if (redistribute) {
+    Redistribute(sibling, node, index);
+  }
+  buffer_pool_manager_->UnpinPage(parent_page_id, true);
+  return deleted;
+}
+
+/*
+ * @return the prefix size of leaf once a pair of neighbor moves to it, the fence between them moves into neighbor
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREE_TYPE::PrefixSizeAfterRedistribute(LeafPage *neighbor, LeafPage *leaf, int index) {
+  if (index == 0) {
+    return leaf->PrefixSizeWithHighKey(neighbor->KeyAt(1));
+  }
+  return leaf->PrefixSizeWithLowKey(neighbor->KeyAt(neighbor->GetSize() - 1));
 }
 
 /*
@@ -137,6 +1095,8 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
  * take info of deletion into account. Remember to deal with coalesce or
  * redistribute recursively if necessary.
  * Using template N to represent either internal page or leaf page.
+ * The right one of the two pages is always merged into the left one, so that the leaf chain only changes in the
+ * left page.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
  * @param   parent             parent page of input "node"
@@ -148,7 +1108,28 @@ template <typename N>
 bool BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
                               BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent, int index,
                               Transaction *transaction) {
-  return false;
+  if (index == 0) {
+    std::swap(*neighbor_node, *node);
+    index = 1;
+  }
+  N *left = *neighbor_node;
+  N *right = *node;
+  if (right->IsLeafPage()) {
+    auto *left_leaf = reinterpret_cast<LeafPage *>(left);
+    auto *right_leaf = reinterpret_cast<LeafPage *>(right);
+    // the pairs fit in the left leaf with its new prefix, their inline lists may not, they spill until they do
+    int prefix_size = left_leaf->PrefixSizeAfterMerge(right_leaf);
+    while (left_leaf->FreeBytes(prefix_size) < right_leaf->UsedBytes(prefix_size) &&
+           (SpillInlineList(right_leaf) || SpillInlineList(left_leaf))) {
+    }
+    right_leaf->MoveAllTo(left_leaf);
+  } else {
+    reinterpret_cast<InternalPage *>(right)->MoveAllTo(reinterpret_cast<InternalPage *>(left), (*parent)->KeyAt(index),
+                                                       buffer_pool_manager_);
+  }
+  transaction->AddIntoDeletedPageSet(right->GetPageId());
+  (*parent)->Remove(index);
+  return CoalesceOrRedistribute(*parent, transaction);
 }
 
 /*
@@ -162,7 +1143,46 @@ bool BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
+void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
+  page_id_t parent_page_id = node->GetParentPageId();
+  auto *parent = reinterpret_cast<InternalPage *>(FetchPage(parent_page_id)->GetData());
+  if (node->IsLeafPage()) {
+    auto *neighbor = reinterpret_cast<LeafPage *>(neighbor_node);
+    auto *leaf = reinterpret_cast<LeafPage *>(node);
+    // the pair moves with its inline list, the list spills if the leaf has no room for it with its new prefix
+    int prefix_size = PrefixSizeAfterRedistribute(neighbor, leaf, index);
+    int slot_size = leaf->SlotSize(prefix_size);
+    int moved = index == 0 ? 0 : neighbor->GetSize() - 1;
+    ValueType ref = neighbor->ValueAt(moved);
+    int list_bytes = IsInlineList(ref) ? LeafPage::InlineListBytes(neighbor->InlineListSize(ref)) : 0;
+    if (leaf->FreeBytes(prefix_size) < slot_size + list_bytes) {
+      SpillInlineList(neighbor, moved);
+    }
+    while (leaf->FreeBytes(prefix_size) < slot_size && SpillInlineList(leaf)) {
+    }
+    if (index == 0) {
+      neighbor->MoveFirstToEndOf(leaf);
+      parent->SetKeyAt(1, neighbor->KeyAt(0));
+    } else {
+      neighbor->MoveLastToFrontOf(leaf);
+      parent->SetKeyAt(index, leaf->KeyAt(0));
+    }
+  } else {
+    auto *neighbor = reinterpret_cast<InternalPage *>(neighbor_node);
+    auto *internal = reinterpret_cast<InternalPage *>(node);
+    if (index == 0) {
+      neighbor->MoveFirstToEndOf(internal, parent->KeyAt(1), buffer_pool_manager_);
+      parent->SetKeyAt(1, neighbor->KeyAt(0));
+    } else {
+      neighbor->MoveLastToFrontOf(internal, parent->KeyAt(index), buffer_pool_manager_);
+      parent->SetKeyAt(index, internal->KeyAt(0));
+    }
+  }
+  // the separator moved, it is the high key of the left one of the two
+  N *left = index == 0 ? node : neighbor_node;
+  left->SetHighKey(parent->KeyAt(index == 0 ? 1 : index));
+  buffer_pool_manager_->UnpinPage(parent_page_id, true);
+}
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
@@ -174,7 +1194,23 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
  * happend
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) { return false; }
+bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
+  if (!old_root_node->IsLeafPage() && old_root_node->GetSize() == 1) {
+    page_id_t child_page_id = reinterpret_cast<InternalPage *>(old_root_node)->RemoveAndReturnOnlyChild();
+    // the only child is write latched by the caller, it is the node that was just merged into
+    reinterpret_cast<BPlusTreePage *>(FetchPage(child_page_id)->GetData())->SetParentPageId(INVALID_PAGE_ID);
+    buffer_pool_manager_->UnpinPage(child_page_id, true);
+    root_page_id_ = child_page_id;
+    UpdateRootPageId();
+    return true;
+  }
+  if (old_root_node->IsLeafPage() && old_root_node->GetSize() == 0) {
+    root_page_id_ = INVALID_PAGE_ID;
+    UpdateRootPageId();
+    return true;
+  }
+  return false;
+}
 
 /*****************************************************************************
  * INDEX ITERATOR
@@ -185,7 +1221,10 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) { return false; }
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() { return INDEXITERATOR_TYPE(); }
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() {
+  Page *page = FindLeafPage(KeyType{}, true);
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, page, 0);
+}
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -193,7 +1232,14 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() { return INDEXITERATOR_TYPE(); }
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) { return INDEXITERATOR_TYPE(); }
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
+  Page *page = FindLeafPage(key);
+  if (page == nullptr) {
+    return End();
+  }
+  int index = reinterpret_cast<LeafPage *>(page->GetData())->KeyIndex(key, comparator_);
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, page, index);
+}
 
 /*
  * Input parameter is void, construct an index iterator representing the end
@@ -201,7 +1247,7 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) { return INDEXITERA
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::End() { return INDEXITERATOR_TYPE(); }
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::End() { return INDEXITERATOR_TYPE(buffer_pool_manager_, nullptr, 0); }
 
 /*****************************************************************************
  * UTILITIES AND DEBUG
@@ -209,10 +1255,214 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::End() { return INDEXITERATOR_TYPE(); }
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
  * the left most leaf page
+ * The pages are read latched hand over hand, the parent is released once the child is latched.
  */
 INDEX_TEMPLATE_ARGUMENTS
 Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
-  throw Exception(ExceptionType::NOT_IMPLEMENTED, "Implement this for test");
+  if (b_link_) {
+    return FindLeafPageBLink(key, false, leftMost);
+  }
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  Page *page = FetchPage(root_page_id_);
+  page->RLatch();
+  root_latch_.RUnlock();
+
+  auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  while (!node->IsLeafPage()) {
+    auto *internal = reinterpret_cast<InternalPage *>(node);
+    Page *child = FetchPage(leftMost ? internal->ValueAt(0) : internal->Lookup(key, comparator_));
+    child->RLatch();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = child;
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  }
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPageOptimistic(const KeyType &key) {
+  if (b_link_) {
+    return FindLeafPageBLink(key, true);
+  }
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  // The type of a page never changes while it is pinned, so it may be read before the page is latched.
+  Page *page = FetchPage(root_page_id_);
+  auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  if (node->IsLeafPage()) {
+    page->WLatch();
+    root_latch_.RUnlock();
+    return page;
+  }
+  page->RLatch();
+  root_latch_.RUnlock();
+
+  while (true) {
+    Page *child = FetchPage(reinterpret_cast<InternalPage *>(node)->Lookup(key, comparator_));
+    auto *child_node = reinterpret_cast<BPlusTreePage *>(child->GetData());
+    bool leaf = child_node->IsLeafPage();
+    if (leaf) {
+      child->WLatch();
+    } else {
+      child->RLatch();
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    if (leaf) {
+      return child;
+    }
+    page = child;
+    node = child_node;
+  }
+}
+
+/*
+ * Only the page being read is latched, it is released before the next one is fetched. A page split after the search
+ * read its parent has the key past its high key, the search then moves right instead of down. Pages are never deleted
+ * in B-link mode, so every page id read on the way stays valid.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPageBLink(const KeyType &key, bool exclusive, bool leftMost,
+                                        std::vector<page_id_t> *path) {
+  page_id_t page_id = root_page_id_;
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  if (path != nullptr) {
+    path->push_back(page_id);
+  }
+  while (true) {
+    // The type of a page never changes while it is pinned, so it may be read before the page is latched.
+    Page *page = FetchPage(page_id);
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    bool write = exclusive && node->IsLeafPage();
+    if (write) {
+      page->WLatch();
+    } else {
+      page->RLatch();
+    }
+
+    //! 最左路径上的节点不会被分裂移走, 不需要向右移
+    if (node->IsLeafPage()) {
+      auto *leaf = reinterpret_cast<LeafPage *>(node);
+      if (leftMost || !leaf->IsPastHighKey(key, comparator_)) {
+        return page;
+      }
+      page_id = leaf->GetNextPageId();
+    } else {
+      auto *internal = reinterpret_cast<InternalPage *>(node);
+      if (leftMost) {
+        page_id = internal->ValueAt(0);
+      } else if (internal->IsPastHighKey(key, comparator_)) {
+        page_id = internal->GetNextPageId();
+      } else {
+        page_id = internal->Lookup(key, comparator_);
+        if (path != nullptr) {
+          path->push_back(page->GetPageId());
+        }
+      }
+    }
+    if (write) {
+      page->WUnlatch();
+    } else {
+      page->RUnlatch();
+    }
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::FindLeafPagePessimistic(const KeyType &key, Operation op, Transaction *transaction) {
+  root_latch_.WLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    return false;
+  }
+  transaction->AddIntoPageSet(nullptr);
+
+  Page *page = FetchPage(root_page_id_);
+  page->WLatch();
+  auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  if (IsSafe(node, op)) {
+    ReleaseWLatches(transaction);
+  }
+  transaction->AddIntoPageSet(page);
+
+  while (!node->IsLeafPage()) {
+    page = FetchPage(reinterpret_cast<InternalPage *>(node)->Lookup(key, comparator_));
+    page->WLatch();
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (IsSafe(node, op)) {
+      ReleaseWLatches(transaction);
+    }
+    transaction->AddIntoPageSet(page);
+  }
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsSafe(BPlusTreePage *node, Operation op) const {
+  if (op == Operation::INSERT && node->IsLeafPage()) {
+    auto *leaf = reinterpret_cast<LeafPage *>(node);
+    // room for a new pair, or for an inline list to grow, which takes InlineListBytes(2) at most
+    return leaf->GetSize() + 1 < leaf->GetMaxSize() &&
+           leaf->FreeBytes() >= std::max(leaf->SlotSize(), LeafPage::InlineListBytes(2));
+  }
+  if (op == Operation::INSERT) {
+    return node->GetSize() < node->GetMaxSize();
+  }
+  //! 根节点没有最小大小, 只要删除后不需要AdjustRoot即可
+  if (node->IsRootPage()) {
+    return node->IsLeafPage() ? node->GetSize() > 1 : node->GetSize() > 2;
+  }
+  if (node->IsLeafPage()) {
+    // the removed key takes its slot and at most an inline list of the most values with it
+    auto *leaf = reinterpret_cast<LeafPage *>(node);
+    int used = leaf->UsedBytes() - leaf->SlotSize() - LeafPage::InlineListBytes(INLINE_LIST_MAX_SIZE);
+    return leaf->GetSize() > leaf->GetMinSize() || 2 * used >= leaf->SlotArea();
+  }
+  return node->GetSize() > node->GetMinSize();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleaseWLatches(Transaction *transaction) {
+  auto page_set = transaction->GetPageSet();
+  for (Page *page : *page_set) {
+    if (page == nullptr) {
+      root_latch_.WUnlock();
+      continue;
+    }
+    page->WUnlatch();
+    // every page left latched at the end of a pessimistic pass may have been changed
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  }
+  page_set->clear();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::DeletePages(Transaction *transaction) {
+  auto deleted_page_set = transaction->GetDeletedPageSet();
+  for (page_id_t page_id : *deleted_page_set) {
+    // An iterator that followed the leaf chain may still pin the page, it then stays in the pool unreachable.
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+  deleted_page_set->clear();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FetchPage(page_id_t page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "out of memory");
+  }
+  return page;
 }
 
 /*
@@ -221,19 +1471,18 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
  * Call this method everytime root page id is changed.
  * @parameter: insert_record      defualt value is false. When set to true,
  * insert a record <index_name, root_page_id> into header page instead of
- * updating it.
+ * updating it. The record of a tree that was emptied and starts again is updated.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  HeaderPage *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
-  if (insert_record != 0) {
-    // create a new record<index_name + root_page_id> in header_page
-    header_page->InsertRecord(index_name_, root_page_id_);
-  } else {
+  HeaderPage *header_page = static_cast<HeaderPage *>(FetchPage(header_page_id_));
+  header_page->WLatch();
+  if (insert_record == 0 || !header_page->InsertRecord(index_name_, root_page_id_)) {
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
+  header_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(header_page_id_, true);
 }
 
 /*
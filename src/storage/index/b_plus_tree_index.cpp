@@ -9,6 +9,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+
 #include "storage/index/b_plus_tree_index.h"
 
 namespace bustub {
@@ -16,34 +18,75 @@ namespace bustub {
  * Constructor
  */
 INDEX_TEMPLATE_ARGUMENTS
-BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager)
+BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager,
+                                     page_id_t header_page_id, double fill_factor, bool unique,
+                                     bool b_link)
     : Index(std::move(metadata)),
       comparator_(GetMetadata()->GetKeySchema()),
-      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_) {}
+      fill_factor_(fill_factor),
+      unique_(unique),
+      key_size_(static_cast<int>(KeyType::NormalizedSize(GetMetadata()->GetKeySchema()))),
+      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_,
+                 BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>::MaxCapacity(key_size_),
+                 BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>::Capacity(key_size_), header_page_id,
+                 key_size_, b_link, !unique) {}
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
   container_.Insert(index_key, rid, transaction);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::InsertEntries(IndexEntrySource *entries, Transaction *transaction) {
+  // construct insert index keys, sorted with the first of equal keys kept if the index is unique
+  std::vector<MappingType> items;
+  Tuple key;
+  RID rid;
+  while (entries->Next(&key, &rid)) {
+    MappingType &item = items.emplace_back();
+    item.first.SetFromKey(key, GetKeySchema());
+    item.second = rid;
+  }
+  std::stable_sort(items.begin(), items.end(), [this](const MappingType &a, const MappingType &b) {
+    return comparator_(a.first, b.first) < 0;
+  });
+  if (unique_) {
+    items.erase(std::unique(items.begin(), items.end(),
+                            [this](const MappingType &a, const MappingType &b) {
+                              return comparator_(a.first, b.first) == 0;
+                            }),
+                items.end());
+  }
+
+  if (!container_.BulkLoad(items, fill_factor_, transaction)) {
+    for (const auto &item : items) {
+      container_.Insert(item.first, item.second, transaction);
+    }
+  }
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct delete index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
-  container_.Remove(index_key, transaction);
+  if (unique_) {
+    container_.Remove(index_key, transaction);
+  } else {
+    container_.Remove(index_key, rid, transaction);
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
   // construct scan index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
   container_.GetValue(index_key, result, transaction);
 }
@@ -57,6 +100,98 @@ INDEXITERATOR_TYPE BPLUSTREE_INDEX_TYPE::GetBeginIterator(const KeyType &key) {
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_INDEX_TYPE::GetEndIterator() { return container_.End(); }
 
+INDEX_TEMPLATE_ARGUMENTS
+std::unique_ptr<IndexRangeCursor> BPLUSTREE_INDEX_TYPE::ScanRange(const Tuple *start_key, const Tuple *end_key,
+                                                                   Transaction *transaction) {
+  KeyType start_index_key;
+  KeyType end_index_key;
+  if (start_key != nullptr) {
+    start_index_key.SetFromKey(*start_key, GetKeySchema());
+  }
+  if (end_key != nullptr) {
+    end_index_key.SetFromKey(*end_key, GetKeySchema());
+  }
+  return std::make_unique<BPlusTreeRangeCursor<KeyType, ValueType, KeyComparator>>(
+      &container_, comparator_, GetKeySchema(), start_key != nullptr ? &start_index_key : nullptr,
+      end_key != nullptr ? &end_index_key : nullptr);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+BPlusTreeRangeCursor<KeyType, ValueType, KeyComparator>::BPlusTreeRangeCursor(
+    BPlusTree<KeyType, ValueType, KeyComparator> *tree, const KeyComparator &comparator, const Schema *key_schema,
+    const KeyType *start_key, const KeyType *end_key)
+    : tree_(tree),
+      comparator_(comparator),
+      key_schema_(key_schema),
+      has_resume_key_(start_key != nullptr),
+      has_end_key_(end_key != nullptr) {
+  if (start_key != nullptr) {
+    resume_key_ = *start_key;
+  }
+  if (end_key != nullptr) {
+    end_key_ = *end_key;
+  }
+  items_.reserve(BATCH_SIZE);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPlusTreeRangeCursor<KeyType, ValueType, KeyComparator>::Next(RID *rid) {
+  if (next_ == items_.size()) {
+    if (done_) {
+      return false;
+    }
+    Refill();
+    if (items_.empty()) {
+      return false;
+    }
+  }
+  *rid = items_[next_++].second;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPlusTreeRangeCursor<KeyType, ValueType, KeyComparator>::Next(RID *rid, std::vector<Value> *key) {
+  if (!Next(rid)) {
+    return false;
+  }
+  if (!items_[next_ - 1].first.ToValues(key_schema_, key)) {
+    key->clear();
+  }
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPlusTreeRangeCursor<KeyType, ValueType, KeyComparator>::Refill() {
+  items_.clear();
+  next_ = 0;
+  auto iterator = has_resume_key_ ? tree_->Begin(resume_key_) : tree_->Begin();
+  //! 一批总是拿完一个键的所有值, 从上一批最后一个键继续时跳过它的所有值
+  while (resuming_ && !iterator.IsEnd() && comparator_((*iterator).first, resume_key_) == 0) {
+    ++iterator;
+  }
+  for (; !iterator.IsEnd(); ++iterator) {
+    const MappingType &item = *iterator;
+    if (items_.size() >= BATCH_SIZE && comparator_(item.first, resume_key_) != 0) {
+      break;
+    }
+    if (has_end_key_ && comparator_(item.first, end_key_) > 0) {
+      done_ = true;
+      return;
+    }
+    items_.push_back(item);
+    resume_key_ = item.first;
+  }
+  has_resume_key_ = true;
+  resuming_ = true;
+  done_ = iterator.IsEnd();
+}
+
+template class BPlusTreeRangeCursor<GenericKey<4>, RID, GenericComparator<4>>;
+template class BPlusTreeRangeCursor<GenericKey<8>, RID, GenericComparator<8>>;
+template class BPlusTreeRangeCursor<GenericKey<16>, RID, GenericComparator<16>>;
+template class BPlusTreeRangeCursor<GenericKey<32>, RID, GenericComparator<32>>;
+template class BPlusTreeRangeCursor<GenericKey<64>, RID, GenericComparator<64>>;
+
 template class BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
@@ -18,16 +18,31 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);  // call GenericKey::SetFromKey
+  index_key.SetFromKey(key, GetKeySchema());  // call GenericKey::SetFromKey
 
   container_.Insert(transaction, index_key, rid);
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_INDEX_TYPE::InsertEntries(IndexEntrySource *entries, Transaction *transaction) {
+  // construct insert index keys
+  std::vector<KeyType> index_keys;
+  std::vector<RID> rids;
+  Tuple key;
+  RID rid;
+  while (entries->Next(&key, &rid)) {
+    index_keys.emplace_back().SetFromKey(key, GetKeySchema());
+    rids.push_back(rid);
+  }
+
+  container_.BulkLoad(transaction, index_keys, rids);
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct delete index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
   container_.Remove(transaction, index_key, rid);
 }
@@ -36,10 +51,28 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
   // construct scan index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
   container_.GetValue(transaction, index_key, result);
 }
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_INDEX_TYPE::ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                                     Transaction *transaction) {
+  // construct scan index keys
+  std::vector<KeyType> index_keys(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    index_keys[i].SetFromKey(keys[i], GetKeySchema());
+  }
+
+  container_.GetValues(transaction, index_keys, results);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+ExtendibleHashTableStats HASH_TABLE_INDEX_TYPE::GetStats(Transaction *transaction) {
+  return container_.GetStats(transaction);
+}
+
 template class ExtendibleHashTableIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class ExtendibleHashTableIndex<GenericKey<8>, RID, GenericComparator<8>>;
 template class ExtendibleHashTableIndex<GenericKey<16>, RID, GenericComparator<16>>;
@@ -7,24 +7,177 @@
 
 namespace bustub {
 
-/*
- * NOTE: you can change the destructor/constructor method here
- * set your own input parameters
- */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator() = default;
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *buffer_pool_manager, Page *page, int index)
+    : buffer_pool_manager_(buffer_pool_manager),
+      page_(page),
+      leaf_(page == nullptr ? nullptr : reinterpret_cast<LeafPage *>(page->GetData())),
+      index_(index) {
+  if (page_ != nullptr) {
+    PrefetchNextLeaf();
+  }
+  SkipToValid();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::~IndexIterator() {
+  if (page_ != nullptr) {
+    Release();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(IndexIterator &&other) noexcept
+    : buffer_pool_manager_(other.buffer_pool_manager_),
+      page_(other.page_),
+      leaf_(other.leaf_),
+      index_(other.index_),
+      posting_page_(other.posting_page_),
+      inline_size_(other.inline_size_),
+      posting_index_(other.posting_index_) {
+  other.page_ = nullptr;
+  other.leaf_ = nullptr;
+  other.posting_page_ = nullptr;
+  other.inline_size_ = 0;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator=(IndexIterator &&other) noexcept {
+  if (this != &other) {
+    if (page_ != nullptr) {
+      Release();
+    }
+    buffer_pool_manager_ = other.buffer_pool_manager_;
+    page_ = other.page_;
+    leaf_ = other.leaf_;
+    index_ = other.index_;
+    posting_page_ = other.posting_page_;
+    inline_size_ = other.inline_size_;
+    posting_index_ = other.posting_index_;
+    other.page_ = nullptr;
+    other.leaf_ = nullptr;
+    other.posting_page_ = nullptr;
+    other.inline_size_ = 0;
+  }
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool INDEXITERATOR_TYPE::IsEnd() { return page_ == nullptr; }
+
+INDEX_TEMPLATE_ARGUMENTS
+const MappingType &INDEXITERATOR_TYPE::operator*() {
+  assert(page_ != nullptr);
+  if (posting_page_ != nullptr) {
+    auto *posting = reinterpret_cast<BPlusTreePostingPage *>(posting_page_->GetData());
+    item_ = MappingType(leaf_->KeyAt(index_), posting->ValueAt(posting_index_));
+  } else if (inline_size_ != 0) {
+    item_ = MappingType(leaf_->KeyAt(index_), leaf_->InlineListValueAt(leaf_->ValueAt(index_), posting_index_));
+  } else {
+    item_ = leaf_->GetItem(index_);
+  }
+  return item_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
+  assert(page_ != nullptr);
+  if ((posting_page_ != nullptr || inline_size_ != 0) && NextPostingValue()) {
+    return *this;
+  }
+  index_++;
+  SkipToValid();
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SkipToValid() {
+  while (page_ != nullptr && index_ >= leaf_->GetSize()) {
+    page_id_t next_page_id = leaf_->GetNextPageId();
+    if (next_page_id == INVALID_PAGE_ID) {
+      Release();
+      return;
+    }
+    //! 先拿到下一个叶子的读锁再释放当前叶子, 写者也按从左到右的顺序锁兄弟叶子, 不会死锁
+    Page *next = buffer_pool_manager_->FetchPage(next_page_id);
+    assert(next != nullptr);
+    next->RLatch();
+    Release();
+    page_ = next;
+    leaf_ = reinterpret_cast<LeafPage *>(next->GetData());
+    index_ = 0;
+    PrefetchNextLeaf();
+  }
+  if (page_ != nullptr) {
+    EnterPostingList();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::PrefetchNextLeaf() {
+  page_id_t next_page_id = leaf_->GetNextPageId();
+  if (next_page_id != INVALID_PAGE_ID) {
+    buffer_pool_manager_->PrefetchPage(next_page_id);
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() = default;
+void INDEXITERATOR_TYPE::EnterPostingList() {
+  ValueType value = leaf_->ValueAt(index_);
+  if (IsInlineList(value)) {
+    inline_size_ = leaf_->InlineListSize(value);
+    posting_index_ = 0;
+    return;
+  }
+  if (!IsPostingList(value)) {
+    return;
+  }
+  posting_page_ = buffer_pool_manager_->FetchPage(value.GetPageId());
+  assert(posting_page_ != nullptr);
+  posting_index_ = 0;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-bool INDEXITERATOR_TYPE::IsEnd() { throw std::runtime_error("unimplemented"); }
+bool INDEXITERATOR_TYPE::NextPostingValue() {
+  if (inline_size_ != 0) {
+    if (++posting_index_ < inline_size_) {
+      return true;
+    }
+    inline_size_ = 0;
+    return false;
+  }
+  auto *posting = reinterpret_cast<BPlusTreePostingPage *>(posting_page_->GetData());
+  if (++posting_index_ < posting->GetSize()) {
+    return true;
+  }
+  page_id_t next_page_id = posting->GetNextPageId();
+  ReleasePostingPage();
+  if (next_page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  posting_page_ = buffer_pool_manager_->FetchPage(next_page_id);
+  assert(posting_page_ != nullptr);
+  posting_index_ = 0;
+  return true;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &INDEXITERATOR_TYPE::operator*() { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::ReleasePostingPage() {
+  buffer_pool_manager_->UnpinPage(posting_page_->GetPageId(), false);
+  posting_page_ = nullptr;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::Release() {
+  if (posting_page_ != nullptr) {
+    ReleasePostingPage();
+  }
+  inline_size_ = 0;
+  page_->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+  page_ = nullptr;
+  leaf_ = nullptr;
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
@@ -9,6 +9,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
 #include <sstream>
 
 #include "common/exception.h"
@@ -27,43 +30,299 @@ namespace bustub {
  * next page id and set max size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size, int key_size) {
+  SetPageType(IndexPageType::LEAF_PAGE);
+  SetSize(0);
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetMaxSize(max_size);
+  SetKeySize(key_size);
+  inline_size_ = 0;
+  prefix_size_ = 0;
+  has_low_key_ = 0;
+}
 
 /**
  * Helper methods to set/get next page id
  */
 INDEX_TEMPLATE_ARGUMENTS
-page_id_t B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const { return INVALID_PAGE_ID; }
+page_id_t B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const { return next_page_id_; }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+/**
+ * Helper methods to set/get the fence keys, the high key is only meaningful while the next page id is valid and the
+ * low key while the page has one. Setting a fence stores the pairs again if the prefix changes, the page must have
+ * room for them.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::GetHighKey() const {
+  KeyType key;
+  memcpy(&key, array_, GetKeySize());
+  memset(reinterpret_cast<char *>(&key) + GetKeySize(), 0, sizeof(KeyType) - GetKeySize());
+  return key;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetHighKey(const KeyType &key) {
+  // the prefix is stored as the start of the high key
+  char prefix[sizeof(KeyType)];
+  memcpy(prefix, array_, prefix_size_);
+  memcpy(array_, &key, GetKeySize());
+  UpdatePrefix(prefix);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::GetLowKey() const {
+  KeyType key;
+  memcpy(&key, array_ + GetKeySize(), GetKeySize());
+  memset(reinterpret_cast<char *>(&key) + GetKeySize(), 0, sizeof(KeyType) - GetKeySize());
+  return key;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetLowKey(const KeyType &key) {
+  memcpy(array_ + GetKeySize(), &key, GetKeySize());
+  has_low_key_ = 1;
+  UpdatePrefix(array_);
+}
 
 /**
  * Helper method to find the first index i so that array[i].first >= key
  * NOTE: This method is only used when generating index iterator
+ * A key that does not start with the prefix is before or after every key of the page.
  */
 INDEX_TEMPLATE_ARGUMENTS
-int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator &comparator) const { return 0; }
+int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator &comparator) const {
+  if (prefix_size_ > 0) {
+    int cmp = memcmp(array_, &key, prefix_size_);
+    if (cmp != 0) {
+      return cmp > 0 ? 0 : GetSize();
+    }
+  }
+  return SearchStoredKeys<false>(SlotAt(0), GetSize(), SlotSize(), GetKeySize(), key, comparator, prefix_size_);
+}
+
+/*
+ * Helper method to find the index of key, -1 if the page does not hold it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::FindKey(const KeyType &key, const KeyComparator &comparator) const {
+  int index = KeyIndex(key, comparator);
+  if (index == GetSize() || CompareKeyAt(index, key, comparator) != 0) {
+    return -1;
+  }
+  return index;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::CompareKeyAt(int index, const KeyType &key, const KeyComparator &comparator) const {
+  if (prefix_size_ > 0) {
+    int cmp = memcmp(array_, &key, prefix_size_);
+    if (cmp != 0) {
+      return cmp > 0 ? 1 : -1;
+    }
+  }
+  return CompareStoredKey(SlotAt(index), GetKeySize(), key, comparator, prefix_size_);
+}
 
 /*
  * Helper method to find and return the key associated with input "index"(a.k.a
  * array offset)
+ * Only the first KeySize bytes are stored, the rest of the key is zero. The prefix is stored once.
  */
 INDEX_TEMPLATE_ARGUMENTS
 KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const {
-  // replace with your own code
-  KeyType key{};
+  KeyType key;
+  auto *data = reinterpret_cast<char *>(&key);
+  memcpy(data, array_, prefix_size_);
+  memcpy(data + prefix_size_, SlotAt(index), SuffixSize());
+  memset(data + GetKeySize(), 0, sizeof(KeyType) - GetKeySize());
   return key;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+ValueType B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const {
+  ValueType value;
+  memcpy(&value, SlotAt(index) + SuffixSize(), sizeof(ValueType));
+  return value;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetValueAt(int index, const ValueType &value) {
+  bool had_list = IsInlineList(ValueAt(index));
+  SetSlotValue(index, value);
+  if (had_list) {
+    CompactInlineLists();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetSlotValue(int index, const ValueType &value) {
+  memcpy(SlotAt(index) + SuffixSize(), &value, sizeof(ValueType));
+}
+
+/*
+ * The key lies between the fences, it starts with the prefix.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetItem(int index, const KeyType &key, const ValueType &value) {
+  assert(memcmp(array_, &key, prefix_size_) == 0);
+  memcpy(SlotAt(index), reinterpret_cast<const char *>(&key) + prefix_size_, SuffixSize());
+  memcpy(SlotAt(index) + SuffixSize(), &value, sizeof(ValueType));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::ShiftItems(int to, int from) {
+  memmove(SlotAt(to), SlotAt(from), (GetSize() - from) * SlotSize());
+}
+
 /*
  * Helper method to find and return the key & value pair associated with input
  * "index"(a.k.a array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) {
-  // replace with your own code
-  return array_[0];
+MappingType B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) const { return MappingType(KeyAt(index), ValueAt(index)); }
+
+/*****************************************************************************
+ * PREFIX
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::FencePrefixSize(const char *low, const char *high) const {
+  if constexpr (!IsGenericComparator<KeyComparator>::value) {  // NOLINT
+    return 0;
+  }
+  if (low == nullptr || high == nullptr) {
+    return 0;
+  }
+  int size = 0;
+  while (size < GetKeySize() && low[size] == high[size]) {
+    size++;
+  }
+  return size;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::PrefixSizeAfterMerge(const BPlusTreeLeafPage *right) const {
+  return FencePrefixSize(HasLowKey() ? array_ + GetKeySize() : nullptr,
+                         right->GetNextPageId() != INVALID_PAGE_ID ? right->array_ : nullptr);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::PrefixSizeWithHighKey(const KeyType &key) const {
+  return FencePrefixSize(HasLowKey() ? array_ + GetKeySize() : nullptr, reinterpret_cast<const char *>(&key));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::PrefixSizeWithLowKey(const KeyType &key) const {
+  return FencePrefixSize(reinterpret_cast<const char *>(&key), next_page_id_ != INVALID_PAGE_ID ? array_ : nullptr);
+}
+
+/*
+ * A longer prefix drops its new bytes from the front of every slot, the slots are moved down in order. A shorter one
+ * puts the bytes it no longer holds back in front of every slot, the slots are moved up from the last one.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::UpdatePrefix(const char *prefix) {
+  int old_prefix_size = prefix_size_;
+  int new_prefix_size = FencePrefixSize(HasLowKey() ? array_ + GetKeySize() : nullptr,
+                                        next_page_id_ != INVALID_PAGE_ID ? array_ : nullptr);
+  if (new_prefix_size == old_prefix_size) {
+    return;
+  }
+  char *slots = array_ + 2 * GetKeySize();
+  int old_slot_size = SlotSize(old_prefix_size);
+  int new_slot_size = SlotSize(new_prefix_size);
+  if (new_prefix_size > old_prefix_size) {
+    int dropped = new_prefix_size - old_prefix_size;
+    for (int i = 0; i < GetSize(); i++) {
+      memmove(slots + i * new_slot_size, slots + i * old_slot_size + dropped, new_slot_size);
+    }
+  } else {
+    int restored = old_prefix_size - new_prefix_size;
+    assert(GetSize() * new_slot_size + inline_size_ <= SlotArea());
+    for (int i = GetSize() - 1; i >= 0; i--) {
+      memmove(slots + i * new_slot_size + restored, slots + i * old_slot_size, old_slot_size);
+      memcpy(slots + i * new_slot_size, prefix + new_prefix_size, restored);
+    }
+  }
+  prefix_size_ = new_prefix_size;
+}
+
+/*****************************************************************************
+ * INLINE LISTS
+ *****************************************************************************/
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::InlineListSize(const ValueType &ref) const {
+  int32_t count;
+  memcpy(&count, InlineListAt(ref.GetPageId()), sizeof(int32_t));
+  return count;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+ValueType B_PLUS_TREE_LEAF_PAGE_TYPE::InlineListValueAt(const ValueType &ref, int index) const {
+  ValueType value;
+  memcpy(&value, InlineListAt(ref.GetPageId()) + sizeof(int32_t) + index * sizeof(ValueType), sizeof(ValueType));
+  return value;
+}
+
+/*
+ * The old list is dropped first, so the page only needs room for the growth of the list.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetInlineList(int index, const ValueType *values, int count) {
+  SetValueAt(index, values[0]);
+  inline_size_ += InlineListBytes(count);
+  int offset = PAGE_SIZE - inline_size_;
+  auto count32 = static_cast<int32_t>(count);
+  memcpy(InlineListAt(offset), &count32, sizeof(int32_t));
+  memcpy(InlineListAt(offset) + sizeof(int32_t), values, count * sizeof(ValueType));
+  SetSlotValue(index, InlineListRef(offset));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyInlineListsFrom(const BPlusTreeLeafPage *donor, int index, int n) {
+  if (donor->inline_size_ == 0) {
+    return;
+  }
+  for (int i = index; i < index + n; i++) {
+    ValueType ref = ValueAt(i);
+    if (!IsInlineList(ref)) {
+      continue;
+    }
+    int bytes = InlineListBytes(donor->InlineListSize(ref));
+    inline_size_ += bytes;
+    int offset = PAGE_SIZE - inline_size_;
+    memcpy(InlineListAt(offset), donor->InlineListAt(ref.GetPageId()), bytes);
+    SetSlotValue(i, InlineListRef(offset));
+  }
+}
+
+/*
+ * The lists still referred to are copied out in the order of their keys and written back to the end of the page.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CompactInlineLists() {
+  if (inline_size_ == 0) {
+    return;
+  }
+  char lists[PAGE_SIZE];
+  int size = 0;
+  for (int i = 0; i < GetSize(); i++) {
+    ValueType ref = ValueAt(i);
+    if (!IsInlineList(ref)) {
+      continue;
+    }
+    int bytes = InlineListBytes(InlineListSize(ref));
+    size += bytes;
+    memcpy(lists + PAGE_SIZE - size, InlineListAt(ref.GetPageId()), bytes);
+    SetSlotValue(i, InlineListRef(PAGE_SIZE - size));
+  }
+  memcpy(InlineListAt(PAGE_SIZE - size), lists + PAGE_SIZE - size, size);
+  inline_size_ = size;
 }
 
 /*****************************************************************************
@@ -75,7 +334,25 @@ const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator) {
-  return 0;
+  //! 每个键只存一次, 键已存在时不插入, 返回的大小不变; 重复键的值由BPlusTree加到posting list里
+  int index = KeyIndex(key, comparator);
+  if (index < GetSize() && CompareKeyAt(index, key, comparator) == 0) {
+    return GetSize();
+  }
+  ShiftItems(index + 1, index);
+  SetItem(index, key, value);
+  IncreaseSize(1);
+  return GetSize();
+}
+
+/*
+ * Append a pair after the last one, its key is greater than every key in the page.
+ * Used by bulk loading, which feeds the pairs in order.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Append(const KeyType &key, const ValueType &value) {
+  SetItem(GetSize(), key, value);
+  IncreaseSize(1);
 }
 
 /*****************************************************************************
@@ -83,15 +360,50 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &valu
  *****************************************************************************/
 /*
  * Remove half of key & value pairs from this page to "recipient" page
+ * A page that is out of room before its max size, or has inline lists, is split at half of its bytes instead, so that
+ * neither page is left out of room when the large lists are on one side.
+ * The recipient is a new page, it is linked to the right of this one. The first key it takes is the fence between
+ * them, both pages keep the prefix they had or get a longer one.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {
+  int keep = GetMinSize();
+  if (inline_size_ > 0 || GetSize() < GetMaxSize()) {
+    int half = UsedBytes() / 2;
+    int bytes = 0;
+    for (keep = 0; keep < GetSize() - 1 && bytes < half; keep++) {
+      ValueType value = ValueAt(keep);
+      bytes += SlotSize() + (IsInlineList(value) ? InlineListBytes(InlineListSize(value)) : 0);
+    }
+    keep = std::max(keep, 1);
+  }
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
+  recipient->SetLowKey(KeyAt(keep));
+  recipient->CopyNFrom(this, keep, GetSize() - keep);
+  recipient->CopyInlineListsFrom(this, 0, GetSize() - keep);
+  SetSize(keep);
+  SetNextPageId(recipient->GetPageId());
+  SetHighKey(recipient->KeyAt(0));
+  CompactInlineLists();
+}
 
 /*
- * Copy starting from items, and copy {size} number of elements into me.
+ * Copy the n pairs of donor from index after mine.
+ * The pairs come from a page of the same tree, with the same key size. They are copied as they are if both pages have
+ * the same prefix, else their keys are stored again with mine.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(const BPlusTreeLeafPage *donor, int index, int n) {
+  if (donor->prefix_size_ == prefix_size_) {
+    memcpy(SlotAt(GetSize()), donor->SlotAt(index), n * SlotSize());
+  } else {
+    for (int i = 0; i < n; i++) {
+      SetItem(GetSize() + i, donor->KeyAt(index + i), donor->ValueAt(index + i));
+    }
+  }
+  IncreaseSize(n);
+}
 
 /*****************************************************************************
  * LOOKUP
@@ -103,7 +415,12 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {}
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const {
-  return false;
+  int index = FindKey(key, comparator);
+  if (index == -1) {
+    return false;
+  }
+  *value = ValueAt(index);
+  return true;
 }
 
 /*****************************************************************************
@@ -116,7 +433,19 @@ bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, co
  * @return   page size after deletion
  */
 INDEX_TEMPLATE_ARGUMENTS
-int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator) { return 0; }
+int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator) {
+  int index = FindKey(key, comparator);
+  if (index == -1) {
+    return GetSize();
+  }
+  bool had_list = IsInlineList(ValueAt(index));
+  ShiftItems(index, index + 1);
+  IncreaseSize(-1);
+  if (had_list) {
+    CompactInlineLists();
+  }
+  return GetSize();
+}
 
 /*****************************************************************************
  * MERGE
@@ -124,36 +453,73 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const
 /*
  * Remove all of key & value pairs from this page to "recipient" page. Don't forget
  * to update the next_page id in the sibling page
+ * The recipient is the left sibling, it takes over the right link and the high key before it takes the pairs, its
+ * prefix may get shorter.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
+  int start = recipient->GetSize();
+  recipient->CopyNFrom(this, 0, GetSize());
+  recipient->CopyInlineListsFrom(this, start, GetSize());
+  SetSize(0);
+  inline_size_ = 0;
+}
 
 /*****************************************************************************
  * REDISTRIBUTE
  *****************************************************************************/
 /*
  * Remove the first key & value pair from this page to "recipient" page.
+ * The recipient is the left sibling, the second key of this page becomes the fence between them.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {
+  recipient->SetHighKey(KeyAt(1));
+  recipient->CopyLastFrom(KeyAt(0), ValueAt(0));
+  recipient->CopyInlineListsFrom(this, recipient->GetSize() - 1, 1);
+  ShiftItems(0, 1);
+  IncreaseSize(-1);
+  SetLowKey(KeyAt(0));
+  CompactInlineLists();
+}
 
 /*
  * Copy the item into the end of my item list. (Append item to my array)
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const KeyType &key, const ValueType &value) {
+  SetItem(GetSize(), key, value);
+  IncreaseSize(1);
+}
 
 /*
  * Remove the last key & value pair from this page to "recipient" page.
+ * The recipient is the right sibling, the moved key becomes the fence between them.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {
+  KeyType key = KeyAt(GetSize() - 1);
+  recipient->SetLowKey(key);
+  recipient->CopyFirstFrom(key, ValueAt(GetSize() - 1));
+  recipient->CopyInlineListsFrom(this, 0, 1);
+  IncreaseSize(-1);
+  SetHighKey(key);
+  CompactInlineLists();
+}
 
 /*
  * Insert item at the front of my items. Move items accordingly.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(const MappingType &item) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(const KeyType &key, const ValueType &value) {
+  ShiftItems(1, 0);
+  SetItem(0, key, value);
+  IncreaseSize(1);
+}
+
+template class BPlusTreeLeafPage<int, RID, IntComparator>;
 
 template class BPlusTreeLeafPage<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
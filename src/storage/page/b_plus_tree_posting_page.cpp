@@ -0,0 +1,68 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/page/b_plus_tree_posting_page.cpp
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstring>
+
+#include "storage/page/b_plus_tree_posting_page.h"
+
+namespace bustub {
+
+void BPlusTreePostingPage::Init(page_id_t page_id, int max_size) {
+  SetPageType(IndexPageType::POSTING_PAGE);
+  SetSize(0);
+  SetPageId(page_id);
+  SetParentPageId(INVALID_PAGE_ID);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetMaxSize(max_size);
+  SetKeySize(0);
+}
+
+int BPlusTreePostingPage::ValueIndex(const RID &rid) const {
+  return static_cast<int>(std::lower_bound(array_, array_ + GetSize(), rid,
+                                           [](const RID &a, const RID &b) { return a.Get() < b.Get(); }) -
+                          array_);
+}
+
+bool BPlusTreePostingPage::Insert(const RID &rid) {
+  int index = ValueIndex(rid);
+  if (index < GetSize() && array_[index] == rid) {
+    return false;
+  }
+  memmove(array_ + index + 1, array_ + index, (GetSize() - index) * sizeof(RID));
+  array_[index] = rid;
+  IncreaseSize(1);
+  return true;
+}
+
+void BPlusTreePostingPage::Append(const RID &rid) {
+  array_[GetSize()] = rid;
+  IncreaseSize(1);
+}
+
+bool BPlusTreePostingPage::Remove(const RID &rid) {
+  int index = ValueIndex(rid);
+  if (index == GetSize() || !(array_[index] == rid)) {
+    return false;
+  }
+  memmove(array_ + index, array_ + index + 1, (GetSize() - index - 1) * sizeof(RID));
+  IncreaseSize(-1);
+  return true;
+}
+
+void BPlusTreePostingPage::MoveHalfTo(BPlusTreePostingPage *recipient) {
+  int keep = GetSize() / 2;
+  memcpy(recipient->array_, array_ + keep, (GetSize() - keep) * sizeof(RID));
+  recipient->SetSize(GetSize() - keep);
+  SetSize(keep);
+}
+
+}  // namespace bustub
@@ -17,30 +17,49 @@ namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 KeyType HASH_TABLE_BLOCK_TYPE::KeyAt(slot_offset_t bucket_ind) const {
-  return {};
+  return array_[bucket_ind].first;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 ValueType HASH_TABLE_BLOCK_TYPE::ValueAt(slot_offset_t bucket_ind) const {
-  return {};
+  return array_[bucket_ind].second;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BLOCK_TYPE::Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value) {
-  return false;
+  char mask = static_cast<char>(1 << (bucket_ind % 8));
+  // claim the slot, only one inserter can flip the occupied bit
+  if ((occupied_[bucket_ind / 8].fetch_or(mask) & mask) != 0) {
+    return false;
+  }
+  array_[bucket_ind] = MappingType(key, value);
+  // publish the pair to the readers
+  readable_[bucket_ind / 8].fetch_or(mask, std::memory_order_release);
+  return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BLOCK_TYPE::Remove(slot_offset_t bucket_ind) {}
+void HASH_TABLE_BLOCK_TYPE::Remove(slot_offset_t bucket_ind) {
+  readable_[bucket_ind / 8].fetch_and(static_cast<char>(~(1 << (bucket_ind % 8))));
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BLOCK_TYPE::IsOccupied(slot_offset_t bucket_ind) const {
-  return false;
+  return (occupied_[bucket_ind / 8].load(std::memory_order_acquire) & (1 << (bucket_ind % 8))) != 0;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BLOCK_TYPE::IsReadable(slot_offset_t bucket_ind) const {
-  return false;
+  return (readable_[bucket_ind / 8].load(std::memory_order_acquire) & (1 << (bucket_ind % 8))) != 0;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t HASH_TABLE_BLOCK_TYPE::NumReadable() const {
+  uint32_t num = 0;
+  for (const auto &readable : readable_) {
+    num += __builtin_popcount(static_cast<uint8_t>(readable.load(std::memory_order_relaxed)));
+  }
+  return num;
 }
 
 // DO NOT REMOVE ANYTHING BELOW THIS LINE
@@ -51,4 +70,16 @@ template class HashTableBlockPage<GenericKey<16>, RID, GenericComparator<16>>;
 template class HashTableBlockPage<GenericKey<32>, RID, GenericComparator<32>>;
 template class HashTableBlockPage<GenericKey<64>, RID, GenericComparator<64>>;
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+constexpr bool BlockFitsInPage() {
+  return sizeof(HASH_TABLE_BLOCK_TYPE) + BLOCK_ARRAY_SIZE * sizeof(MappingType) <= PAGE_SIZE;
+}
+
+static_assert(BlockFitsInPage<int, int, IntComparator>());
+static_assert(BlockFitsInPage<GenericKey<4>, RID, GenericComparator<4>>());
+static_assert(BlockFitsInPage<GenericKey<8>, RID, GenericComparator<8>>());
+static_assert(BlockFitsInPage<GenericKey<16>, RID, GenericComparator<16>>());
+static_assert(BlockFitsInPage<GenericKey<32>, RID, GenericComparator<32>>());
+static_assert(BlockFitsInPage<GenericKey<64>, RID, GenericComparator<64>>());
+
 }  // namespace bustub
@@ -11,6 +11,15 @@
 //===----------------------------------------------------------------------===//
 
 #include "storage/page/hash_table_bucket_page.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
 #include "common/logger.h"
 #include "common/util/hash_util.h"
 #include "storage/index/generic_key.h"
@@ -19,13 +28,91 @@
 
 namespace bustub {
 
+namespace {
+// Slots are probed in groups of 32, one bit per slot in a uint32_t mask.
+constexpr uint32_t PROBE_WIDTH = 32;
+
+// @return a mask of the bytes of bytes[0, 32) that are equal to fingerprint
+inline uint32_t MatchBytes32(const uint8_t *bytes, uint8_t fingerprint) {
+#if defined(__AVX2__)
+  __m256i needle = _mm256_set1_epi8(static_cast<char>(fingerprint));
+  __m256i haystack = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes));
+  return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(needle, haystack)));
+#elif defined(__SSE2__)
+  __m128i needle = _mm_set1_epi8(static_cast<char>(fingerprint));
+  __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes));
+  __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + 16));
+  auto low_mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(needle, low)));
+  auto high_mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(needle, high)));
+  return low_mask | (high_mask << 16);
+#else
+  uint32_t mask = 0;
+  for (uint32_t i = 0; i < PROBE_WIDTH; i++) {
+    mask |= static_cast<uint32_t>(bytes[i] == fingerprint) << i;
+  }
+  return mask;
+#endif
+}
+}  // namespace
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint8_t HASH_TABLE_BUCKET_TYPE::Fingerprint(const KeyType &key) {
+  hash_t hash = HashUtil::HashBytes(reinterpret_cast<const char *>(&key), sizeof(KeyType));
+  // HashBytes mixes poorly into the high bits, spread it out before taking the top byte.
+  return static_cast<uint8_t>((static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL) >> 56);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t HASH_TABLE_BUCKET_TYPE::ReadableWord(uint32_t start) const {
+  // readable_ is little-endian bit order, so 4 bytes read as a uint32_t on x86 line up with the slots.
+  uint32_t word = 0;
+  size_t offset = start / 8;
+  memcpy(&word, readable_ + offset, std::min(sizeof(uint32_t), sizeof(readable_) - offset));
+  return word;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t HASH_TABLE_BUCKET_TYPE::MatchFingerprint(uint32_t start, uint8_t fingerprint) const {
+  uint32_t readable = ReadableWord(start);
+  if (readable == 0) {
+    return 0;
+  }
+  if (start + PROBE_WIDTH <= BUCKET_ARRAY_SIZE) {
+    return readable & MatchBytes32(fingerprints_ + start, fingerprint);
+  }
+  // the last, partial group
+  uint32_t mask = 0;
+  for (uint32_t i = start; i < BUCKET_ARRAY_SIZE; i++) {
+    mask |= static_cast<uint32_t>(fingerprints_[i] == fingerprint) << (i - start);
+  }
+  return readable & mask;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t HASH_TABLE_BUCKET_TYPE::FindFreeSlot() const {
+  for (uint32_t start = 0; start < BUCKET_ARRAY_SIZE; start += PROBE_WIDTH) {
+    uint32_t free = ~ReadableWord(start);
+    if (start + PROBE_WIDTH > BUCKET_ARRAY_SIZE) {
+      free &= (1U << (BUCKET_ARRAY_SIZE - start)) - 1;
+    }
+    if (free != 0) {
+      return start + __builtin_ctz(free);
+    }
+  }
+  return BUCKET_ARRAY_SIZE;
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) {
   bool res = false;
-  for (size_t i = 0; i < BUCKET_ARRAY_SIZE; ++i) {
-    if (IsReadable(i) && cmp(key, array_[i].first) == 0) {
-      result->push_back(array_[i].second);
-      res = true;
+  uint8_t fingerprint = Fingerprint(key);
+  for (uint32_t start = 0; start < BUCKET_ARRAY_SIZE; start += PROBE_WIDTH) {
+    for (uint32_t match = MatchFingerprint(start, fingerprint); match != 0; match &= match - 1) {
+      uint32_t i = start + __builtin_ctz(match);
+      if (cmp(key, array_[i].first) == 0) {
+        result->push_back(array_[i].second);
+        res = true;
+      }
     }
   }
   return res;
@@ -33,19 +120,19 @@ bool HASH_TABLE_BUCKET_TYPE::GetValue(KeyType key, KeyComparator cmp, std::vecto
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::Insert(KeyType key, ValueType value, KeyComparator cmp) {
-  int64_t free_slot = -1;
-  for (size_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
-    if (IsReadable(i)) {
+  uint8_t fingerprint = Fingerprint(key);
+  for (uint32_t start = 0; start < BUCKET_ARRAY_SIZE; start += PROBE_WIDTH) {
+    for (uint32_t match = MatchFingerprint(start, fingerprint); match != 0; match &= match - 1) {
+      uint32_t i = start + __builtin_ctz(match);
       if (cmp(key, array_[i].first) == 0 && value == array_[i].second) {
         // already existed the same key & value
         return false;
       }
-    } else if (free_slot == -1) {
-      free_slot = i;
     }
   }
 
-  if (free_slot == -1) {
+  uint32_t free_slot = FindFreeSlot();
+  if (free_slot == BUCKET_ARRAY_SIZE) {
     // is full
     LOG_DEBUG("Bucket is full");
     return false;
@@ -54,14 +141,17 @@ bool HASH_TABLE_BUCKET_TYPE::Insert(KeyType key, ValueType value, KeyComparator
   // insert it and return true
   SetOccupied(free_slot);
   SetReadable(free_slot);
+  fingerprints_[free_slot] = fingerprint;
   array_[free_slot] = MappingType(key, value);
   return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::Remove(KeyType key, ValueType value, KeyComparator cmp) {
-  for (size_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
-    if (IsReadable(i)) {
+  uint8_t fingerprint = Fingerprint(key);
+  for (uint32_t start = 0; start < BUCKET_ARRAY_SIZE; start += PROBE_WIDTH) {
+    for (uint32_t match = MatchFingerprint(start, fingerprint); match != 0; match &= match - 1) {
+      uint32_t i = start + __builtin_ctz(match);
       if (cmp(key, array_[i].first) == 0 && value == array_[i].second) {
         // find it
         RemoveAt(i);
@@ -141,65 +231,23 @@ void HASH_TABLE_BUCKET_TYPE::SetReadable(uint32_t bucket_idx, bool isReadable) {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::IsFull() {
-  u_int8_t mask = 255;
-  size_t times = BUCKET_ARRAY_SIZE / 8;
-  for (size_t i = 0; i < times; i++) {
-    char c = readable_[i];
-    uint8_t ic = static_cast<uint8_t>(c);
-    if ((ic & mask) != mask) {
-      return false;
-    }
-  }
-
-  size_t remain = BUCKET_ARRAY_SIZE % 8;
-  if (remain > 0) {
-    char c = readable_[times];
-    uint8_t ic = static_cast<uint8_t>(c);
-    for (size_t i = 0; i < remain; i++) {
-      if ((ic & 1) != 1) {
-        return false;
-      }
-      ic = ic >> 1;
-    }
-  }
-  return true;
+  return FindFreeSlot() == BUCKET_ARRAY_SIZE;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 uint32_t HASH_TABLE_BUCKET_TYPE::NumReadable() {
+  // bits past BUCKET_ARRAY_SIZE are never set
   uint32_t num = 0;
-  size_t times = BUCKET_ARRAY_SIZE / 8;
-  for (size_t i = 0; i < times; i++) {
-    char c = readable_[i];
-    uint8_t ic = static_cast<uint8_t>(c);
-    for (uint32_t j = 0; j < 8; j++) {
-      if ((ic & 1) > 0) {
-        num++;
-      }
-      ic = ic >> 1;
-    }
-  }
-
-  size_t remain = BUCKET_ARRAY_SIZE % 8;
-  if (remain > 0) {
-    char c = readable_[times];
-    uint8_t ic = static_cast<uint8_t>(c);
-    for (size_t i = 0; i < remain; i++) {
-      if ((ic & 1) == 1) {
-        num++;
-      }
-      ic = ic >> 1;
-    }
+  for (uint32_t start = 0; start < BUCKET_ARRAY_SIZE; start += PROBE_WIDTH) {
+    num += __builtin_popcount(ReadableWord(start));
   }
   return num;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::IsEmpty() {
-  u_int8_t mask = 255;
-  for (size_t i = 0; i < sizeof(readable_) / sizeof(readable_[0]); i++) {
-    char c = readable_[i];
-    if ((c & mask) > 0) {
+  for (uint32_t start = 0; start < BUCKET_ARRAY_SIZE; start += PROBE_WIDTH) {
+    if (ReadableWord(start) != 0) {
       return false;
     }
   }
@@ -232,19 +280,36 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 void HashTableBucketPage<KeyType, ValueType, KeyComparator>::Clear() {
   memset(occupied_, 0, sizeof(occupied_));
   memset(readable_, 0, sizeof(readable_));
-  memset(array_, 0, sizeof(array_));
+  memset(fingerprints_, 0, sizeof(fingerprints_));
+  memset(static_cast<void *>(array_), 0, sizeof(array_));
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BUCKET_TYPE::InsertAt(uint32_t bucket_idx, const KeyType &key, const ValueType &value) {
+  SetOccupied(bucket_idx);
+  SetReadable(bucket_idx);
+  fingerprints_[bucket_idx] = Fingerprint(key);
+  array_[bucket_idx] = MappingType(key, value);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BUCKET_TYPE::MoveAt(uint32_t bucket_idx, HashTableBucketPage *image, uint32_t image_idx) {
+  image->SetOccupied(image_idx);
+  image->SetReadable(image_idx);
+  image->fingerprints_[image_idx] = fingerprints_[bucket_idx];
+  image->array_[image_idx] = array_[bucket_idx];
+  RemoveAt(bucket_idx);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-std::pair<KeyType, ValueType> *HASH_TABLE_BUCKET_TYPE::GetArrayCopy() {
-  uint32_t num = NumReadable();
-  MappingType *copy = new MappingType[num];
-  for (uint32_t i = 0, index = 0; i < BUCKET_ARRAY_SIZE; i++) {
-    if (IsReadable(i)) {
-      copy[index++] = array_[i];
+void HASH_TABLE_BUCKET_TYPE::MergeFrom(HashTableBucketPage *other) {
+  for (uint32_t start = 0; start < BUCKET_ARRAY_SIZE; start += PROBE_WIDTH) {
+    for (uint32_t readable = other->ReadableWord(start); readable != 0; readable &= readable - 1) {
+      uint32_t free_slot = FindFreeSlot();
+      assert(free_slot < BUCKET_ARRAY_SIZE);
+      other->MoveAt(start + __builtin_ctz(readable), this, free_slot);
     }
   }
-  return copy;
 }
 
 // DO NOT REMOVE ANYTHING BELOW THIS LINE
@@ -258,4 +323,11 @@ template class HashTableBucketPage<GenericKey<64>, RID, GenericComparator<64>>;
 
 // template class HashTableBucketPage<hash_t, TmpTuple, HashComparator>;
 
+static_assert(sizeof(HashTableBucketPage<int, int, IntComparator>) <= PAGE_SIZE);
+static_assert(sizeof(HashTableBucketPage<GenericKey<4>, RID, GenericComparator<4>>) <= PAGE_SIZE);
+static_assert(sizeof(HashTableBucketPage<GenericKey<8>, RID, GenericComparator<8>>) <= PAGE_SIZE);
+static_assert(sizeof(HashTableBucketPage<GenericKey<16>, RID, GenericComparator<16>>) <= PAGE_SIZE);
+static_assert(sizeof(HashTableBucketPage<GenericKey<32>, RID, GenericComparator<32>>) <= PAGE_SIZE);
+static_assert(sizeof(HashTableBucketPage<GenericKey<64>, RID, GenericComparator<64>>) <= PAGE_SIZE);
+
 }  // namespace bustub
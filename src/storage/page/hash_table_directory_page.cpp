@@ -46,10 +46,13 @@ void HashTableDirectoryPage::IncrGlobalDepth() {
 
 void HashTableDirectoryPage::DecrGlobalDepth() { global_depth_--; }
 
-page_id_t HashTableDirectoryPage::GetBucketPageId(uint32_t bucket_idx) { return bucket_page_ids_[bucket_idx]; }
+// Slots are read optimistically while a split rebinds them, so they are accessed atomically.
+page_id_t HashTableDirectoryPage::GetBucketPageId(uint32_t bucket_idx) {
+  return __atomic_load_n(&bucket_page_ids_[bucket_idx], __ATOMIC_RELAXED);
+}
 
 void HashTableDirectoryPage::SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id) {
-  bucket_page_ids_[bucket_idx] = bucket_page_id;
+  __atomic_store_n(&bucket_page_ids_[bucket_idx], bucket_page_id, __ATOMIC_RELAXED);
 }
 
 uint32_t HashTableDirectoryPage::Size() { return 1 << global_depth_; }
@@ -66,10 +69,12 @@ bool HashTableDirectoryPage::CanShrink() {
   return true;
 }
 
-uint32_t HashTableDirectoryPage::GetLocalDepth(uint32_t bucket_idx) { return local_depths_[bucket_idx]; }
+uint32_t HashTableDirectoryPage::GetLocalDepth(uint32_t bucket_idx) {
+  return __atomic_load_n(&local_depths_[bucket_idx], __ATOMIC_RELAXED);
+}
 
 void HashTableDirectoryPage::SetLocalDepth(uint32_t bucket_idx, uint8_t local_depth) {
-  local_depths_[bucket_idx] = local_depth;
+  __atomic_store_n(&local_depths_[bucket_idx], local_depth, __ATOMIC_RELAXED);
 }
 
 void HashTableDirectoryPage::IncrLocalDepth(uint32_t bucket_idx) { local_depths_[bucket_idx]++; }
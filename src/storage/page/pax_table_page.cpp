@@ -0,0 +1,440 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_table_page.cpp
+//
+// Identification: src/storage/page/pax_table_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/pax_table_page.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace bustub {
+
+void PaxTablePage::Init(page_id_t page_id, uint32_t page_size, page_id_t prev_page_id, LogManager *log_manager,
+                        Transaction *txn) {
+  // Set the page ID.
+  memcpy(GetData(), &page_id, sizeof(page_id));
+  // Log that we are creating a new page.
+  if (enable_logging) {
+    LogRecord log_record =
+        LogRecord(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::NEWPAGE, prev_page_id, page_id);
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+  // Set the previous and next page IDs.
+  SetPrevPageId(prev_page_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetTupleCount(0);
+  SetVarlenPointer(page_size);
+  // The layout is empty until SetLayout or CopyLayoutFrom is called.
+  memset(GetData() + OFFSET_CAPACITY, 0, SIZE_PAX_PAGE_HEADER - OFFSET_CAPACITY);
+}
+
+void PaxTablePage::SetLayout(const Schema &schema) {
+  uint32_t column_count = schema.GetColumnCount();
+  uint32_t header_end = OFFSET_COLUMN_DESC + SIZE_COLUMN_DESC * column_count;
+  BUSTUB_ASSERT(header_end < PAGE_SIZE, "Too many columns for a PAX page.");
+  memcpy(GetData() + OFFSET_COLUMN_COUNT, &column_count, sizeof(uint32_t));
+  uint32_t tuple_length = schema.GetLength();
+  memcpy(GetData() + OFFSET_TUPLE_LENGTH, &tuple_length, sizeof(uint32_t));
+
+  for (uint32_t i = 0; i < column_count; i++) {
+    const auto &col = schema.GetColumn(i);
+    SetColumnField(i, COLUMN_TUPLE_OFFSET, col.GetOffset());
+    SetColumnField(i, COLUMN_WIDTH, col.IsInlined() ? col.GetFixedLength() : VARLEN_ENTRY_SIZE);
+    SetColumnField(i, COLUMN_IS_VARLEN, col.IsInlined() ? 0 : 1);
+  }
+  LayOutMinipages(DefaultVarlenReserve());
+}
+
+void PaxTablePage::CopyLayoutFrom(PaxTablePage *other, uint32_t varlen_bytes) {
+  uint32_t header_end = other->GetSlotStatusOffset();
+  memcpy(GetData() + OFFSET_TUPLE_LENGTH, other->GetData() + OFFSET_TUPLE_LENGTH, header_end - OFFSET_TUPLE_LENGTH);
+  LayOutMinipages(std::max(DefaultVarlenReserve(), varlen_bytes));
+}
+
+uint32_t PaxTablePage::DefaultVarlenReserve() {
+  uint32_t reserve = 0;
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    reserve += IsColumnVarlen(i) ? VARLEN_RESERVE : 0;
+  }
+  return reserve;
+}
+
+void PaxTablePage::LayOutMinipages(uint32_t varlen_reserve) {
+  uint32_t column_count = GetColumnCount();
+  uint32_t header_end = GetSlotStatusOffset();
+  // One status byte plus one minipage entry per column for every slot, and the varlen heap room.
+  uint32_t row_width = 1 + varlen_reserve;
+  for (uint32_t i = 0; i < column_count; i++) {
+    row_width += GetColumnWidth(i);
+  }
+  // Leave room for aligning every minipage to 8 bytes.
+  uint32_t available = PAGE_SIZE - header_end - sizeof(uint64_t) * (column_count + 1);
+  uint32_t capacity = available / row_width;
+  memcpy(GetData() + OFFSET_CAPACITY, &capacity, sizeof(uint32_t));
+
+  uint32_t offset = header_end + capacity;
+  for (uint32_t i = 0; i < column_count; i++) {
+    offset = (offset + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+    SetColumnField(i, COLUMN_MINIPAGE_OFFSET, offset);
+    offset += GetColumnWidth(i) * capacity;
+  }
+  BUSTUB_ASSERT(offset <= GetVarlenPointer(), "Minipages overlap the varlen heap.");
+}
+
+uint32_t PaxTablePage::GetMinipageEnd() {
+  uint32_t column_count = GetColumnCount();
+  if (column_count == 0) {
+    return GetSlotStatusOffset() + GetCapacity();
+  }
+  return GetColumnField(column_count - 1, COLUMN_MINIPAGE_OFFSET) + GetColumnWidth(column_count - 1) * GetCapacity();
+}
+
+uint32_t PaxTablePage::VarlenBytesOf(const Tuple &tuple) {
+  uint32_t bytes = 0;
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    if (IsColumnVarlen(i)) {
+      uint32_t offset = *reinterpret_cast<uint32_t *>(tuple.data_ + GetColumnField(i, COLUMN_TUPLE_OFFSET));
+      uint32_t length = *reinterpret_cast<uint32_t *>(tuple.data_ + offset);
+      bytes += sizeof(uint32_t) + (length == BUSTUB_VALUE_NULL ? 0 : length);
+    }
+  }
+  return bytes;
+}
+
+uint32_t PaxTablePage::LiveVarlenBytes(uint32_t skip_slot) {
+  uint32_t bytes = 0;
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    if (!IsColumnVarlen(i)) {
+      continue;
+    }
+    for (uint32_t slot = 0; slot < GetTupleCount(); slot++) {
+      if (slot != skip_slot && GetSlotStatus(slot) != SLOT_EMPTY) {
+        bytes += reinterpret_cast<uint32_t *>(GetMinipageEntry(i, slot))[1];
+      }
+    }
+  }
+  return bytes;
+}
+
+void PaxTablePage::CompactVarlenHeap(uint32_t skip_slot) {
+  char *old_page = new char[PAGE_SIZE];
+  memcpy(old_page, GetData(), PAGE_SIZE);
+  uint32_t varlen_pointer = PAGE_SIZE;
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    if (!IsColumnVarlen(i)) {
+      continue;
+    }
+    for (uint32_t slot = 0; slot < GetTupleCount(); slot++) {
+      auto entry = reinterpret_cast<uint32_t *>(GetMinipageEntry(i, slot));
+      if (slot == skip_slot || GetSlotStatus(slot) == SLOT_EMPTY) {
+        entry[0] = entry[1] = 0;
+        continue;
+      }
+      varlen_pointer -= entry[1];
+      memcpy(GetData() + varlen_pointer, old_page + entry[0], entry[1]);
+      entry[0] = varlen_pointer;
+    }
+  }
+  SetVarlenPointer(varlen_pointer);
+  delete[] old_page;
+}
+
+void PaxTablePage::WriteSlot(uint32_t slot_num, const Tuple &tuple) {
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    const char *src = tuple.data_ + GetColumnField(i, COLUMN_TUPLE_OFFSET);
+    if (!IsColumnVarlen(i)) {
+      memcpy(GetMinipageEntry(i, slot_num), src, GetColumnWidth(i));
+      continue;
+    }
+    // Move the (length, bytes) payload into the varlen heap and remember where it went.
+    uint32_t offset = *reinterpret_cast<const uint32_t *>(src);
+    uint32_t length = *reinterpret_cast<uint32_t *>(tuple.data_ + offset);
+    uint32_t payload_size = sizeof(uint32_t) + (length == BUSTUB_VALUE_NULL ? 0 : length);
+    uint32_t varlen_pointer = GetVarlenPointer() - payload_size;
+    memcpy(GetData() + varlen_pointer, tuple.data_ + offset, payload_size);
+    SetVarlenPointer(varlen_pointer);
+    auto entry = reinterpret_cast<uint32_t *>(GetMinipageEntry(i, slot_num));
+    entry[0] = varlen_pointer;
+    entry[1] = payload_size;
+  }
+}
+
+void PaxTablePage::ReadSlot(uint32_t slot_num, Tuple *tuple) {
+  // Lay the tuple out exactly as Tuple(values, schema) does: fixed area first, then varlen payloads in column order.
+  uint32_t tuple_size = GetTupleLength();
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    if (IsColumnVarlen(i)) {
+      tuple_size += reinterpret_cast<uint32_t *>(GetMinipageEntry(i, slot_num))[1];
+    }
+  }
+  if (tuple->allocated_) {
+    delete[] tuple->data_;
+  }
+  tuple->size_ = tuple_size;
+  tuple->data_ = new char[tuple_size];
+  tuple->allocated_ = true;
+  memset(tuple->data_, 0, tuple_size);
+
+  uint32_t varlen_offset = GetTupleLength();
+  for (uint32_t i = 0; i < GetColumnCount(); i++) {
+    char *dst = tuple->data_ + GetColumnField(i, COLUMN_TUPLE_OFFSET);
+    if (!IsColumnVarlen(i)) {
+      memcpy(dst, GetMinipageEntry(i, slot_num), GetColumnWidth(i));
+      continue;
+    }
+    auto entry = reinterpret_cast<uint32_t *>(GetMinipageEntry(i, slot_num));
+    memcpy(dst, &varlen_offset, sizeof(uint32_t));
+    memcpy(tuple->data_ + varlen_offset, GetData() + entry[0], entry[1]);
+    varlen_offset += entry[1];
+  }
+}
+
+bool PaxTablePage::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager,
+                               LogManager *log_manager) {
+  BUSTUB_ASSERT(tuple.size_ > 0, "Cannot have empty tuples.");
+  BUSTUB_ASSERT(GetColumnCount() > 0, "PAX page has no layout.");
+
+  // Try to find a free slot to reuse, otherwise take a new one if the minipages still have room.
+  uint32_t i;
+  for (i = 0; i < GetTupleCount(); i++) {
+    if (GetSlotStatus(i) == SLOT_EMPTY) {
+      break;
+    }
+  }
+  if (i == GetCapacity()) {
+    return false;
+  }
+
+  // Make sure the varlen payloads fit, compacting the heap if that is what it takes.
+  uint32_t varlen_bytes = VarlenBytesOf(tuple);
+  if (GetVarlenPointer() - GetMinipageEnd() < varlen_bytes) {
+    if (PAGE_SIZE - GetMinipageEnd() - LiveVarlenBytes(GetCapacity()) < varlen_bytes) {
+      return false;
+    }
+    CompactVarlenHeap(GetCapacity());
+  }
+
+  WriteSlot(i, tuple);
+  SetSlotStatus(i, SLOT_LIVE);
+  rid->Set(GetTablePageId(), i);
+  if (i == GetTupleCount()) {
+    SetTupleCount(GetTupleCount() + 1);
+  }
+
+  // Write the log record.
+  if (enable_logging) {
+    BUSTUB_ASSERT(!txn->IsSharedLocked(*rid) && !txn->IsExclusiveLocked(*rid), "A new tuple should not be locked.");
+    // Acquire an exclusive lock on the new tuple.
+    bool locked = lock_manager->LockExclusive(txn, *rid);
+    BUSTUB_ASSERT(locked, "Locking a new tuple should always work.");
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::INSERT, *rid, tuple);
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+  return true;
+}
+
+bool PaxTablePage::MarkDelete(const RID &rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager) {
+  uint32_t slot_num = rid.GetSlotNum();
+  // If the slot number is invalid or the tuple is not live, abort the transaction.
+  if (slot_num >= GetTupleCount() || GetSlotStatus(slot_num) != SLOT_LIVE) {
+    if (enable_logging) {
+      txn->SetState(TransactionState::ABORTED);
+    }
+    return false;
+  }
+
+  if (enable_logging) {
+    // Acquire an exclusive lock, upgrading from a shared lock if necessary.
+    if (txn->IsSharedLocked(rid)) {
+      if (!lock_manager->LockUpgrade(txn, rid)) {
+        return false;
+      }
+    } else if (!txn->IsExclusiveLocked(rid) && !lock_manager->LockExclusive(txn, rid)) {
+      return false;
+    }
+    Tuple dummy_tuple;
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::MARKDELETE, rid, dummy_tuple);
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+
+  // Mark the tuple as deleted.
+  SetSlotStatus(slot_num, SLOT_DELETED);
+  return true;
+}
+
+bool PaxTablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID &rid, Transaction *txn,
+                               LockManager *lock_manager, LogManager *log_manager) {
+  BUSTUB_ASSERT(new_tuple.size_ > 0, "Cannot have empty tuples.");
+  uint32_t slot_num = rid.GetSlotNum();
+  // If the slot number is invalid or the tuple is not live, abort the transaction.
+  if (slot_num >= GetTupleCount() || GetSlotStatus(slot_num) != SLOT_LIVE) {
+    if (enable_logging) {
+      txn->SetState(TransactionState::ABORTED);
+    }
+    return false;
+  }
+  // If the new varlen payloads cannot fit even after compaction, the update has to go through delete and insert.
+  uint32_t varlen_bytes = VarlenBytesOf(new_tuple);
+  bool need_compaction = GetVarlenPointer() - GetMinipageEnd() < varlen_bytes;
+  if (need_compaction && PAGE_SIZE - GetMinipageEnd() - LiveVarlenBytes(slot_num) < varlen_bytes) {
+    return false;
+  }
+
+  // Copy out the old value.
+  ReadSlot(slot_num, old_tuple);
+  old_tuple->rid_ = rid;
+
+  if (enable_logging) {
+    // Acquire an exclusive lock, upgrading from shared if necessary.
+    if (txn->IsSharedLocked(rid)) {
+      if (!lock_manager->LockUpgrade(txn, rid)) {
+        return false;
+      }
+    } else if (!txn->IsExclusiveLocked(rid) && !lock_manager->LockExclusive(txn, rid)) {
+      return false;
+    }
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::UPDATE, rid, *old_tuple, new_tuple);
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+
+  // Perform the update. The old varlen payloads become garbage until the next compaction.
+  if (need_compaction) {
+    CompactVarlenHeap(slot_num);
+  }
+  WriteSlot(slot_num, new_tuple);
+  return true;
+}
+
+void PaxTablePage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
+  uint32_t slot_num = rid.GetSlotNum();
+  BUSTUB_ASSERT(slot_num < GetTupleCount(), "Cannot have more slots than tuples.");
+
+  // We need to copy out the deleted tuple for undo purposes.
+  Tuple delete_tuple;
+  ReadSlot(slot_num, &delete_tuple);
+  delete_tuple.rid_ = rid;
+
+  if (enable_logging) {
+    BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own the exclusive lock!");
+
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::APPLYDELETE, rid, delete_tuple);
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+
+  // Free the slot. Its varlen payloads are reclaimed by the next compaction.
+  SetSlotStatus(slot_num, SLOT_EMPTY);
+}
+
+void PaxTablePage::RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
+  // Log the rollback.
+  if (enable_logging) {
+    BUSTUB_ASSERT(txn->IsExclusiveLocked(rid), "We must own an exclusive lock on the RID.");
+    Tuple dummy_tuple;
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ROLLBACKDELETE, rid, dummy_tuple);
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    SetLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
+
+  uint32_t slot_num = rid.GetSlotNum();
+  BUSTUB_ASSERT(slot_num < GetTupleCount(), "We can't have more slots than tuples.");
+  // Unset the deleted flag.
+  if (GetSlotStatus(slot_num) == SLOT_DELETED) {
+    SetSlotStatus(slot_num, SLOT_LIVE);
+  }
+}
+
+bool PaxTablePage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager) {
+  uint32_t slot_num = rid.GetSlotNum();
+  // If the slot is out of range, empty or deleted, abort the transaction.
+  if (slot_num >= GetTupleCount() || GetSlotStatus(slot_num) != SLOT_LIVE) {
+    if (enable_logging) {
+      txn->SetState(TransactionState::ABORTED);
+    }
+    return false;
+  }
+
+  // Otherwise we have a valid tuple, try to acquire at least a shared lock.
+  if (enable_logging) {
+    if (!txn->IsSharedLocked(rid) && !txn->IsExclusiveLocked(rid) && !lock_manager->LockShared(txn, rid)) {
+      return false;
+    }
+  }
+
+  ReadSlot(slot_num, tuple);
+  tuple->rid_ = rid;
+  return true;
+}
+
+bool PaxTablePage::GetFirstTupleRid(RID *first_rid) {
+  // Find and return the first live tuple.
+  for (uint32_t i = 0; i < GetTupleCount(); ++i) {
+    if (GetSlotStatus(i) == SLOT_LIVE) {
+      first_rid->Set(GetTablePageId(), i);
+      return true;
+    }
+  }
+  first_rid->Set(INVALID_PAGE_ID, 0);
+  return false;
+}
+
+bool PaxTablePage::GetNextTupleRid(const RID &cur_rid, RID *next_rid) {
+  BUSTUB_ASSERT(cur_rid.GetPageId() == GetTablePageId(), "Wrong table!");
+  // Find and return the first live tuple after our current slot number.
+  for (auto i = cur_rid.GetSlotNum() + 1; i < GetTupleCount(); ++i) {
+    if (GetSlotStatus(i) == SLOT_LIVE) {
+      next_rid->Set(GetTablePageId(), i);
+      return true;
+    }
+  }
+  // Otherwise return false as there are no more tuples.
+  next_rid->Set(INVALID_PAGE_ID, 0);
+  return false;
+}
+
+uint32_t PaxTablePage::ReadColumn(uint32_t col_idx, char *out, RID *rids) {
+  BUSTUB_ASSERT(!IsColumnVarlen(col_idx), "Only fixed-length columns can be read as an array.");
+  uint32_t width = GetColumnWidth(col_idx);
+  uint32_t count = 0;
+  uint32_t slot = 0;
+  while (slot < GetTupleCount()) {
+    if (GetSlotStatus(slot) != SLOT_LIVE) {
+      slot++;
+      continue;
+    }
+    // Copy each run of live slots with a single memcpy straight out of the minipage.
+    uint32_t run_end = slot + 1;
+    while (run_end < GetTupleCount() && GetSlotStatus(run_end) == SLOT_LIVE) {
+      run_end++;
+    }
+    memcpy(out + count * width, GetMinipageEntry(col_idx, slot), (run_end - slot) * width);
+    if (rids != nullptr) {
+      for (uint32_t i = slot; i < run_end; i++) {
+        rids[count + i - slot].Set(GetTablePageId(), i);
+      }
+    }
+    count += run_end - slot;
+    slot = run_end;
+  }
+  return count;
+}
+
+}  // namespace bustub
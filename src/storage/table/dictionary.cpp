@@ -0,0 +1,81 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// dictionary.cpp
+//
+// Identification: src/storage/table/dictionary.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/dictionary.h"
+
+#include "type/value_factory.h"
+
+namespace bustub {
+
+uint32_t Dictionary::Encode(const Value &value) {
+  if (value.IsNull()) {
+    return NULL_CODE;
+  }
+  std::string str = value.ToString();
+  uint32_t code;
+  latch_.RLock();
+  auto it = codes_.find(str);
+  bool found = it != codes_.end();
+  if (found) {
+    code = it->second;
+  }
+  latch_.RUnlock();
+  if (found) {
+    return code;
+  }
+
+  latch_.WLock();
+  // Another writer may have added the string in between.
+  auto inserted = codes_.emplace(str, static_cast<uint32_t>(strings_.size()));
+  if (inserted.second) {
+    BUSTUB_ASSERT(strings_.size() < NULL_CODE, "Dictionary is full.");
+    strings_.push_back(std::move(str));
+  }
+  code = inserted.first->second;
+  latch_.WUnlock();
+  return code;
+}
+
+bool Dictionary::Lookup(const Value &value, uint32_t *code) const {
+  if (value.IsNull()) {
+    *code = NULL_CODE;
+    return true;
+  }
+  latch_.RLock();
+  auto it = codes_.find(value.ToString());
+  bool found = it != codes_.end();
+  if (found) {
+    *code = it->second;
+  }
+  latch_.RUnlock();
+  return found;
+}
+
+Value Dictionary::Decode(uint32_t code) const {
+  if (code == NULL_CODE) {
+    return ValueFactory::GetNullValueByType(TypeId::VARCHAR);
+  }
+  latch_.RLock();
+  BUSTUB_ASSERT(code < strings_.size(), "Unknown dictionary code.");
+  Value value = ValueFactory::GetVarcharValue(strings_[code]);
+  latch_.RUnlock();
+  return value;
+}
+
+uint32_t Dictionary::Size() const {
+  latch_.RLock();
+  auto size = static_cast<uint32_t>(strings_.size());
+  latch_.RUnlock();
+  return size;
+}
+
+}  // namespace bustub
@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include <cassert>
+#include <utility>
 
 #include "common/logger.h"
 #include "storage/table/table_heap.h"
@@ -18,11 +19,12 @@
 namespace bustub {
 
 TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-                     page_id_t first_page_id)
+                     page_id_t first_page_id, TableFormat format)
     : buffer_pool_manager_(buffer_pool_manager),
       lock_manager_(lock_manager),
       log_manager_(log_manager),
-      first_page_id_(first_page_id) {}
+      first_page_id_(first_page_id),
+      format_(format) {}
 
 TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
                      Transaction *txn)
@@ -36,13 +38,94 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_m
   buffer_pool_manager_->UnpinPage(first_page_id_, true);
 }
 
+TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
+                     Transaction *txn, const Schema &schema, TableFormat format)
+    : buffer_pool_manager_(buffer_pool_manager),
+      lock_manager_(lock_manager),
+      log_manager_(log_manager),
+      format_(format) {
+  if (format_ != TableFormat::PAX) {
+    auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(&first_page_id_));
+    BUSTUB_ASSERT(first_page != nullptr, "Couldn't create a page for the table heap.");
+    first_page->WLatch();
+    first_page->Init(first_page_id_, PAGE_SIZE, INVALID_LSN, log_manager_, txn);
+    first_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(first_page_id_, true);
+    return;
+  }
+  // Lay out the first page by the schema. Later pages copy the layout from their predecessor.
+  auto first_page = reinterpret_cast<PaxTablePage *>(buffer_pool_manager_->NewPage(&first_page_id_));
+  BUSTUB_ASSERT(first_page != nullptr, "Couldn't create a page for the table heap.");
+  first_page->WLatch();
+  first_page->Init(first_page_id_, PAGE_SIZE, INVALID_LSN, log_manager_, txn);
+  first_page->SetLayout(schema);
+  first_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(first_page_id_, true);
+}
+
+namespace {
+/**
+ * A new page of a PAX table inherits the column layout of the page before it, with room for the varlen values of
+ * the tuple it is made for. Table pages need no layout.
+ */
+void InheritLayout(TablePage *new_page, TablePage *prev_page, const Tuple &tuple) {}
+void InheritLayout(PaxTablePage *new_page, PaxTablePage *prev_page, const Tuple &tuple) {
+  new_page->CopyLayoutFrom(prev_page, prev_page->VarlenBytesOf(tuple));
+}
+}  // namespace
+
 bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) {
+  if (format_ == TableFormat::PAX) {
+    return InsertTupleImpl<PaxTablePage>(tuple, rid, txn);
+  }
+  return InsertTupleImpl<TablePage>(tuple, rid, txn);
+}
+
+bool TableHeap::MarkDelete(const RID &rid, Transaction *txn) {
+  if (format_ == TableFormat::PAX) {
+    return MarkDeleteImpl<PaxTablePage>(rid, txn);
+  }
+  return MarkDeleteImpl<TablePage>(rid, txn);
+}
+
+bool TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn) {
+  if (format_ == TableFormat::PAX) {
+    return UpdateTupleImpl<PaxTablePage>(tuple, rid, txn);
+  }
+  return UpdateTupleImpl<TablePage>(tuple, rid, txn);
+}
+
+void TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
+  if (format_ == TableFormat::PAX) {
+    ApplyDeleteImpl<PaxTablePage>(rid, txn);
+    return;
+  }
+  ApplyDeleteImpl<TablePage>(rid, txn);
+}
+
+void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
+  if (format_ == TableFormat::PAX) {
+    RollbackDeleteImpl<PaxTablePage>(rid, txn);
+    return;
+  }
+  RollbackDeleteImpl<TablePage>(rid, txn);
+}
+
+bool TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) {
+  if (format_ == TableFormat::PAX) {
+    return GetTupleImpl<PaxTablePage>(rid, tuple, txn);
+  }
+  return GetTupleImpl<TablePage>(rid, tuple, txn);
+}
+
+template <typename PageType>
+bool TableHeap::InsertTupleImpl(const Tuple &tuple, RID *rid, Transaction *txn) {
   if (tuple.size_ + 32 > PAGE_SIZE) {  // larger than one page size
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
 
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+  auto cur_page = static_cast<PageType *>(buffer_pool_manager_->FetchPage(first_page_id_));
   if (cur_page == nullptr) {
     txn->SetState(TransactionState::ABORTED);
     return false;
@@ -61,11 +144,11 @@ bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) {
       cur_page->WUnlatch();
       buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
       // And repeat the process with the next page.
-      cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
+      cur_page = static_cast<PageType *>(buffer_pool_manager_->FetchPage(next_page_id));
       cur_page->WLatch();
     } else {
       // Otherwise we have run out of valid pages. We need to create a new page.
-      auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(&next_page_id));
+      auto new_page = static_cast<PageType *>(buffer_pool_manager_->NewPage(&next_page_id));
       // If we could not create a new page,
       if (new_page == nullptr) {
         // Then life sucks and we abort the transaction.
@@ -74,15 +157,30 @@ bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) {
         txn->SetState(TransactionState::ABORTED);
         return false;
       }
-      // Otherwise we were able to create a new page. We initialize it now.
+      // Otherwise we were able to create a new page. We initialize it now, and link it once the tuple is in.
       new_page->WLatch();
-      cur_page->SetNextPageId(next_page_id);
       new_page->Init(next_page_id, PAGE_SIZE, cur_page->GetTablePageId(), log_manager_, txn);
+      InheritLayout(new_page, cur_page, tuple);
+      if (!new_page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_)) {
+        // The tuple does not even fit into an empty page, give the page back instead of leaving it in the chain.
+        new_page->WUnlatch();
+        buffer_pool_manager_->UnpinPage(next_page_id, false);
+        buffer_pool_manager_->DeletePage(next_page_id);
+        cur_page->WUnlatch();
+        buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
+        txn->SetState(TransactionState::ABORTED);
+        return false;
+      }
+      cur_page->SetNextPageId(next_page_id);
       cur_page->WUnlatch();
       buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
       cur_page = new_page;
+      break;
     }
   }
+  if (zone_map_ != nullptr) {
+    zone_map_->Insert(rid->GetPageId(), tuple);
+  }
   // This line has caused most of us to double-take and "whoa double unlatch".
   // We are not, in fact, double unlatching. See the invariant above.
   cur_page->WUnlatch();
@@ -92,10 +190,11 @@ bool TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) {
   return true;
 }
 
-bool TableHeap::MarkDelete(const RID &rid, Transaction *txn) {
+template <typename PageType>
+bool TableHeap::MarkDeleteImpl(const RID &rid, Transaction *txn) {
   // TODO(Amadou): remove empty page
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  auto page = reinterpret_cast<PageType *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   // If the page could not be found, then abort the transaction.
   if (page == nullptr) {
     txn->SetState(TransactionState::ABORTED);
@@ -111,9 +210,10 @@ bool TableHeap::MarkDelete(const RID &rid, Transaction *txn) {
   return true;
 }
 
-bool TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn) {
+template <typename PageType>
+bool TableHeap::UpdateTupleImpl(const Tuple &tuple, const RID &rid, Transaction *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  auto page = reinterpret_cast<PageType *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   // If the page could not be found, then abort the transaction.
   if (page == nullptr) {
     txn->SetState(TransactionState::ABORTED);
@@ -123,6 +223,9 @@ bool TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn
   Tuple old_tuple;
   page->WLatch();
   bool is_updated = page->UpdateTuple(tuple, &old_tuple, rid, txn, lock_manager_, log_manager_);
+  if (is_updated && zone_map_ != nullptr) {
+    zone_map_->Update(rid.GetPageId(), old_tuple, tuple);
+  }
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), is_updated);
   // Update the transaction's write set.
@@ -133,9 +236,10 @@ bool TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn
   return is_updated;
 }
 
-void TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
+template <typename PageType>
+void TableHeap::ApplyDeleteImpl(const RID &rid, Transaction *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  auto page = reinterpret_cast<PageType *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
   // Delete the tuple from the page.
   page->WLatch();
@@ -145,9 +249,10 @@ void TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
 }
 
-void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
+template <typename PageType>
+void TableHeap::RollbackDeleteImpl(const RID &rid, Transaction *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  auto page = reinterpret_cast<PageType *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
   // Rollback the delete.
   page->WLatch();
@@ -157,9 +262,10 @@ void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
 }
 
 //! use rid(saved by index) to get the tuple
-bool TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) {
+template <typename PageType>
+bool TableHeap::GetTupleImpl(const RID &rid, Tuple *tuple, Transaction *txn) {
   // Find the page which contains the tuple.
-  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  auto page = static_cast<PageType *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   // If the page could not be found, then abort the transaction.
   if (page == nullptr) {
     txn->SetState(TransactionState::ABORTED);
@@ -173,13 +279,12 @@ bool TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) {
   return res;
 }
 
-TableIterator TableHeap::Begin(Transaction *txn) {
-  // Start an iterator from the first page.
+template <typename PageType>
+RID TableHeap::GetFirstTupleRidImpl(page_id_t page_id) {
   // TODO(Wuwen): Hacky fix for now. Removing empty pages is a better way to handle this.
   RID rid;
-  auto page_id = first_page_id_;
   while (page_id != INVALID_PAGE_ID) {
-    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    auto page = static_cast<PageType *>(buffer_pool_manager_->FetchPage(page_id));
     page->RLatch();
     // If this fails because there is no tuple, then RID will be the default-constructed value, which means EOF.
     auto found_tuple = page->GetFirstTupleRid(&rid);
@@ -190,9 +295,57 @@ TableIterator TableHeap::Begin(Transaction *txn) {
     }
     page_id = page->GetNextPageId();
   }
+  return rid;
+}
+
+TableIterator TableHeap::Begin(Transaction *txn) {
+  // Start an iterator from the first page.
+  RID rid = format_ == TableFormat::PAX ? GetFirstTupleRidImpl<PaxTablePage>(first_page_id_)
+                                        : GetFirstTupleRidImpl<TablePage>(first_page_id_);
   return TableIterator(this, rid, txn);
 }
 
+TableIterator TableHeap::SkipPage(page_id_t page_id, Transaction *txn) {
+  // Both page formats keep the next page id at the same offset.
+  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  BUSTUB_ASSERT(page != nullptr, "Couldn't fetch the table page.");
+  page->RLatch();
+  page_id_t next_page_id = page->GetNextPageId();
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  RID rid = format_ == TableFormat::PAX ? GetFirstTupleRidImpl<PaxTablePage>(next_page_id)
+                                        : GetFirstTupleRidImpl<TablePage>(next_page_id);
+  return TableIterator(this, rid, txn);
+}
+
+void TableHeap::EnableZoneMap(const Schema &schema, std::vector<uint32_t> col_idxs) {
+  zone_map_ = std::make_unique<ZoneMap>(schema, std::move(col_idxs));
+}
+
 TableIterator TableHeap::End() { return TableIterator(this, RID(INVALID_PAGE_ID, 0), nullptr); }
 
+page_id_t TableHeap::ScanColumns(page_id_t page_id, const std::vector<uint32_t> &col_idxs, ColumnBatch *batch) {
+  BUSTUB_ASSERT(format_ == TableFormat::PAX, "Only PAX tables can be scanned by column.");
+  BUSTUB_ASSERT(!col_idxs.empty(), "Scan at least one column.");
+  auto page = static_cast<PaxTablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  BUSTUB_ASSERT(page != nullptr, "Couldn't fetch the table page.");
+  page->RLatch();
+  uint32_t max_count = page->GetTupleCount();
+  batch->rids_.resize(max_count);
+  batch->columns_.resize(col_idxs.size());
+  uint32_t count = 0;
+  for (size_t i = 0; i < col_idxs.size(); i++) {
+    auto &column = batch->columns_[i];
+    column.resize(static_cast<size_t>(max_count) * page->GetColumnWidth(col_idxs[i]));
+    // Every column sees the same live slots, so the RIDs only need to be collected once.
+    count = page->ReadColumn(col_idxs[i], column.data(), i == 0 ? batch->rids_.data() : nullptr);
+    column.resize(static_cast<size_t>(count) * page->GetColumnWidth(col_idxs[i]));
+  }
+  batch->rids_.resize(count);
+  page_id_t next_page_id = page->GetNextPageId();
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  return next_page_id;
+}
+
 }  // namespace bustub
@@ -16,14 +16,97 @@
 #include <string>
 #include <vector>
 
+#include "common/exception.h"
+#include "storage/table/dictionary.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
+namespace {
+// Serialize a fixed-length value without going through its Type.
+inline void SerializeInlined(const Value &value, char *storage) {
+  switch (value.GetTypeId()) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      *reinterpret_cast<int8_t *>(storage) = value.GetAs<int8_t>();
+      break;
+    case TypeId::SMALLINT:
+      *reinterpret_cast<int16_t *>(storage) = value.GetAs<int16_t>();
+      break;
+    case TypeId::INTEGER:
+      *reinterpret_cast<int32_t *>(storage) = value.GetAs<int32_t>();
+      break;
+    case TypeId::BIGINT:
+    case TypeId::DECIMAL:
+    case TypeId::TIMESTAMP:
+      *reinterpret_cast<int64_t *>(storage) = value.GetAs<int64_t>();
+      break;
+    default:
+      value.SerializeTo(storage);
+  }
+}
+
+// Deserialize a fixed-length value without going through its Type.
+inline Value DeserializeInlined(const char *storage, TypeId type) {
+  switch (type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return Value(type, *reinterpret_cast<const int8_t *>(storage));
+    case TypeId::SMALLINT:
+      return Value(type, *reinterpret_cast<const int16_t *>(storage));
+    case TypeId::INTEGER:
+      return Value(type, *reinterpret_cast<const int32_t *>(storage));
+    case TypeId::BIGINT:
+      return Value(type, *reinterpret_cast<const int64_t *>(storage));
+    case TypeId::DECIMAL:
+      return Value(type, *reinterpret_cast<const double *>(storage));
+    case TypeId::TIMESTAMP:
+      return Value(type, *reinterpret_cast<const uint64_t *>(storage));
+    default:
+      return Value::DeserializeFrom(storage, type);
+  }
+}
+
+// Store the dictionary code of a value. An INTEGER value is taken to be a code of the column's dictionary already,
+// which is how executors move dictionary encoded columns between tuples without decoding them, so it must be a code
+// the dictionary has handed out.
+inline void SerializeDictionaryCode(const Value &value, const Column &col, char *storage) {
+  Dictionary *dictionary = col.GetDictionary();
+  uint32_t code;
+  if (value.GetTypeId() == TypeId::VARCHAR) {
+    code = dictionary->Encode(value);
+  } else if (value.IsNull()) {
+    code = Dictionary::NULL_CODE;
+  } else {
+    code = static_cast<uint32_t>(value.GetAs<int32_t>());
+    if (code >= dictionary->Size()) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "dictionary code out of range");
+    }
+  }
+  memcpy(storage, &code, sizeof(uint32_t));
+}
+}  // namespace
+
 // TODO(Amadou): It does not look like nulls are supported. Add a null bitmap?
 Tuple::Tuple(std::vector<Value> values, const Schema *schema) : allocated_(true) {
   assert(values.size() == schema->GetColumnCount());
 
+  // Fast path: a fixed-width tuple is just the columns at their precomputed offsets.
+  if (schema->IsInlined()) {
+    size_ = schema->GetLength();
+    data_ = new char[size_];
+    std::memset(data_, 0, size_);
+    for (uint32_t i = 0; i < values.size(); i++) {
+      // The only VARCHAR columns of a fixed-width schema are the dictionary encoded ones.
+      if (schema->GetColumnType(i) == TypeId::VARCHAR) {
+        SerializeDictionaryCode(values[i], schema->GetColumn(i), data_ + schema->GetColumnOffset(i));
+      } else {
+        SerializeInlined(values[i], data_ + schema->GetColumnOffset(i));
+      }
+    }
+    return;
+  }
+
   // 1. Calculate the size of the tuple.
   uint32_t tuple_size = schema->GetLength();
   for (auto &i : schema->GetUnlinedColumns()) {
@@ -47,6 +130,8 @@ Tuple::Tuple(std::vector<Value> values, const Schema *schema) : allocated_(true)
       // Serialize varchar value, in place (size+data).
       values[i].SerializeTo(data_ + offset);
       offset += (values[i].GetLength() + sizeof(uint32_t));
+    } else if (col.IsDictionaryEncoded()) {
+      SerializeDictionaryCode(values[i], col, data_ + col.GetOffset());
     } else {
       values[i].SerializeTo(data_ + col.GetOffset());
     }
@@ -90,13 +175,40 @@ Tuple &Tuple::operator=(const Tuple &other) {
 Value Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const {
   assert(schema);
   assert(data_);
-  const TypeId column_type = schema->GetColumn(column_idx).GetType();
+  if (schema->IsInlined() && schema->GetColumnType(column_idx) != TypeId::VARCHAR) {
+    return DeserializeInlined(data_ + schema->GetColumnOffset(column_idx), schema->GetColumnType(column_idx));
+  }
+  const auto &col = schema->GetColumn(column_idx);
+  if (col.IsDictionaryEncoded()) {
+    return col.GetDictionary()->Decode(GetDictionaryCode(schema, column_idx));
+  }
+  const TypeId column_type = col.GetType();
   const char *data_ptr = GetDataPtr(schema, column_idx);
   // the third parameter "is_inlined" is unused
   return Value::DeserializeFrom(data_ptr, column_type);
 }
 
 Tuple Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) {
+  // Fast path: copy the key columns byte for byte when both layouts are fixed-width.
+  if (schema.IsInlined() && key_schema.IsInlined()) {
+    bool same_types = true;
+    for (uint32_t i = 0; i < key_attrs.size(); i++) {
+      same_types = same_types && schema.GetColumnType(key_attrs[i]) == key_schema.GetColumnType(i) &&
+                   schema.GetColumn(key_attrs[i]).GetDictionary() == key_schema.GetColumn(i).GetDictionary();
+    }
+    if (same_types) {
+      Tuple key;
+      key.allocated_ = true;
+      key.size_ = key_schema.GetLength();
+      key.data_ = new char[key.size_];
+      std::memset(key.data_, 0, key.size_);
+      for (uint32_t i = 0; i < key_attrs.size(); i++) {
+        memcpy(key.data_ + key_schema.GetColumnOffset(i), data_ + schema.GetColumnOffset(key_attrs[i]),
+               key_schema.GetColumn(i).GetFixedLength());
+      }
+      return key;
+    }
+  }
   std::vector<Value> values;
   values.reserve(key_attrs.size());
   for (auto idx : key_attrs) {
@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map.cpp
+//
+// Identification: src/storage/table/zone_map.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/zone_map.h"
+
+#include <utility>
+
+namespace bustub {
+
+ZoneMap::ZoneMap(const Schema &schema, std::vector<uint32_t> col_idxs)
+    : schema_(schema), col_idxs_(std::move(col_idxs)) {}
+
+size_t ZoneMap::SummaryIndex(uint32_t col_idx) const {
+  size_t i = 0;
+  while (i < col_idxs_.size() && col_idxs_[i] != col_idx) {
+    i++;
+  }
+  return i;
+}
+
+bool ZoneMap::IsTracked(uint32_t col_idx) const { return SummaryIndex(col_idx) != col_idxs_.size(); }
+
+void ZoneMap::Widen(std::vector<ColumnSummary> *summaries, const Tuple &tuple) {
+  for (size_t i = 0; i < col_idxs_.size(); i++) {
+    Value value = tuple.GetValue(&schema_, col_idxs_[i]);
+    auto &summary = (*summaries)[i];
+    if (value.IsNull()) {
+      summary.null_count_++;
+      continue;
+    }
+    if (!summary.has_value_ || value.CompareLessThan(summary.min_) == CmpBool::CmpTrue) {
+      summary.min_ = value;
+    }
+    if (!summary.has_value_ || value.CompareGreaterThan(summary.max_) == CmpBool::CmpTrue) {
+      summary.max_ = value;
+    }
+    summary.has_value_ = true;
+  }
+}
+
+void ZoneMap::Insert(page_id_t page_id, const Tuple &tuple) {
+  std::scoped_lock lock(latch_);
+  auto &summaries = pages_[page_id];
+  summaries.resize(col_idxs_.size());
+  Widen(&summaries, tuple);
+}
+
+void ZoneMap::Update(page_id_t page_id, const Tuple &old_tuple, const Tuple &new_tuple) {
+  std::scoped_lock lock(latch_);
+  auto &summaries = pages_[page_id];
+  summaries.resize(col_idxs_.size());
+  // The old value no longer counts as a null, its min/max contribution is simply kept.
+  for (size_t i = 0; i < col_idxs_.size(); i++) {
+    if (summaries[i].null_count_ > 0 && old_tuple.IsNull(&schema_, col_idxs_[i])) {
+      summaries[i].null_count_--;
+    }
+  }
+  Widen(&summaries, new_tuple);
+}
+
+bool ZoneMap::MayMatch(page_id_t page_id, uint32_t col_idx, ComparisonType comp_type, const Value &constant) const {
+  size_t idx = SummaryIndex(col_idx);
+  if (idx == col_idxs_.size() || constant.IsNull()) {
+    return true;
+  }
+  std::scoped_lock lock(latch_);
+  auto it = pages_.find(page_id);
+  if (it == pages_.end()) {
+    return true;
+  }
+  const auto &summary = it->second[idx];
+  // A comparison with NULL does not evaluate to false in the executors, so pages with nulls are always read.
+  if (summary.null_count_ > 0) {
+    return true;
+  }
+  if (!summary.has_value_) {
+    return false;
+  }
+  const Value &min = summary.min_;
+  const Value &max = summary.max_;
+  switch (comp_type) {
+    case ComparisonType::Equal:
+      return min.CompareLessThanEquals(constant) == CmpBool::CmpTrue &&
+             max.CompareGreaterThanEquals(constant) == CmpBool::CmpTrue;
+    case ComparisonType::NotEqual:
+      return min.CompareNotEquals(constant) == CmpBool::CmpTrue || max.CompareNotEquals(constant) == CmpBool::CmpTrue;
+    case ComparisonType::LessThan:
+      return min.CompareLessThan(constant) == CmpBool::CmpTrue;
+    case ComparisonType::LessThanOrEqual:
+      return min.CompareLessThanEquals(constant) == CmpBool::CmpTrue;
+    case ComparisonType::GreaterThan:
+      return max.CompareGreaterThan(constant) == CmpBool::CmpTrue;
+    case ComparisonType::GreaterThanOrEqual:
+      return max.CompareGreaterThanEquals(constant) == CmpBool::CmpTrue;
+    default:
+      return true;
+  }
+}
+
+bool ZoneMap::GetSummary(page_id_t page_id, uint32_t col_idx, Value *min, Value *max, uint32_t *null_count) const {
+  size_t idx = SummaryIndex(col_idx);
+  std::scoped_lock lock(latch_);
+  auto it = pages_.find(page_id);
+  if (idx == col_idxs_.size() || it == pages_.end()) {
+    return false;
+  }
+  const auto &summary = it->second[idx];
+  *min = summary.min_;
+  *max = summary.max_;
+  *null_count = summary.null_count_;
+  return true;
+}
+
+}  // namespace bustub
@@ -14,6 +14,7 @@
 #include <cstdio>
 #include <random>
 #include <string>
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 
@@ -141,4 +142,52 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PrefetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // write twice as many pages as fit into the pool, so the first ones are evicted to disk
+  std::vector<page_id_t> page_ids(2 * buffer_pool_size);
+  for (auto &page_id : page_ids) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: prefetched pages are read back intact, whether or not the prefetch thread got to them first.
+  for (auto page_id : page_ids) {
+    bpm->PrefetchPage(page_id);
+  }
+  for (auto page_id : page_ids) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: prefetched pages are not pinned, every frame can still be taken and a prefetched page deleted.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    bpm->PrefetchPage(page_ids[i]);
+  }
+  EXPECT_TRUE(bpm->DeletePage(page_ids[0]));
+  std::vector<page_id_t> new_page_ids(buffer_pool_size);
+  for (auto &page_id : new_page_ids) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  for (auto page_id : new_page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
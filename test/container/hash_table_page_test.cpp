@@ -15,8 +15,10 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "common/logger.h"
+#include "container/hash/hash_table_directory.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/index/generic_key.h"
 #include "storage/page/hash_table_bucket_page.h"
 #include "storage/page/hash_table_directory_page.h"
 
@@ -56,6 +58,118 @@ TEST(HashTablePageTest, DirectoryPageSampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, DirectoryTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  // far fewer frames than the directory has pages, only the root stays pinned
+  const size_t pool_size = 8;
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+  {
+    HashTableDirectory directory(bpm);
+    directory.Create(0, 12);
+    EXPECT_EQ(12, directory.GetGlobalDepth());
+    // slot i points at bucket i % 16 with local depth 4
+    for (uint32_t i = 0; i < 16; i++) {
+      directory.Bind(i, 16, i, 4);
+    }
+    for (uint32_t i = 0; i < 2; i++) {
+      ASSERT_TRUE(directory.IncrGlobalDepth());
+    }
+    directory.VerifyIntegrity();
+    for (uint32_t hash = 0; hash < directory.Size(); hash += 97) {
+      uint32_t bucket_idx;
+      EXPECT_EQ(hash % 16, directory.GetBucketPageIdOfHash(hash, &bucket_idx));
+      EXPECT_EQ(hash, bucket_idx);
+    }
+    std::vector<uint32_t> hashes{0, 1, 2, 513, 514, 9000, 16383};
+    std::vector<page_id_t> page_ids;
+    directory.GetBucketPageIds(hashes, &page_ids);
+    for (size_t i = 0; i < hashes.size(); i++) {
+      EXPECT_EQ(hashes[i] % 16, page_ids[i]);
+    }
+
+    // readers see either binding of a slot while a writer flips it, never a torn one
+    std::thread writer([&directory]() {
+      for (int round = 0; round < 200; round++) {
+        directory.Bind(5, 16, round % 2 == 0 ? 100 : 5, 4);
+      }
+    });
+    for (int round = 0; round < 2000; round++) {
+      uint32_t bucket_idx;
+      page_id_t page_id = directory.GetBucketPageIdOfHash(5 + 16 * (round % 1024), &bucket_idx);
+      EXPECT_TRUE(page_id == 5 || page_id == 100);
+    }
+    writer.join();
+    directory.Bind(5, 16, 5, 4);
+
+    // shrinking deletes the directory pages that fall out of use
+    EXPECT_TRUE(directory.CanShrink());
+    while (directory.GetGlobalDepth() > 4) {
+      directory.DecrGlobalDepth();
+    }
+    EXPECT_FALSE(directory.CanShrink());
+    directory.VerifyIntegrity();
+
+    // every frame but the root's is free again
+    std::vector<page_id_t> new_page_ids(pool_size - 1);
+    for (auto &page_id : new_page_ids) {
+      EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+    }
+    for (auto page_id : new_page_ids) {
+      bpm->UnpinPage(page_id, false);
+    }
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, DeepDirectoryTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(8, disk_manager);
+  {
+    // past DIRECTORY_INDEX_ARRAY_SIZE directory pages the root lists several directory index pages
+    HashTableDirectory directory(bpm);
+    directory.Create(0, 18);
+    for (uint32_t i = 0; i < 16; i++) {
+      directory.Bind(i, 16, i, 4);
+    }
+    while (directory.IncrGlobalDepth()) {
+    }
+    EXPECT_EQ(DIRECTORY_MAX_DEPTH, directory.GetGlobalDepth());
+    EXPECT_GE(directory.GetGlobalDepth(), 20);
+    for (uint32_t hash = 0; hash < directory.Size(); hash += 4099) {
+      uint32_t bucket_idx;
+      EXPECT_EQ(hash % 16, directory.GetBucketPageIdOfHash(hash, &bucket_idx));
+    }
+
+    // split the bucket of slot 3 at the deepest level
+    directory.Bind(3, 1U << DIRECTORY_MAX_DEPTH, 3, DIRECTORY_MAX_DEPTH);
+    directory.Bind(3 | (1U << (DIRECTORY_MAX_DEPTH - 1)), 1U << DIRECTORY_MAX_DEPTH, 100, DIRECTORY_MAX_DEPTH);
+    uint32_t bucket_idx;
+    EXPECT_EQ(100, directory.GetBucketPageIdOfHash(3 | (1U << (DIRECTORY_MAX_DEPTH - 1)), &bucket_idx));
+    EXPECT_EQ(3, directory.GetBucketPageIdOfHash(3 | (1U << (DIRECTORY_MAX_DEPTH - 2)), &bucket_idx));
+    EXPECT_FALSE(directory.CanShrink());
+
+    // merge it back and shrink to one directory index page
+    directory.Bind(3, 16, 3, 4);
+    while (directory.GetGlobalDepth() > 16) {
+      ASSERT_TRUE(directory.CanShrink());
+      directory.DecrGlobalDepth();
+    }
+    directory.VerifyIntegrity();
+    EXPECT_EQ(7, directory.GetBucketPageIdOfHash(7 + 16 * 1000, &bucket_idx));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 // NOLINTNEXTLINE
 TEST(HashTablePageTest, BucketPageSampleTest) {
   DiskManager *disk_manager = new DiskManager("test.db");
@@ -114,4 +228,78 @@ TEST(HashTablePageTest, BucketPageSampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, BucketPageFingerprintTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
+
+  using BucketPage = HashTableBucketPage<GenericKey<8>, RID, GenericComparator<8>>;
+  page_id_t bucket_page_id = INVALID_PAGE_ID;
+  auto bucket_page = reinterpret_cast<BucketPage *>(bpm->NewPage(&bucket_page_id, nullptr)->GetData());
+  Schema key_schema{std::vector<Column>{Column{"a", TypeId::BIGINT}}};
+  GenericComparator<8> cmp(&key_schema);
+  const uint32_t capacity = 4 * (PAGE_SIZE - 16) / (4 * sizeof(std::pair<GenericKey<8>, RID>) + 5);
+
+  // fill the bucket, every key has two values
+  GenericKey<8> key;
+  for (uint32_t i = 0; i < capacity; i++) {
+    key.SetFromInteger(i / 2);
+    EXPECT_TRUE(bucket_page->Insert(key, RID(i / 2, i % 2), cmp));
+  }
+  EXPECT_TRUE(bucket_page->IsFull());
+  EXPECT_EQ(capacity, bucket_page->NumReadable());
+  key.SetFromInteger(capacity);
+  EXPECT_FALSE(bucket_page->Insert(key, RID(0, 0), cmp));
+
+  // every key finds exactly its own values, whatever fingerprints collide
+  for (uint32_t i = 0; i < capacity / 2; i++) {
+    key.SetFromInteger(i);
+    std::vector<RID> result;
+    EXPECT_TRUE(bucket_page->GetValue(key, cmp, &result));
+    ASSERT_EQ(2, result.size());
+    EXPECT_EQ(RID(i, 0), result[0]);
+    EXPECT_EQ(RID(i, 1), result[1]);
+    // a duplicate pair is rejected
+    EXPECT_FALSE(bucket_page->Insert(key, RID(i, 0), cmp));
+  }
+
+  // removing makes room again, and the freed slot is the one that is reused
+  key.SetFromInteger(7);
+  EXPECT_TRUE(bucket_page->Remove(key, RID(7, 1), cmp));
+  EXPECT_FALSE(bucket_page->Remove(key, RID(7, 1), cmp));
+  EXPECT_FALSE(bucket_page->IsFull());
+  EXPECT_FALSE(bucket_page->IsReadable(15));
+  key.SetFromInteger(capacity);
+  EXPECT_TRUE(bucket_page->Insert(key, RID(0, 0), cmp));
+  EXPECT_TRUE(bucket_page->IsReadable(15));
+  EXPECT_TRUE(bucket_page->IsFull());
+
+  // moving pairs to another bucket keeps them findable there and frees their slots here
+  page_id_t image_page_id = INVALID_PAGE_ID;
+  auto image_page = reinterpret_cast<BucketPage *>(bpm->NewPage(&image_page_id, nullptr)->GetData());
+  for (uint32_t i = 0; i < 7; i++) {
+    bucket_page->MoveAt(2 * i, image_page, i);
+  }
+  EXPECT_EQ(7, image_page->NumReadable());
+  EXPECT_EQ(capacity - 7, bucket_page->NumReadable());
+  for (uint32_t i = 0; i < 7; i++) {
+    key.SetFromInteger(i);
+    std::vector<RID> result;
+    EXPECT_TRUE(image_page->GetValue(key, cmp, &result));
+    EXPECT_TRUE(bucket_page->GetValue(key, cmp, &result));
+    EXPECT_EQ(2, result.size());
+  }
+  bpm->UnpinPage(image_page_id, true, nullptr);
+
+  bucket_page->Clear();
+  EXPECT_TRUE(bucket_page->IsEmpty());
+  EXPECT_EQ(0, bucket_page->NumReadable());
+
+  bpm->UnpinPage(bucket_page_id, true, nullptr);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
@@ -10,6 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>  // NOLINT
+#include <memory>
+#include <numeric>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -26,8 +29,8 @@ namespace bustub {
 // NOLINTNEXTLINE
 TEST(HashTableTest, SampleTest) {
   auto *disk_manager = new DiskManager("test.db");
-  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
-  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm.get(), IntComparator(), HashFunction<int>());
 
   // insert a few values
   for (int i = 0; i < 5; i++) {
@@ -114,7 +117,386 @@ TEST(HashTableTest, SampleTest) {
   disk_manager->ShutDown();
   remove("test.db");
   delete disk_manager;
-  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, MultiPageDirectoryTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(1000, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm.get(), IntComparator(), HashFunction<int>());
+
+  // enough keys to need more than DIRECTORY_ARRAY_SIZE directory slots
+  const int num_keys = 250000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << "Failed to insert " << i;
+  }
+  EXPECT_GT(ht.GetGlobalDepth(), 9);
+  ht.VerifyIntegrity();
+
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // removing everything merges the buckets back and shrinks the directory to one page again
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  EXPECT_LE(ht.GetGlobalDepth(), 9);
+  ht.VerifyIntegrity();
+  std::vector<int> res;
+  ht.GetValue(nullptr, 0, &res);
+  EXPECT_EQ(0, res.size());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, MergeCompactTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(100, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm.get(), IntComparator(), HashFunction<int>());
+
+  const int num_keys = 50000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  uint32_t full_depth = ht.GetGlobalDepth();
+
+  // deleting 90% of the keys drains most buckets below a quarter, and the merges cascade
+  for (int i = 0; i < num_keys; i++) {
+    if (i % 10 != 0) {
+      ASSERT_TRUE(ht.Remove(nullptr, i, i));
+    }
+  }
+  ht.VerifyIntegrity();
+  EXPECT_LT(ht.GetGlobalDepth(), full_depth);
+
+  // compaction merges the leftovers, after that there is nothing left to merge
+  ht.Compact(nullptr);
+  ht.VerifyIntegrity();
+  uint32_t compact_depth = ht.GetGlobalDepth();
+  EXPECT_LE(compact_depth, full_depth - 2);
+  EXPECT_EQ(0, ht.Compact(nullptr));
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(i % 10 == 0 ? 1 : 0, res.size()) << "Wrong values for " << i;
+  }
+
+  // a compacted table keeps working
+  for (int i = 0; i < num_keys; i++) {
+    if (i % 10 != 0) {
+      ASSERT_TRUE(ht.Insert(nullptr, i, i));
+    }
+  }
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_keys; i++) {
+    if (i % 10 == 0) {
+      ASSERT_TRUE(ht.Remove(nullptr, i, i));
+    }
+  }
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(i % 10 == 0 ? 0 : 1, res.size()) << "Wrong values for " << i;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, GetValuesTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(100, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm.get(), IntComparator(), HashFunction<int>());
+
+  const int num_keys = 20000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  // key 0 has a second value
+  ASSERT_TRUE(ht.Insert(nullptr, 0, -1));
+
+  // every other key is missing, and key 0 is looked up twice
+  std::vector<int> keys{0};
+  for (int i = 0; i < 2 * num_keys; i += 2) {
+    keys.push_back(i);
+  }
+  std::vector<std::vector<int>> results;
+  EXPECT_TRUE(ht.GetValues(nullptr, keys, &results));
+  ASSERT_EQ(keys.size(), results.size());
+  EXPECT_EQ(2, results[0].size());
+  for (size_t i = 1; i < keys.size(); i++) {
+    if (keys[i] == 0) {
+      EXPECT_EQ(2, results[i].size());
+    } else if (keys[i] < num_keys) {
+      ASSERT_EQ(1, results[i].size()) << "Failed to find " << keys[i];
+      EXPECT_EQ(keys[i], results[i][0]);
+    } else {
+      EXPECT_TRUE(results[i].empty());
+    }
+  }
+
+  EXPECT_FALSE(ht.GetValues(nullptr, std::vector<int>{-5, -6}, &results));
+  EXPECT_EQ(2, results.size());
+  EXPECT_FALSE(ht.GetValues(nullptr, std::vector<int>{}, &results));
+  EXPECT_TRUE(results.empty());
+
+  // batches stay complete while another thread splits the buckets they probe
+  std::thread inserter([&] {
+    for (int i = num_keys; i < 3 * num_keys; i++) {
+      ASSERT_TRUE(ht.Insert(nullptr, i, i));
+    }
+  });
+  std::vector<int> batch(num_keys);
+  for (int round = 0; round < 5; round++) {
+    std::iota(batch.begin(), batch.end(), 0);
+    ht.GetValues(nullptr, batch, &results);
+    for (int i = 1; i < num_keys; i++) {
+      ASSERT_EQ(1, results[i].size()) << "Failed to find " << i;
+    }
+  }
+  inserter.join();
+  ht.VerifyIntegrity();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, BulkLoadTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(100, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm.get(), IntComparator(), HashFunction<int>());
+  ExtendibleHashTable<int, int, IntComparator> inserted("blah", bpm.get(), IntComparator(), HashFunction<int>());
+
+  const int num_keys = 50000;
+  std::vector<int> keys(num_keys);
+  std::vector<int> values(num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    keys[i] = i;
+    values[i] = i;
+    ASSERT_TRUE(inserted.Insert(nullptr, i, i));
+  }
+  ASSERT_TRUE(ht.BulkLoad(nullptr, keys, values));
+  ht.VerifyIntegrity();
+  // the runs split exactly where Insert would have split the buckets
+  EXPECT_EQ(inserted.GetGlobalDepth(), ht.GetGlobalDepth());
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Wrong values for " << i;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // a bulk loaded table keeps working
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i + 1));
+    ASSERT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Wrong values for " << i;
+    EXPECT_EQ(i + 1, res[0]);
+  }
+
+  // into a table that is not empty the pairs are inserted one at a time
+  values[0] = 1;
+  EXPECT_FALSE(ht.BulkLoad(nullptr, keys, values));
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(i == 0 ? 1 : 2, res.size()) << "Wrong values for " << i;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, IteratorStatsTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm.get(), IntComparator(), HashFunction<int>());
+
+  {
+    auto iter = ht.Begin();
+    EXPECT_TRUE(iter.IsEnd());
+  }
+
+  // every key has two values
+  const int num_keys = 10000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i));
+    ASSERT_TRUE(ht.Insert(nullptr, i, i + num_keys));
+  }
+
+  std::vector<int> seen(num_keys);
+  int num_pairs = 0;
+  for (auto iter = ht.Begin(); !iter.IsEnd(); ++iter) {
+    auto [key, value] = *iter;
+    ASSERT_TRUE(key >= 0 && key < num_keys);
+    ASSERT_TRUE(value == key || value == key + num_keys);
+    seen[key]++;
+    num_pairs++;
+  }
+  EXPECT_EQ(2 * num_keys, num_pairs);
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_EQ(2, seen[i]) << "Wrong pairs for " << i;
+  }
+
+  ExtendibleHashTableStats stats = ht.GetStats(nullptr);
+  EXPECT_EQ(2 * num_keys, stats.num_entries_);
+  EXPECT_EQ(ht.GetGlobalDepth(), stats.global_depth_);
+  EXPECT_EQ(ExtendibleHashTableStats::NUM_FILL_BINS, stats.fill_histogram_.size());
+  EXPECT_EQ(stats.global_depth_ + 1, stats.local_depth_histogram_.size());
+  EXPECT_EQ(stats.num_buckets_, std::accumulate(stats.fill_histogram_.begin(), stats.fill_histogram_.end(), 0U));
+  EXPECT_EQ(stats.num_buckets_,
+            std::accumulate(stats.local_depth_histogram_.begin(), stats.local_depth_histogram_.end(), 0U));
+  // a directory slot per bucket of the global depth, two per bucket of one less, and so on
+  uint32_t num_slots = 0;
+  for (uint32_t depth = 0; depth <= stats.global_depth_; depth++) {
+    num_slots += stats.local_depth_histogram_[depth] << (stats.global_depth_ - depth);
+  }
+  EXPECT_EQ(1U << stats.global_depth_, num_slots);
+  EXPECT_GT(stats.LoadFactor(), 0.5);
+  EXPECT_LE(stats.LoadFactor(), 1.0);
+  EXPECT_EQ(0, stats.num_overflowing_buckets_);
+
+  // the thread that owns an iterator may change the table, here it removes every pair it visits; a pair that a
+  // merge moves into a bucket the iterator has passed is missed, so the iteration is repeated until the table is empty
+  int num_removed = 0;
+  while (!ht.Begin().IsEnd()) {
+    for (auto iter = ht.Begin(); !iter.IsEnd(); ++iter) {
+      auto [key, value] = *iter;
+      ASSERT_TRUE(ht.Remove(nullptr, key, value)) << "Visited " << key << " twice";
+      num_removed++;
+    }
+  }
+  EXPECT_EQ(2 * num_keys, num_removed);
+  ht.VerifyIntegrity();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+// Runs fn(thread_id) on num_threads threads and returns the wall time in seconds.
+template <typename F>
+double RunThreads(int num_threads, F fn) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back(fn, tid);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentInsertLookupTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(1000, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm.get(), IntComparator(), HashFunction<int>());
+
+  const int num_threads = 4;
+  const int keys_per_thread = 25000;
+  const int num_keys = num_threads * keys_per_thread;
+
+  // every thread inserts a disjoint range of keys, so splits run concurrently with each other
+  RunThreads(num_threads, [&](int tid) {
+    for (int i = tid * keys_per_thread; i < (tid + 1) * keys_per_thread; i++) {
+      ASSERT_TRUE(ht.Insert(nullptr, i, i)) << "Failed to insert " << i;
+    }
+  });
+  ht.VerifyIntegrity();
+
+  // every thread looks up every key
+  RunThreads(num_threads, [&](int tid) {
+    std::vector<int> res;
+    for (int j = 0; j < num_keys; j++) {
+      int i = (j + tid * keys_per_thread) % num_keys;
+      res.clear();
+      ht.GetValue(nullptr, i, &res);
+      ASSERT_EQ(1, res.size()) << "Failed to keep " << i;
+      EXPECT_EQ(i, res[0]);
+    }
+  });
+
+  // half of the threads insert new keys while the other half look up the old ones
+  RunThreads(num_threads, [&](int tid) {
+    if (tid % 2 == 0) {
+      for (int i = num_keys + tid * keys_per_thread; i < num_keys + (tid + 1) * keys_per_thread; i++) {
+        ASSERT_TRUE(ht.Insert(nullptr, i, i)) << "Failed to insert " << i;
+      }
+    } else {
+      std::vector<int> res;
+      for (int i = 0; i < num_keys; i++) {
+        res.clear();
+        ht.GetValue(nullptr, i, &res);
+        ASSERT_EQ(1, res.size()) << "Failed to keep " << i;
+      }
+    }
+  });
+  ht.VerifyIntegrity();
+
+  for (int tid = 0; tid < num_threads; tid += 2) {
+    for (int i = num_keys + tid * keys_per_thread; i < num_keys + (tid + 1) * keys_per_thread; i++) {
+      std::vector<int> res;
+      ht.GetValue(nullptr, i, &res);
+      ASSERT_EQ(1, res.size()) << "Failed to keep " << i;
+    }
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+// Throughput of concurrent inserts and lookups. Disabled by default, run it with --gtest_also_run_disabled_tests
+// --gtest_output=xml, the rates are recorded as properties of the test.
+// NOLINTNEXTLINE
+TEST(HashTableTest, DISABLED_ConcurrentInsertLookupBenchmark) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(1000, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm.get(), IntComparator(), HashFunction<int>());
+
+  const int num_threads = 4;
+  const int keys_per_thread = 250000;
+  const int num_keys = num_threads * keys_per_thread;
+
+  double insert_seconds = RunThreads(num_threads, [&](int tid) {
+    for (int i = tid * keys_per_thread; i < (tid + 1) * keys_per_thread; i++) {
+      ht.Insert(nullptr, i, i);
+    }
+  });
+  double lookup_seconds = RunThreads(num_threads, [&](int tid) {
+    std::vector<int> res;
+    for (int j = 0; j < num_keys; j++) {
+      res.clear();
+      ht.GetValue(nullptr, (j + tid * keys_per_thread) % num_keys, &res);
+    }
+  });
+  RecordProperty("inserts_per_second", static_cast<int>(num_keys / insert_seconds));
+  RecordProperty("lookups_per_second", static_cast<int>(num_threads * num_keys / lookup_seconds));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
 }
 
 }  // namespace bustub
@@ -0,0 +1,182 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// linear_probe_hash_table_test.cpp
+//
+// Identification: test/container/linear_probe_hash_table_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "container/hash/linear_probe_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, SampleTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 1000, HashFunction<int>());
+
+  // insert a few values
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to insert " << i << std::endl;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // insert one more value for each key
+  for (int i = 0; i < 5; i++) {
+    if (i == 0) {
+      // duplicate values for the same key are not allowed
+      EXPECT_FALSE(ht.Insert(nullptr, i, 2 * i));
+    } else {
+      EXPECT_TRUE(ht.Insert(nullptr, i, 2 * i));
+    }
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    if (i == 0) {
+      EXPECT_EQ(1, res.size());
+    } else {
+      ASSERT_EQ(2, res.size());
+      EXPECT_EQ(i, res[0]);
+      EXPECT_EQ(2 * i, res[1]);
+    }
+  }
+
+  // look for a key that does not exist
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 20, &res));
+  EXPECT_EQ(0, res.size());
+
+  // delete some values, the tombstones keep the second values reachable
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    EXPECT_FALSE(ht.Remove(nullptr, i, i));
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    if (i == 0) {
+      EXPECT_EQ(0, res.size());
+    } else {
+      ASSERT_EQ(1, res.size());
+      EXPECT_EQ(2 * i, res[0]);
+    }
+  }
+
+  // a removed pair can be inserted again
+  EXPECT_TRUE(ht.Insert(nullptr, 3, 3));
+  res.clear();
+  ht.GetValue(nullptr, 3, &res);
+  EXPECT_EQ(2, res.size());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, ResizeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 10, HashFunction<int>());
+  size_t initial_size = ht.GetSize();
+
+  const int num_keys = 20000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << "Failed to insert " << i;
+  }
+  EXPECT_GT(ht.GetSize(), initial_size);
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // churn through removes and inserts, the tombstones must not make the table grow without bound
+  size_t size = ht.GetSize();
+  for (int round = 0; round < 10; round++) {
+    for (int i = 0; i < num_keys / 2; i++) {
+      ASSERT_TRUE(ht.Remove(nullptr, i, round == 0 ? i : -round));
+    }
+    for (int i = 0; i < num_keys / 2; i++) {
+      ASSERT_TRUE(ht.Insert(nullptr, i, -round - 1));
+    }
+  }
+  EXPECT_LE(ht.GetSize(), 2 * size);
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i;
+    EXPECT_EQ(i < num_keys / 2 ? -10 : i, res[0]);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, ConcurrentTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(100, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 100, HashFunction<int>());
+
+  // writers insert disjoint ranges, forcing several resizes, while readers keep finding the keys inserted up front
+  const int num_writers = 4;
+  const int num_readers = 2;
+  const int keys_per_thread = 10000;
+  for (int i = 0; i < keys_per_thread; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, -i - 1, i));
+  }
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_writers; tid++) {
+    threads.emplace_back([&, tid] {
+      for (int i = tid * keys_per_thread; i < (tid + 1) * keys_per_thread; i++) {
+        ASSERT_TRUE(ht.Insert(nullptr, i, i));
+        if (i % 3 == 0) {
+          ASSERT_TRUE(ht.Remove(nullptr, i, i));
+        }
+      }
+    });
+  }
+  for (int tid = 0; tid < num_readers; tid++) {
+    threads.emplace_back([&] {
+      for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < keys_per_thread; i++) {
+          std::vector<int> res;
+          ht.GetValue(nullptr, -i - 1, &res);
+          ASSERT_EQ(1, res.size()) << "Failed to find " << -i - 1;
+          EXPECT_EQ(i, res[0]);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (int i = 0; i < num_writers * keys_per_thread; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(i % 3 == 0 ? 0 : 1, res.size()) << "Wrong values for " << i;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+}  // namespace bustub
@@ -31,6 +31,7 @@
 #include "execution/plans/delete_plan.h"
 #include "execution/plans/distinct_plan.h"
 #include "execution/plans/hash_join_plan.h"
+#include "execution/plans/index_scan_plan.h"
 #include "execution/plans/limit_plan.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "execution/plans/update_plan.h"
@@ -110,6 +111,164 @@ TEST_F(ExecutorTest, SimpleSeqScanTest) {
   }
 }
 
+// SELECT col_a, col_b FROM zone_table WHERE 1990 <= col_a, skipping pages through the zone map on col_a
+TEST_F(ExecutorTest, ZoneMapSeqScanTest) {
+  Schema table_schema{std::vector<Column>{Column{"colA", TypeId::INTEGER}, Column{"colB", TypeId::INTEGER}}};
+  TableInfo *table_info = GetExecutorContext()->GetCatalog()->CreateTable(GetTxn(), "zone_table", table_schema,
+                                                                           TableFormat::ROW, {0});
+  const Schema &schema = table_info->schema_;
+  std::vector<RID> rids;
+  for (int32_t i = 0; i < 2000; i++) {
+    Tuple tuple{{ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(i % 10)}, &schema};
+    RID rid;
+    ASSERT_TRUE(table_info->table_->InsertTuple(tuple, &rid, GetTxn()));
+    rids.push_back(rid);
+  }
+
+  // The first page only holds small values of col_a, so it can be skipped
+  const ZoneMap *zone_map = table_info->table_->GetZoneMap();
+  ASSERT_NE(zone_map, nullptr);
+  Value min;
+  Value max;
+  uint32_t null_count;
+  ASSERT_TRUE(zone_map->GetSummary(rids[0].GetPageId(), 0, &min, &max, &null_count));
+  EXPECT_EQ(min.GetAs<int32_t>(), 0);
+  EXPECT_LT(max.GetAs<int32_t>(), 1990);
+  EXPECT_EQ(null_count, 0);
+  EXPECT_FALSE(zone_map->MayMatch(rids[0].GetPageId(), 0, ComparisonType::GreaterThanOrEqual,
+                                  ValueFactory::GetIntegerValue(1990)));
+  EXPECT_TRUE(zone_map->MayMatch(rids.back().GetPageId(), 0, ComparisonType::GreaterThanOrEqual,
+                                 ValueFactory::GetIntegerValue(1990)));
+
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto *const1990 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(1990));
+  auto *predicate = MakeComparisonExpression(const1990, col_a, ComparisonType::LessThanOrEqual);
+  auto *out_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  SeqScanPlanNode plan{out_schema, predicate, table_info->oid_};
+
+  std::vector<Tuple> result_set{};
+  GetExecutionEngine()->Execute(&plan, &result_set, GetTxn(), GetExecutorContext());
+
+  ASSERT_EQ(result_set.size(), 10);
+  for (size_t i = 0; i < result_set.size(); i++) {
+    ASSERT_EQ(result_set[i].GetValue(out_schema, 0).GetAs<int32_t>(), 1990 + static_cast<int32_t>(i));
+  }
+}
+
+// SELECT colA, colB FROM dict_table WHERE colB = 'green', a self join and a group by on the dictionary encoded colB
+TEST_F(ExecutorTest, DictionaryEncodingTest) {
+  Schema table_schema{std::vector<Column>{Column{"colA", TypeId::INTEGER}, Column{"colB", TypeId::VARCHAR, 16}}};
+  TableInfo *table_info = GetExecutorContext()->GetCatalog()->CreateTable(GetTxn(), "dict_table", table_schema,
+                                                                           TableFormat::ROW, {}, {1});
+  const Schema &schema = table_info->schema_;
+  ASSERT_TRUE(schema.GetColumn(1).IsDictionaryEncoded());
+  ASSERT_TRUE(schema.IsInlined());
+  ASSERT_EQ(schema.GetLength(), 8);
+
+  const std::vector<std::string> colors{"red", "green", "blue"};
+  for (int32_t i = 0; i < 300; i++) {
+    Tuple tuple{{ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(colors[i % 3])}, &schema};
+    RID rid;
+    ASSERT_TRUE(table_info->table_->InsertTuple(tuple, &rid, GetTxn()));
+  }
+  Dictionary *dictionary = schema.GetColumn(1).GetDictionary();
+  ASSERT_EQ(dictionary->Size(), 3);
+  Tuple null_tuple{{ValueFactory::GetIntegerValue(0), ValueFactory::GetNullValueByType(TypeId::VARCHAR)}, &schema};
+  ASSERT_TRUE(null_tuple.IsNull(&schema, 1));
+
+  // The output column shares the dictionary, so the scan hands the codes over and the predicate compares codes
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(schema, 0, "colB");
+  Schema scan_schema{std::vector<Column>{Column{"colA", TypeId::INTEGER, col_a}, Column{"colB", dictionary, col_b}}};
+  auto *scan_col_b = MakeColumnValueExpression(scan_schema, 0, "colB");
+  {
+    auto *green = MakeConstantValueExpression(ValueFactory::GetVarcharValue("green"));
+    SeqScanPlanNode plan{&scan_schema, MakeComparisonExpression(scan_col_b, green, ComparisonType::Equal),
+                         table_info->oid_};
+    std::vector<Tuple> result_set{};
+    GetExecutionEngine()->Execute(&plan, &result_set, GetTxn(), GetExecutorContext());
+    ASSERT_EQ(result_set.size(), 100);
+    for (const auto &tuple : result_set) {
+      ASSERT_EQ(tuple.GetValue(&scan_schema, 0).GetAs<int32_t>() % 3, 1);
+      ASSERT_EQ(tuple.GetValue(&scan_schema, 1).ToString(), "green");
+    }
+
+    // A string that is not in the dictionary matches nothing
+    auto *purple = MakeConstantValueExpression(ValueFactory::GetVarcharValue("purple"));
+    SeqScanPlanNode purple_plan{&scan_schema, MakeComparisonExpression(scan_col_b, purple, ComparisonType::Equal),
+                                table_info->oid_};
+    result_set.clear();
+    GetExecutionEngine()->Execute(&purple_plan, &result_set, GetTxn(), GetExecutorContext());
+    ASSERT_EQ(result_set.size(), 0);
+    ASSERT_EQ(dictionary->Size(), 3);
+  }
+
+  // Join the first three rows with the whole table on colB, the hash table is keyed on the codes
+  {
+    auto *three = MakeConstantValueExpression(ValueFactory::GetIntegerValue(3));
+    auto *scan_col_a = MakeColumnValueExpression(scan_schema, 0, "colA");
+    SeqScanPlanNode left_plan{&scan_schema, MakeComparisonExpression(scan_col_a, three, ComparisonType::LessThan),
+                              table_info->oid_};
+    SeqScanPlanNode right_plan{&scan_schema, nullptr, table_info->oid_};
+    auto *left_col_a = MakeColumnValueExpression(scan_schema, 0, "colA");
+    auto *left_col_b = MakeColumnValueExpression(scan_schema, 0, "colB");
+    auto *right_col_a = MakeColumnValueExpression(scan_schema, 1, "colA");
+    auto *right_col_b = MakeColumnValueExpression(scan_schema, 1, "colB");
+    auto *out_schema =
+        MakeOutputSchema({{"left_colA", left_col_a}, {"right_colA", right_col_a}, {"colB", right_col_b}});
+    HashJoinPlanNode join_plan{out_schema, std::vector<const AbstractPlanNode *>{&left_plan, &right_plan}, left_col_b,
+                               right_col_b};
+    std::vector<Tuple> result_set{};
+    GetExecutionEngine()->Execute(&join_plan, &result_set, GetTxn(), GetExecutorContext());
+    ASSERT_EQ(result_set.size(), 300);
+    for (const auto &tuple : result_set) {
+      auto left_a = tuple.GetValue(out_schema, 0).GetAs<int32_t>();
+      auto right_a = tuple.GetValue(out_schema, 1).GetAs<int32_t>();
+      ASSERT_EQ(left_a, right_a % 3);
+      ASSERT_EQ(tuple.GetValue(out_schema, 2).ToString(), colors[left_a]);
+    }
+  }
+
+  // SELECT colB, COUNT(colA) FROM dict_table GROUP BY colB, grouped on the codes and decoded in the output
+  {
+    SeqScanPlanNode scan_plan{&scan_schema, nullptr, table_info->oid_};
+    auto *scan_col_a = MakeColumnValueExpression(scan_schema, 0, "colA");
+    AggregateValueExpression groupby_b{true, 0, TypeId::VARCHAR};
+    const AbstractExpression *count_a = MakeAggregateValueExpression(false, 0);
+    auto *agg_schema = MakeOutputSchema({{"colB", &groupby_b}, {"countA", count_a}});
+    AggregationPlanNode agg_plan{agg_schema,
+                                 &scan_plan,
+                                 nullptr,
+                                 std::vector<const AbstractExpression *>{scan_col_b},
+                                 std::vector<const AbstractExpression *>{scan_col_a},
+                                 std::vector<AggregationType>{AggregationType::CountAggregate}};
+    std::vector<Tuple> result_set{};
+    GetExecutionEngine()->Execute(&agg_plan, &result_set, GetTxn(), GetExecutorContext());
+    ASSERT_EQ(result_set.size(), 3);
+    std::unordered_set<std::string> encountered{};
+    for (const auto &tuple : result_set) {
+      encountered.insert(tuple.GetValue(agg_schema, 0).ToString());
+      ASSERT_EQ(tuple.GetValue(agg_schema, 1).GetAs<int32_t>(), 100);
+    }
+    ASSERT_EQ(encountered, std::unordered_set<std::string>(colors.begin(), colors.end()));
+  }
+
+  // A string added to the dictionary after a plan was built is looked up again when the plan is executed
+  {
+    auto *purple = MakeConstantValueExpression(ValueFactory::GetVarcharValue("purple"));
+    SeqScanPlanNode purple_plan{&scan_schema, MakeComparisonExpression(scan_col_b, purple, ComparisonType::Equal),
+                                table_info->oid_};
+    Tuple purple_tuple{{ValueFactory::GetIntegerValue(300), ValueFactory::GetVarcharValue("purple")}, &schema};
+    RID rid;
+    ASSERT_TRUE(table_info->table_->InsertTuple(purple_tuple, &rid, GetTxn()));
+    std::vector<Tuple> result_set{};
+    GetExecutionEngine()->Execute(&purple_plan, &result_set, GetTxn(), GetExecutorContext());
+    ASSERT_EQ(result_set.size(), 1);
+    ASSERT_EQ(result_set[0].GetValue(&scan_schema, 0).GetAs<int32_t>(), 300);
+  }
+}
+
 // INSERT INTO empty_table2 VALUES (100, 10), (101, 11), (102, 12)
 TEST_F(ExecutorTest, SimpleRawInsertTest) {
   // Create Values to insert
@@ -269,6 +428,82 @@ TEST_F(ExecutorTest, SimpleRawInsertWithIndexTest) {
   }
 }
 
+// SELECT col_a, col_b FROM test_1 WHERE 100 <= col_a AND col_a <= 199, through a bulk loaded B+ tree index
+TEST_F(ExecutorTest, BPlusTreeIndexScanTest) {
+  auto table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto key_schema = ParseCreateStatement("a int");
+  auto *index_info = GetExecutorContext()->GetCatalog()->CreateIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "index1", "test_1", schema, *key_schema, {0}, 8, HashFunctionType{}, IndexType::B_PLUS_TREE);
+
+  auto col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto out_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  Tuple start_key({ValueFactory::GetIntegerValue(100)}, &index_info->key_schema_);
+  Tuple end_key({ValueFactory::GetIntegerValue(199)}, &index_info->key_schema_);
+  IndexScanPlanNode scan_plan{out_schema, nullptr, index_info->index_oid_, &start_key, &end_key};
+
+  std::vector<Tuple> result_set{};
+  GetExecutionEngine()->Execute(&scan_plan, &result_set, GetTxn(), GetExecutorContext());
+
+  // The keys come in order
+  ASSERT_EQ(result_set.size(), 100);
+  for (int32_t i = 0; i < 100; i++) {
+    ASSERT_EQ(result_set[i].GetValue(out_schema, out_schema->GetColIdx("colA")).GetAs<int32_t>(), 100 + i);
+  }
+
+  // The table is intact next to the index pages
+  SeqScanPlanNode seq_scan_plan{out_schema, nullptr, table_info->oid_};
+  result_set.clear();
+  GetExecutionEngine()->Execute(&seq_scan_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(result_set.size(), TEST1_SIZE);
+}
+
+// SELECT colA FROM test_1 WHERE colA BETWEEN 100 AND 199, answered from the index keys alone
+TEST_F(ExecutorTest, IndexOnlyScanTest) {
+  auto table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto key_schema = ParseCreateStatement("a int");
+  auto *index_info = GetExecutorContext()->GetCatalog()->CreateIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "index1", "test_1", schema, *key_schema, {0}, 8, HashFunctionType{}, IndexType::B_PLUS_TREE);
+
+  auto col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto key_out_schema = MakeOutputSchema({{"colA", col_a}});
+  auto full_out_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  Tuple start_key({ValueFactory::GetIntegerValue(100)}, &index_info->key_schema_);
+  Tuple end_key({ValueFactory::GetIntegerValue(199)}, &index_info->key_schema_);
+  IndexScanPlanNode key_scan_plan{key_out_schema, nullptr, index_info->index_oid_, &start_key, &end_key};
+  IndexScanPlanNode full_scan_plan{full_out_schema, nullptr, index_info->index_oid_, &start_key, &end_key};
+
+  // Remove the tuple of key 150 from the table behind the index's back, only a scan that reads the table misses it
+  std::vector<RID> rids;
+  index_info->index_->ScanKey(Tuple({ValueFactory::GetIntegerValue(150)}, &index_info->key_schema_), &rids, GetTxn());
+  ASSERT_EQ(rids.size(), 1);
+  ASSERT_TRUE(table_info->table_->MarkDelete(rids[0], GetTxn()));
+
+  auto *txn = GetTxnManager()->Begin(nullptr, IsolationLevel::READ_UNCOMMITTED);
+  auto exec_ctx = std::make_unique<ExecutorContext>(txn, GetCatalog(), GetBPM(), GetTxnManager(), GetLockManager());
+  std::vector<Tuple> result_set{};
+  GetExecutionEngine()->Execute(&key_scan_plan, &result_set, txn, exec_ctx.get());
+  ASSERT_EQ(result_set.size(), 100);
+  for (int32_t i = 0; i < 100; i++) {
+    ASSERT_EQ(result_set[i].GetValue(key_out_schema, 0).GetAs<int32_t>(), 100 + i);
+  }
+
+  // colB is not in the key, the table is read
+  result_set.clear();
+  GetExecutionEngine()->Execute(&full_scan_plan, &result_set, txn, exec_ctx.get());
+  ASSERT_EQ(result_set.size(), 99);
+  GetTxnManager()->Commit(txn);
+  delete txn;
+
+  // A scan that locks the tuples checks that they are still in the table
+  result_set.clear();
+  GetExecutionEngine()->Execute(&key_scan_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(result_set.size(), 99);
+}
+
 // UPDATE test_3 SET colB = colB + 1;
 TEST_F(ExecutorTest, SimpleUpdateTest) {
   // Construct a sequential scan of the table
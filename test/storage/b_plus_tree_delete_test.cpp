@@ -12,6 +12,10 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
@@ -20,7 +24,7 @@
 
 namespace bustub {
 
-TEST(BPlusTreeTests, DISABLED_DeleteTest1) {
+TEST(BPlusTreeTests, DeleteTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -98,7 +102,7 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
+TEST(BPlusTreeTests, DeleteTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -175,4 +179,190 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
   remove("test.db");
   remove("test.log");
 }
+
+// Values of duplicate keys are removed one at a time, a key goes with its last value.
+TEST(BPlusTreeTests, DuplicateKeyDeleteTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 5, HEADER_PAGE_ID,
+                                                           sizeof(GenericKey<8>), false, true);
+  GenericKey<8> index_key;
+  Transaction *transaction = new Transaction(0);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // key 10 spills over posting pages, key k takes k % 3 + 1 values otherwise
+  const int64_t num_keys = 60;
+  std::vector<size_t> remaining(num_keys);
+  std::vector<std::pair<int64_t, RID>> pairs;
+  for (int64_t key = 0; key < num_keys; key++) {
+    remaining[key] = key == 10 ? 2 * POSTING_PAGE_SIZE + 1 : key % 3 + 1;
+    for (size_t i = 0; i < remaining[key]; i++) {
+      pairs.emplace_back(key, RID(static_cast<page_id_t>(i % 5), static_cast<uint32_t>(i)));
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, pairs.back().second, transaction);
+    }
+  }
+
+  // removing a pair that is not there changes nothing
+  index_key.SetFromInteger(1);
+  tree.Remove(index_key, RID(9, 9), transaction);
+  std::vector<RID> rids;
+  tree.GetValue(index_key, &rids);
+  EXPECT_EQ(rids.size(), remaining[1]);
+
+  // key 20 goes at once with all of its values
+  index_key.SetFromInteger(20);
+  tree.Remove(index_key, transaction);
+  remaining[20] = 0;
+  pairs.erase(std::remove_if(pairs.begin(), pairs.end(), [](const auto &pair) { return pair.first == 20; }),
+              pairs.end());
+
+  std::shuffle(pairs.begin(), pairs.end(), std::mt19937(15445));
+  for (size_t i = 0; i < pairs.size(); i++) {
+    const auto &[key, rid] = pairs[i];
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, rid, transaction);
+    remaining[key]--;
+    rids.clear();
+    EXPECT_EQ(tree.GetValue(index_key, &rids), remaining[key] > 0);
+    ASSERT_EQ(rids.size(), remaining[key]);
+    EXPECT_TRUE(std::find(rids.begin(), rids.end(), rid) == rids.end());
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+// Leaves filled with inline lists merge and redistribute as their values are removed, the lists that do not fit in
+// the leaf they move to spill to posting lists.
+TEST(BPlusTreeTests, InlineListDeleteTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  using LeafPage = BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, LeafPage::Capacity(8), 5,
+                                                           HEADER_PAGE_ID, sizeof(GenericKey<8>), false, true);
+  GenericKey<8> index_key;
+  Transaction *transaction = new Transaction(0);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // key k takes k % INLINE_LIST_MAX_SIZE + 1 values. The first value of every key goes first, the leaves merge while
+  // the other keys still hold inline lists
+  const int64_t num_keys = 800;
+  std::vector<size_t> remaining(num_keys);
+  std::vector<std::pair<int64_t, RID>> pairs;
+  for (int64_t key = 0; key < num_keys; key++) {
+    remaining[key] = key % INLINE_LIST_MAX_SIZE + 1;
+    for (size_t i = 0; i < remaining[key]; i++) {
+      pairs.emplace_back(key, RID(static_cast<page_id_t>(key), static_cast<uint32_t>(i)));
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, pairs.back().second, transaction);
+    }
+  }
+  std::shuffle(pairs.begin(), pairs.end(), std::mt19937(15445));
+  std::stable_partition(pairs.begin(), pairs.end(), [](const auto &pair) { return pair.second.GetSlotNum() == 0; });
+
+  std::vector<RID> rids;
+  for (size_t i = 0; i < pairs.size(); i++) {
+    const auto &[key, rid] = pairs[i];
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, rid, transaction);
+    remaining[key]--;
+    rids.clear();
+    EXPECT_EQ(tree.GetValue(index_key, &rids), remaining[key] > 0);
+    ASSERT_EQ(rids.size(), remaining[key]);
+    if (i % 500 == 0) {
+      size_t count = 0;
+      for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+        count++;
+      }
+      ASSERT_EQ(count, pairs.size() - i - 1);
+    }
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+// Merged and redistributed leaves have fences further apart and a shorter prefix, their pairs take more room. Keys far
+// apart make the prefixes short, so that the merges near them store most pairs again, or do not fit.
+TEST(BPlusTreeTests, PrefixDeleteTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<64> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  using LeafPage = BPlusTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>>;
+  BPlusTree<GenericKey<64>, RID, GenericComparator<64>> tree("foo_pk", bpm, comparator, LeafPage::MaxCapacity(64), 5,
+                                                             HEADER_PAGE_ID, 64);
+  GenericKey<64> index_key;
+  Transaction *transaction = new Transaction(0);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // runs of close keys, with the first byte of the integer apart
+  std::vector<int64_t> keys;
+  for (int64_t run = 0; run < 4; run++) {
+    for (int64_t key = 0; key < 3000; key++) {
+      keys.push_back((run << 56) + key);
+    }
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, RID(static_cast<page_id_t>(key >> 32), static_cast<uint32_t>(key)), transaction);
+  }
+
+  std::set<int64_t> remaining(keys.begin(), keys.end());
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15721));
+  std::vector<RID> rids;
+  for (size_t i = 0; i < keys.size(); i++) {
+    index_key.SetFromInteger(keys[i]);
+    tree.Remove(index_key, transaction);
+    remaining.erase(keys[i]);
+    rids.clear();
+    EXPECT_FALSE(tree.GetValue(index_key, &rids));
+    if (i % 1000 == 0) {
+      auto expected = remaining.begin();
+      for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator, ++expected) {
+        ASSERT_NE(expected, remaining.end());
+        ASSERT_EQ((*iterator).first.ToString(), *expected);
+      }
+      ASSERT_EQ(expected, remaining.end());
+      for (auto key : remaining) {
+        rids.clear();
+        index_key.SetFromInteger(key);
+        ASSERT_TRUE(tree.GetValue(index_key, &rids));
+      }
+    }
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
 }  // namespace bustub
@@ -0,0 +1,65 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// generic_key_test.cpp
+//
+// Identification: test/storage/generic_key_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <string>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// Normalized keys compare byte for byte in the order of their values, column by column.
+TEST(GenericKeyTest, OrderTest) {
+  Schema key_schema({Column("a", TypeId::INTEGER), Column("b", TypeId::VARCHAR, 16), Column("c", TypeId::DECIMAL)});
+  GenericComparator<32> comparator(&key_schema);
+
+  // in ascending order
+  std::vector<std::vector<Value>> rows{
+      {ValueFactory::GetIntegerValue(-70000), ValueFactory::GetVarcharValue("b"), ValueFactory::GetDecimalValue(0)},
+      {ValueFactory::GetIntegerValue(-1), ValueFactory::GetVarcharValue(""), ValueFactory::GetDecimalValue(0)},
+      {ValueFactory::GetIntegerValue(0), ValueFactory::GetVarcharValue("a"), ValueFactory::GetDecimalValue(-2.5)},
+      {ValueFactory::GetIntegerValue(0), ValueFactory::GetVarcharValue("a"), ValueFactory::GetDecimalValue(-0.5)},
+      {ValueFactory::GetIntegerValue(0), ValueFactory::GetVarcharValue("a"), ValueFactory::GetDecimalValue(1.5)},
+      {ValueFactory::GetIntegerValue(0), ValueFactory::GetVarcharValue("ab"), ValueFactory::GetDecimalValue(-9)},
+      {ValueFactory::GetIntegerValue(0), ValueFactory::GetVarcharValue("b"), ValueFactory::GetDecimalValue(-9)},
+      {ValueFactory::GetIntegerValue(3), ValueFactory::GetVarcharValue(""), ValueFactory::GetDecimalValue(0)},
+      {ValueFactory::GetIntegerValue(70000), ValueFactory::GetVarcharValue(""), ValueFactory::GetDecimalValue(0)},
+  };
+  std::vector<GenericKey<32>> keys(rows.size());
+  for (size_t i = 0; i < rows.size(); i++) {
+    keys[i].SetFromKey(Tuple(rows[i], &key_schema), &key_schema);
+  }
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    for (size_t j = 0; j < keys.size(); j++) {
+      int expected = i < j ? -1 : (i > j ? 1 : 0);
+      EXPECT_EQ(comparator(keys[i], keys[j]), expected) << i << " " << j;
+    }
+    // the columns decode back to their values
+    for (uint32_t col = 0; col < key_schema.GetColumnCount(); col++) {
+      EXPECT_EQ(keys[i].ToValue(&key_schema, col).CompareEquals(rows[i][col]), CmpBool::CmpTrue) << i << " " << col;
+    }
+  }
+
+  // the test keys order like their integers
+  GenericKey<8> lhs;
+  GenericKey<8> rhs;
+  lhs.SetFromInteger(-5);
+  rhs.SetFromInteger(3);
+  EXPECT_EQ(GenericComparator<8>(&key_schema)(lhs, rhs), -1);
+  EXPECT_EQ(lhs.ToString(), -5);
+}
+
+}  // namespace bustub
@@ -13,6 +13,7 @@
 #include <algorithm>
 #include <cstdio>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -21,6 +22,7 @@
 #include "logging/common.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/tuple.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 // NOLINTNEXTLINE
@@ -71,4 +73,197 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(TupleTest, PaxTableHeapTest) {
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::INTEGER};
+  Column col3{"c", TypeId::BIGINT};
+  std::vector<Column> cols{col1, col2, col3};
+  Schema schema{cols};
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction, schema, TableFormat::PAX);
+
+  // insert enough tuples to span several pages
+  const int num_tuples = 2000;
+  std::vector<RID> rid_v;
+  for (int i = 0; i < num_tuples; ++i) {
+    std::vector<Value> values{ValueFactory::GetVarcharValue(std::string(i % 20, 'x')),
+                              ValueFactory::GetIntegerValue(i), ValueFactory::GetBigIntValue(2 * i)};
+    Tuple tuple(values, &schema);
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+    rid_v.push_back(rid);
+  }
+  EXPECT_NE(rid_v.front().GetPageId(), rid_v.back().GetPageId());
+
+  // tuples read back through the iterator are byte-identical to the inserted ones
+  int count = 0;
+  for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+    std::vector<Value> values{ValueFactory::GetVarcharValue(std::string(count % 20, 'x')),
+                              ValueFactory::GetIntegerValue(count), ValueFactory::GetBigIntValue(2 * count)};
+    Tuple expected(values, &schema);
+    ASSERT_EQ(itr->GetLength(), expected.GetLength());
+    EXPECT_EQ(0, memcmp(itr->GetData(), expected.GetData(), expected.GetLength()));
+    EXPECT_EQ(itr->GetRid().Get(), rid_v[count].Get());
+    count++;
+  }
+  EXPECT_EQ(count, num_tuples);
+
+  // update in place, growing the varchar, then delete every other tuple
+  std::vector<Value> values{ValueFactory::GetVarcharValue(std::string(20, 'y')), ValueFactory::GetIntegerValue(-1),
+                            ValueFactory::GetBigIntValue(-2)};
+  Tuple updated(values, &schema);
+  EXPECT_TRUE(table->UpdateTuple(updated, rid_v[1], transaction));
+  Tuple result;
+  EXPECT_TRUE(table->GetTuple(rid_v[1], &result, transaction));
+  EXPECT_EQ(result.GetValue(&schema, 0).ToString(), std::string(20, 'y'));
+  EXPECT_EQ(result.GetValue(&schema, 1).GetAs<int32_t>(), -1);
+  for (int i = 0; i < num_tuples; i += 2) {
+    EXPECT_TRUE(table->MarkDelete(rid_v[i], transaction));
+    table->ApplyDelete(rid_v[i], transaction);
+  }
+
+  // scanning only the integer columns sees every remaining tuple
+  ColumnBatch batch;
+  int64_t sum_b = 0;
+  int64_t sum_c = 0;
+  size_t rows = 0;
+  for (page_id_t page_id = table->GetFirstPageId(); page_id != INVALID_PAGE_ID;) {
+    page_id = table->ScanColumns(page_id, {1, 2}, &batch);
+    for (size_t i = 0; i < batch.GetSize(); i++) {
+      sum_b += batch.GetColumn<int32_t>(0)[i];
+      sum_c += batch.GetColumn<int64_t>(1)[i];
+    }
+    rows += batch.GetSize();
+  }
+  int64_t expected_sum = -1;
+  for (int i = 3; i < num_tuples; i += 2) {
+    expected_sum += i;
+  }
+  EXPECT_EQ(rows, num_tuples / 2);
+  EXPECT_EQ(sum_b, expected_sum);
+  EXPECT_EQ(sum_c, 2 * expected_sum);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, PaxWideVarcharTest) {
+  Column col1{"a", TypeId::VARCHAR, 4096};
+  Column col2{"b", TypeId::INTEGER};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction, schema, TableFormat::PAX);
+  auto count_pages = [&]() {
+    int num_pages = 0;
+    for (page_id_t page_id = table->GetFirstPageId(); page_id != INVALID_PAGE_ID; num_pages++) {
+      auto *page = reinterpret_cast<PaxTablePage *>(buffer_pool_manager->FetchPage(page_id));
+      page_id = page->GetNextPageId();
+      buffer_pool_manager->UnpinPage(page->GetTablePageId(), false);
+    }
+    return num_pages;
+  };
+
+  // values far wider than the default varlen reserve get pages with fewer slots
+  const int num_tuples = 5;
+  for (int i = 0; i < num_tuples; ++i) {
+    Tuple tuple({ValueFactory::GetVarcharValue(std::string(3000, 'a' + i)), ValueFactory::GetIntegerValue(i)},
+                &schema);
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+  }
+  int count = 0;
+  for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+    EXPECT_EQ(itr->GetValue(&schema, 0).ToString(), std::string(3000, 'a' + count));
+    count++;
+  }
+  EXPECT_EQ(count, num_tuples);
+
+  // a tuple that fits no page aborts without linking an empty page into the table
+  int num_pages = count_pages();
+  Transaction failing(1);
+  Tuple too_wide({ValueFactory::GetVarcharValue(std::string(4040, 'z')), ValueFactory::GetIntegerValue(0)}, &schema);
+  RID rid;
+  EXPECT_FALSE(table->InsertTuple(too_wide, &rid, &failing));
+  EXPECT_EQ(failing.GetState(), TransactionState::ABORTED);
+  EXPECT_EQ(count_pages(), num_pages);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, FixedWidthTupleTest) {
+  Column col1{"a", TypeId::BOOLEAN};
+  Column col2{"b", TypeId::SMALLINT};
+  Column col3{"c", TypeId::INTEGER};
+  Column col4{"d", TypeId::BIGINT};
+  Column col5{"e", TypeId::DECIMAL};
+  Column col6{"f", TypeId::TINYINT};
+  std::vector<Column> cols{col1, col2, col3, col4, col5, col6};
+  Schema schema{cols};
+  ASSERT_TRUE(schema.IsInlined());
+
+  std::vector<Value> values{ValueFactory::GetBooleanValue(true), ValueFactory::GetSmallIntValue(-7),
+                            ValueFactory::GetIntegerValue(42),   ValueFactory::GetBigIntValue(1LL << 40),
+                            ValueFactory::GetDecimalValue(2.5),  ValueFactory::GetTinyIntValue(3)};
+  Tuple tuple(values, &schema);
+  ASSERT_EQ(tuple.GetLength(), schema.GetLength());
+
+  // the fast path lays the tuple out exactly like the per-column serialization
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    EXPECT_EQ(schema.GetColumnOffset(i), schema.GetColumn(i).GetOffset());
+    Value expected = Value::DeserializeFrom(tuple.GetData() + schema.GetColumn(i).GetOffset(), values[i].GetTypeId());
+    EXPECT_EQ(tuple.GetValue(&schema, i).CompareEquals(values[i]), CmpBool::CmpTrue);
+    EXPECT_EQ(expected.CompareEquals(values[i]), CmpBool::CmpTrue);
+  }
+  EXPECT_EQ(tuple.GetInlinedAs<int16_t>(&schema, 1), -7);
+  EXPECT_EQ(tuple.GetInlinedAs<int32_t>(&schema, 2), 42);
+  EXPECT_EQ(tuple.GetInlinedAs<int64_t>(&schema, 3), 1LL << 40);
+
+  // nulls survive the round trip
+  std::vector<Value> nulls;
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    nulls.emplace_back(ValueFactory::GetNullValueByType(schema.GetColumnType(i)));
+  }
+  Tuple null_tuple(nulls, &schema);
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    EXPECT_TRUE(null_tuple.IsNull(&schema, i));
+  }
+
+  // keys are copied byte for byte
+  std::vector<uint32_t> key_attrs{3, 2};
+  std::unique_ptr<Schema> key_schema{Schema::CopySchema(&schema, key_attrs)};
+  Tuple key = tuple.KeyFromTuple(schema, *key_schema, key_attrs);
+  ASSERT_EQ(key.GetLength(), key_schema->GetLength());
+  EXPECT_EQ(key.GetValue(key_schema.get(), 0).GetAs<int64_t>(), 1LL << 40);
+  EXPECT_EQ(key.GetValue(key_schema.get(), 1).GetAs<int32_t>(), 42);
+}
+
 }  // namespace bustub